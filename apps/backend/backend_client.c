@@ -96,7 +96,7 @@ ce_find_byid(struct client_entry *ce_list,
  * @retval     0    OK 
  * @retval    -1    Error
  */
-static int
+int
 ce_client_descr(struct client_entry *ce,
                 cbuf               **cbp)
 {
@@ -173,6 +173,42 @@ ce_event_cb(clixon_handle h,
     return retval;
 }
 
+/*! Stream callback for netconf stream notification with serialized event
+ *
+ * Same as ce_event_cb but the event is already serialized and shared by all clients
+ * @param[in]  h     Clixon handle
+ * @param[in]  data  Event serialized as XML
+ * @param[in]  len   Length of data
+ * @param[in]  arg   Extra argument provided in stream_ss_add
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see stream_ss_datafn_set
+ */
+static int
+ce_event_data_cb(clixon_handle h,
+                 const char   *data,
+                 size_t        len,
+                 void         *arg)
+{
+    int                  retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+    cbuf                *cbce = NULL;
+
+    if (ce_client_descr(ce, &cbce) < 0)
+        goto done;
+    /* A closed client socket is not an error, it is removed when read returns EOF */
+    if (send_msg_notify_data(ce->ce_s, cbuf_get(cbce), data, len) < 0)
+        goto ok; /* Error is logged, continue with other subscribers */
+    ce->ce_out_notifications++;
+    netconf_monitoring_counter_inc(h, "out-notifications");
+ ok:
+    retval = 0;
+ done:
+    if (cbce)
+        cbuf_free(cbce);
+    return retval;
+}
+
 /*! Unlock all db:s of a client and call user unlock calback 
  *
  * @param[in]  h       Clixon handle
@@ -1187,6 +1223,7 @@ from_client_create_subscription(clixon_handle h,
     struct timeval       start;
     struct timeval       stop;
     cvec                *nsc = NULL;
+    struct stream_subscription *ss;
 
     clixon_debug(CLIXON_DBG_STREAM, "");
     /* XXX should use prefix cf edit_config */
@@ -1233,9 +1270,12 @@ from_client_create_subscription(clixon_handle h,
         goto ok;
     }
     /* Add subscriber to stream - to make notifications for this client */
-    if (stream_ss_add(h, stream, selector,
-                      starttime?&start:NULL, stoptime?&stop:NULL,
-                      ce_event_cb, (void*)ce) < 0)
+    if ((ss = stream_ss_add(h, stream, selector,
+                            starttime?&start:NULL, stoptime?&stop:NULL,
+                            ce_event_cb, (void*)ce)) == NULL)
+        goto done;
+    /* Events are serialized once for all clients */
+    if (stream_ss_datafn_set(ss, ce_event_data_cb) < 0)
         goto done;
     /* Replay of this stream to specific subscription according to start and
      * stop (if present). 
@@ -1458,6 +1498,7 @@ from_client_stats(clixon_handle h,
 {
     int        retval = -1;
     uint64_t   nr;
+    uint64_t   nr2;
     char      *str;
     int        modules = 0;
     yang_stmt *yspec0;
@@ -1482,6 +1523,13 @@ from_client_stats(clixon_handle h,
     nr=0;
     yang_stats_global(&nr);
     cprintf(cbret, "<yangnr>%" PRIu64 "</yangnr>", nr);
+    nr=0;
+    xpath_parse_cache_stats(&nr, &nr2);
+    cprintf(cbret, "<xpath-cache-hits>%" PRIu64 "</xpath-cache-hits>", nr);
+    cprintf(cbret, "<xpath-cache-misses>%" PRIu64 "</xpath-cache-misses>", nr2);
+    nacm_cache_stats(&nr, &nr2);
+    cprintf(cbret, "<nacm-cache-hits>%" PRIu64 "</nacm-cache-hits>", nr);
+    cprintf(cbret, "<nacm-cache-misses>%" PRIu64 "</nacm-cache-misses>", nr2);
     cprintf(cbret, "</global>");
     cprintf(cbret, "<datastores xmlns=\"%s\">", CLIXON_LIB_NS);
     if (clixon_stats_datastore_get(h, "running", cbret) < 0)
@@ -1699,6 +1747,7 @@ from_client_msg(clixon_handle        h,
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
     yspec = clicon_dbspec_yang(h);
+    ce->ce_reply_partial = 0;
     /* Return netconf message. Should be filled in by the dispatch(sub) functions 
      * as wither rpc-error or by positive response.
      */
@@ -1857,11 +1906,12 @@ from_client_msg(clixon_handle        h,
          * 2: Permit, skip NACM
          * Therefore, xnacm=NULL means no NACM checks needed.
          */
-        if ((ret = nacm_access_pre(h, ce->ce_username, username, &xnacm, cbret)) < 0)
+        if ((ret = nacm_access_pre_cached(h, ce->ce_username, username, &xnacm, cbret)) < 0)
             goto done;
         if (ret == 2)
             goto reply;
         /* Cache XML NACM tree here. Use with caution, only valid on from_client_msg stack 
+         * xnacm points into the NACM cache, see nacm_cache_reset
          */
         if (clicon_nacm_cache_set(h, xnacm) < 0)
             goto done;
@@ -1885,6 +1935,8 @@ from_client_msg(clixon_handle        h,
         }
         clixon_err_reset();
         if ((ret = rpc_callback_call(h, xe, ce, &nr, cbret)) < 0){
+            if (ce->ce_reply_partial)
+                goto partial;
             if (netconf_operation_failed(cbret, "application", clixon_err_reason())< 0)
                 goto done;
             clixon_log(h, LOG_NOTICE, "%s Error in rpc_callback_call:%s", __FUNCTION__, xml_name(xe));
@@ -1893,6 +1945,8 @@ from_client_msg(clixon_handle        h,
             goto reply; /* Dont quit here on user callbacks */
         }
         if (ret == 0){
+            if (ce->ce_reply_partial)
+                goto partial;
             ce->ce_out_rpc_errors++;
             netconf_monitoring_counter_inc(h, "out-rpc-errors");
             goto reply;
@@ -1905,7 +1959,6 @@ from_client_msg(clixon_handle        h,
             goto reply;
         }
         if (xnacm){
-            xml_free(xnacm);
             xnacm = NULL;
             if (clicon_nacm_cache_set(h, NULL) < 0)
                 goto done;
@@ -1943,10 +1996,12 @@ from_client_msg(clixon_handle        h,
   done:
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "retval:%d", retval);
     if (xnacm){
-        xml_free(xnacm);
+        xnacm = NULL;
         if (clicon_nacm_cache_set(h, NULL) < 0)
             goto done;
     }
+    /* Request done, free NACM trees invalidated during it */
+    nacm_cache_release(h);
     if (xret)
         xml_free(xret);
     if (xt)
@@ -1961,6 +2016,19 @@ from_client_msg(clixon_handle        h,
                    __FUNCTION__, rpc?rpc:"");
     //    clixon_debug(CLIXON_DBG_BACKEND, "retval:%d", retval);
     return retval;// -1 here terminates backend
+ partial:
+    /* Part of the reply is already sent, an rpc-error cannot be appended to it.
+     * Close the session instead, the client sees a closed socket
+     */
+    clixon_log(h, LOG_WARNING, "%s: Error after partial reply of %s, closing session %u: %s",
+               __FUNCTION__, rpc, ce->ce_id, clixon_err_reason());
+    ce->ce_out_rpc_errors++;
+    netconf_monitoring_counter_inc(h, "out-rpc-errors");
+    netconf_monitoring_counter_inc(h, "dropped-sessions");
+    backend_client_rm(h, ce);
+    clixon_err_reset();
+    retval = 0;
+    goto done;
 }
 
 /*! Internal clixon message has arrived from a client. Receive and dispatch.
@@ -100,9 +100,18 @@ generic_validate(clixon_handle       h,
     int        i;
     int        ret;
     cbuf      *cb = NULL;
+    int        incr = 0;
 
-    /* All entries */
-    if ((ret = xml_yang_validate_all_top(h, td->td_target, xret)) < 0)
+#ifndef XMLDB_DIFF_MARKS /* Marked diff may be incomplete */
+    incr = clicon_option_bool(h, "CLICON_VALIDATE_UNIQUE_INCREMENTAL");
+#endif
+    /* All entries, optionally unique constraints only in lists changed by the transaction */
+    incr = xml_yang_validate_unique_incremental(incr);
+    ret = xml_yang_validate_all_top1(h, td->td_target,
+                                     clicon_option_int(h, "CLICON_VALIDATE_WORKERS"),
+                                     xret);
+    xml_yang_validate_unique_incremental(incr);
+    if (ret < 0)
         goto done;
     if (ret == 0)
         goto fail;
@@ -138,12 +147,15 @@ generic_validate(clixon_handle       h,
  *
  * @param[in]  h       Clixon handle
  * @param[in]  td      Transaction data
+ * @param[in]  marked  If set, all changes in target are marked with XML_FLAG_DIFF
  * @retval     0   OK
  * @retval    -1   Error
+ * @see xmldb_diff_marked
  */
 static int
 compute_diffs(clixon_handle       h,
-              transaction_data_t *td)
+              transaction_data_t *td,
+              int                 marked)
 {
     int    retval = -1;
     int    i;
@@ -152,16 +164,17 @@ compute_diffs(clixon_handle       h,
     /* Clear flags xpath for get */
     xml_apply0(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
                (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
-    /* 3. Compute differences */
-    if (xml_diff(td->td_src,
-                 td->td_target,
-                 &td->td_dvec,      /* removed: only in running */
-                 &td->td_dlen,
-                 &td->td_avec,      /* added: only in candidate */
-                 &td->td_alen,
-                 &td->td_scvec,     /* changed: original values */
-                 &td->td_tcvec,     /* changed: wanted values */
-                 &td->td_clen) < 0)
+    /* 3. Compute differences, only in marked subtrees if possible */
+    if (xml_diff_flag(td->td_src,
+                      td->td_target,
+                      &td->td_dvec,      /* removed: only in running */
+                      &td->td_dlen,
+                      &td->td_avec,      /* added: only in candidate */
+                      &td->td_alen,
+                      &td->td_scvec,     /* changed: original values */
+                      &td->td_tcvec,     /* changed: wanted values */
+                      &td->td_clen,
+                      marked?XML_FLAG_DIFF:0x0) < 0)
         goto done;
     if (clixon_debug_get() & CLIXON_DBG_DETAIL)
         transaction_dbg(h, CLIXON_DBG_DETAIL, td, __FUNCTION__);
@@ -357,7 +370,7 @@ startup_common(clixon_handle       h,
     /* Handcraft transition with with only add tree */
     td->td_target = xt;
     xt = NULL;
-    if (compute_diffs(h, td) < 0)
+    if (compute_diffs(h, td, 0) < 0)
         goto done;
     /* 4. Call plugin transaction start callbacks */
     if (plugin_transaction_begin_all(h, td) < 0)
@@ -565,11 +578,14 @@ validate_common(clixon_handle       h,
     int         retval = -1;
     yang_stmt  *yspec;
     int         ret;
+    int         marked;
 
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
         clixon_err(OE_FATAL, 0, "No DB_SPEC");
         goto done;
     }
+    /* Check before defaults are added below, which are not marked */
+    marked = xmldb_diff_marked(h, db);
     if (xmldb_cache_get(h, db) != NULL){
         if (xmldb_populate(h, db) < 0)
             goto done;
@@ -590,7 +606,7 @@ validate_common(clixon_handle       h,
         goto done;
     if (ret == 0)
         goto fail;
-    if (compute_diffs(h, td) < 0)
+    if (compute_diffs(h, td, marked) < 0)
         goto done;
     /* 4. Call plugin transaction start callbacks */
     if (plugin_transaction_begin_all(h, td) < 0)
@@ -1177,6 +1193,7 @@ system_only_data_add(clixon_handle h,
     if ((x = xmldb_cache_get(h, db)) != NULL){
         if (xmldb_system_only_config(h, "/", NULL, &x) < 0)
             goto done;
+        xmldb_cache_cid_reset(h, db);
     }
     else{ // XXX extra complexity
         if ((x = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
@@ -1188,6 +1205,7 @@ system_only_data_add(clixon_handle h,
             db_elmnt *de;
             if ((de = clicon_db_elmnt_get(h, db)) != NULL)
                 de->de_xml = x;
+            xmldb_cache_cid_reset(h, db);
         }
         else
             xml_free(x);
@@ -380,6 +380,36 @@ filter_xpath_again(clixon_handle h,
     return retval;
 }
 
+#ifdef BACKEND_REPLY_CHUNK
+/* Client to send get reply chunks to, see get_reply_flush */
+struct get_reply_client {
+    struct client_entry *rc_ce;    /* Client */
+    cbuf                *rc_descr; /* Client description for logging */
+};
+
+/*! Send serialized part of get reply to client as a chunk and reset buffer
+ *
+ * Marks the client so that the reply is not ended with an rpc-error on a later error
+ * @param[in]  cb   Buffer with part of reply
+ * @param[in]  arg  Client, struct get_reply_client
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon_xml2cbuf_flush
+ */
+static int
+get_reply_flush(cbuf *cb,
+                void *arg)
+{
+    struct get_reply_client *rc = (struct get_reply_client *)arg;
+
+    rc->rc_ce->ce_reply_partial = 1;
+    if (send_msg_reply_chunk(rc->rc_ce->ce_s, cbuf_get(rc->rc_descr), cbuf_get(cb), cbuf_len(cb)) < 0)
+        return -1;
+    cbuf_reset(cb);
+    return 0;
+}
+#endif /* BACKEND_REPLY_CHUNK */
+
 /*! Help function for NACM access and return message
  *
  * @param[in]  h        Clixon handle
@@ -391,24 +421,40 @@ filter_xpath_again(clixon_handle h,
  * @param[in]  username User name for NACM access
  * @param[in]  depth    Nr of levels to print, -1 is all, 0 is none
  * @param[in]  wdef     With-defaults parameter
+ * @param[in]  json     Clixon extension: encode data as JSON, see clicon_rpc_get_json
+ * @param[in]  pretty   Clixon extension: pretty-print JSON
+ * @param[in]  ce       Client entry, if set XML is sent in chunks to client (or NULL)
  * @param[out] cbret    Return xml tree, eg <rpc-reply>..., <rpc-error..
  * @retval     0        OK
  * @retval    -1        Error
+ * JSON encoding is made only on the whole tree, ie without depth, and not for
+ * report-all-tagged. Otherwise XML is returned.
+ * If ce is set, the leading part of the reply may already have been sent to the client
+ * when returning, and the remainder in cbret is sent by the caller, see BACKEND_REPLY_CHUNK
  */
 static int
-get_nacm_and_reply(clixon_handle     h,
-                   cxobj            *xret,
-                   cxobj           **xvec,
-                   size_t            xlen,
-                   char             *xpath,
-                   cvec             *nsc,
-                   char             *username,
-                   int32_t           depth,
-                   withdefaults_type wdef,
-                   cbuf             *cbret)
+get_nacm_and_reply(clixon_handle        h,
+                   cxobj               *xret,
+                   cxobj              **xvec,
+                   size_t               xlen,
+                   char                *xpath,
+                   cvec                *nsc,
+                   char                *username,
+                   int32_t              depth,
+                   withdefaults_type    wdef,
+                   int                  json,
+                   int                  pretty,
+                   struct client_entry *ce,
+                   cbuf                *cbret)
 {
     int     retval = -1;
     cxobj  *xnacm = NULL;
+    cbuf   *cbj = NULL;
+    cxobj **xvec2 = NULL;
+    size_t  xlen2 = 0;
+#ifdef BACKEND_REPLY_CHUNK
+    struct get_reply_client rc = {NULL, NULL};
+#endif
 
     /* Pre-NACM access step */
     xnacm = clicon_nacm_cache(h);
@@ -417,6 +463,42 @@ get_nacm_and_reply(clixon_handle     h,
         if (nacm_datanode_read(h, xret, xvec, xlen, username, xnacm) < 0)
             goto done;
     }
+    if (json && xret != NULL && depth == -1 && wdef != WITHDEFAULTS_REPORT_ALL_TAGGED){
+        if ((cbj = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        /* Same as clixon_xml2cbuf1 would do, but in the tree */
+        if (xml_tree_prune_wdef(xret, wdef) < 0)
+            goto done;
+        if (xml_name_set(xret, NETCONF_OUTPUT_DATA) < 0)
+            goto done;
+        if (xml_bind_special(xret, clicon_dbspec_yang(h), "/nc:get/output/data") < 0)
+            goto done;
+        if (xpath == NULL || strcmp(xpath, "/") == 0){
+            if (clixon_json2cbuf(cbj, xret, pretty, 0, 0, 0) < 0)
+                goto done;
+        }
+        else {
+            /* Objects may have been removed by NACM or with-defaults */
+            if (xpath_vec(xret, nsc, "%s", &xvec2, &xlen2, xpath) < 0)
+                goto done;
+            if (xlen2 && xml2json_cbuf_vec(cbj, xvec2, xlen2, pretty, 0) < 0)
+                goto done;
+        }
+        /* Empty result is returned as XML, client decides what it means */
+        if (cbuf_len(cbj)){
+            cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+            cprintf(cbret, "<%s xmlns:%s=\"%s\" %s:format=\"json\">",
+                    NETCONF_OUTPUT_DATA,
+                    CLIXON_LIB_PREFIX, CLIXON_LIB_NS,
+                    CLIXON_LIB_PREFIX);
+            if (xml_chardata_cbuf_append(cbret, 0, cbuf_get(cbj)) < 0)
+                goto done;
+            cprintf(cbret, "</%s></rpc-reply>", NETCONF_OUTPUT_DATA);
+            goto ok;
+        }
+    }
     cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);     /* OK */
     if (xret==NULL)
         cprintf(cbret, "<data/>");
@@ -424,12 +506,32 @@ get_nacm_and_reply(clixon_handle     h,
         if (xml_name_set(xret, NETCONF_OUTPUT_DATA) < 0)
             goto done;
         /* Top level is data, so add 1 to depth if significant */
+#ifdef BACKEND_REPLY_CHUNK
+        if (ce != NULL){
+            rc.rc_ce = ce;
+            if (ce_client_descr(ce, &rc.rc_descr) < 0)
+                goto done;
+            if (clixon_xml2cbuf_flush(cbret, xret, 0, 0, NULL, depth>0?depth+1:depth, 0, wdef,
+                                      BACKEND_REPLY_CHUNK, get_reply_flush, &rc) < 0)
+                goto done;
+        }
+        else
+#endif
         if (clixon_xml2cbuf1(cbret, xret, 0, 0, NULL, depth>0?depth+1:depth, 0, wdef) < 0)
             goto done;
     }
     cprintf(cbret, "</rpc-reply>");
+ ok:
     retval = 0;
  done:
+#ifdef BACKEND_REPLY_CHUNK
+    if (rc.rc_descr)
+        cbuf_free(rc.rc_descr);
+#endif
+    if (xvec2)
+        free(xvec2);
+    if (cbj)
+        cbuf_free(cbj);
     return retval;
 }
 
@@ -905,7 +1007,7 @@ get_list_pagination(clixon_handle        h,
             cbuf_free(cba);
     }
 #endif /* LIST_PAGINATION_REMAINING */
-    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef, cbret) < 0)
+    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef, 0, 0, NULL, cbret) < 0)
         goto done;
  ok:
     retval = 0;
@@ -968,6 +1070,8 @@ get_common(clixon_handle        h,
     cxobj            *xlpg2 = NULL;
     withdefaults_type wdef;
     char             *wdefstr;
+    int               json = 0;
+    int               pretty = 0;
 
     clixon_debug(CLIXON_DBG_BACKEND | CLIXON_DBG_DETAIL, "");
     wdef = WITHDEFAULTS_EXPLICIT;
@@ -1010,6 +1114,11 @@ get_common(clixon_handle        h,
             goto ok;
         }
     }
+    /* Clixon extensions: format and pretty, see clicon_rpc_get_json */
+    if ((attr = xml_find_value(xe, "format")) != NULL && strcmp(attr, "json") == 0)
+        json = 1;
+    if ((attr = xml_find_value(xe, "pretty")) != NULL && strcmp(attr, "true") == 0)
+        pretty = 1;
     if ((wdefstr = xml_find_body(xe, "with-defaults")) != NULL)
         wdef = withdefaults_str2int(wdefstr);
     /* How to check if list-pagination?
@@ -1158,7 +1267,8 @@ get_common(clixon_handle        h,
         goto done;
     if (filter_xpath_again(h, yspec, xret, xvec, xlen, xpath, nsc) < 0)
         goto done;
-    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef, cbret) < 0)
+    if (get_nacm_and_reply(h, xret, xvec, xlen, xpath, nsc, username, depth, wdef,
+                           json, pretty, ce, cbret) < 0)
         goto done;
  ok:
     retval = 0;
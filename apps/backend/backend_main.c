@@ -128,6 +128,8 @@ backend_terminate(clixon_handle h)
     clixon_process_delete_all(h); 
 
     xpath_optimize_exit();
+    xpath_parse_cache_exit();
+    nacm_cache_exit(h);
     clixon_pagination_free(h);
     
     if (pidfile)
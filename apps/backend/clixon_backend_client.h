@@ -73,6 +73,7 @@ struct client_entry{
     uint32_t              ce_in_bad_rpcs;    /* Not correct <rpc> messages */
     uint32_t              ce_out_rpc_errors; /*  <rpc-error> messages*/
     uint32_t              ce_out_notifications; /* Outgoing notifications */
+    int                   ce_reply_partial; /* Part of current reply is sent, see BACKEND_REPLY_CHUNK */
 };
 typedef struct client_entry client_entry;
 
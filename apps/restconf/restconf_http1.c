@@ -362,11 +362,13 @@ restconf_http1_path_root(clixon_handle  h,
     char                 *subject = NULL;
     cxobj                *xerr = NULL;
     int                   pretty;
+    struct timeval        t0;
 #ifdef HAVE_LIBNGHTTP2
     int                   ret;
 #endif
 
     clixon_debug(CLIXON_DBG_RESTCONF, "------------");
+    gettimeofday(&t0, NULL);
     pretty = restconf_pretty_get(h);
     if ((sd = restconf_stream_find(rc, 0)) == NULL){
         clixon_err(OE_RESTCONF, EINVAL, "No stream_data");
@@ -467,6 +469,7 @@ restconf_http1_path_root(clixon_handle  h,
     if (sd->sd_code)
         if (restconf_http1_reply(rc, sd) < 0)
             goto done;
+    restconf_native_stats_request(h, &t0);
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_RESTCONF, "retval:%d", retval);
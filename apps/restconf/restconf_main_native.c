@@ -124,8 +124,13 @@
 #include <pwd.h>
 #include <ctype.h>
 #include <signal.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <time.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
+#include <sys/wait.h>
 #include <arpa/inet.h>
 #include <sys/resource.h>
 
@@ -159,7 +164,6 @@
 #endif
 
 #ifndef SOCK_NONBLOCK
-#include <fcntl.h>
 #define SOCK_NONBLOCK O_NONBLOCK
 #endif
 
@@ -181,6 +185,11 @@
 /* Cert verify depth: dont know what to set here? */
 #define VERIFY_DEPTH 5
 
+/* Max restart delay in seconds of a restconf worker that exits. The delay is doubled
+ * each time a worker exits within this time after being started, see CLICON_RESTCONF_WORKERS
+ */
+#define RESTCONF_WORKER_BACKOFF_MAX 32
+
 static int             session_id_context = 1;
 
 /*! Set restconf native handle
@@ -533,6 +542,7 @@ restconf_accept_client(int   fd,
 {
     int              retval = -1;
     restconf_socket *rsock;
+    restconf_native_handle *rn;
     clixon_handle    h;
     int              s = -1;
     struct sockaddr  from = {0,};
@@ -548,6 +558,9 @@ restconf_accept_client(int   fd,
     h = rsock->rs_h;
     len = sizeof(from);
     if ((s = accept(rsock->rs_ss, &from, &len)) < 0){
+        /* With several workers, another worker may have accepted it */
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            goto ok;
         clixon_err(OE_UNIX, errno, "accept");
         goto done;
     }
@@ -582,10 +595,13 @@ restconf_accept_client(int   fd,
                  rsock->rs_addrstr,
                  rsock->rs_port);
     clicon_data_set(h, "session-source-host", rsock->rs_from_addr);
+    if ((rn = restconf_native_handle_get(h)) != NULL)
+        rn->rn_conns++;
     /* Accept SSL */
     if (restconf_ssl_accept_client(h, s, rsock, NULL) < 0)
         goto done;
     s = -1;
+ ok:
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_RESTCONF, "retval:%d", retval);
@@ -596,44 +612,56 @@ restconf_accept_client(int   fd,
     return retval;
 } /* restconf_accept_client */
 
+/*! Close connections of a restconf socket, remove it from native handle and free it
+ *
+ * @param[in]  rn     Restconf native handle
+ * @param[in]  rsock  Restconf socket
+ */
+static int
+restconf_native_socket_free(restconf_native_handle *rn,
+                            restconf_socket        *rsock)
+{
+    restconf_conn *rc;
+
+    while ((rc = rsock->rs_conns) != NULL){
+        if (rc->rc_s != -1){
+            clixon_event_unreg_fd(rc->rc_s, restconf_connection);
+            close(rc->rc_s);
+        }
+        DELQ(rc, rsock->rs_conns, restconf_conn *);
+        restconf_close_ssl_socket(rc, __FUNCTION__, 0);
+    }
+    if (rsock->rs_callhome){
+        restconf_callhome_timer_unreg(rsock);
+    }
+    else if (rsock->rs_ss != -1){
+        clixon_event_unreg_fd(rsock->rs_ss, restconf_accept_client);
+        close(rsock->rs_ss);
+    }
+    DELQ(rsock, rn->rn_sockets, restconf_socket *);
+    if (rsock->rs_description)
+        free(rsock->rs_description);
+    if (rsock->rs_addrstr)
+        free(rsock->rs_addrstr);
+    if (rsock->rs_addrtype)
+        free(rsock->rs_addrtype);
+    if (rsock->rs_from_addr)
+        free(rsock->rs_from_addr);
+    free(rsock);
+    return 0;
+}
+
 /*!
  */
 static int
 restconf_native_terminate(clixon_handle h)
 {
     restconf_native_handle *rn;
-    restconf_socket        *rsock;
-    restconf_conn          *rc;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "");
     if ((rn = restconf_native_handle_get(h)) != NULL){
-        while ((rsock = rn->rn_sockets) != NULL){
-            while ((rc = rsock->rs_conns) != NULL){
-                if (rc->rc_s != -1){
-                    clixon_event_unreg_fd(rc->rc_s, restconf_connection);
-                    close(rc->rc_s);
-                }
-                DELQ(rc, rsock->rs_conns, restconf_conn *);
-                restconf_close_ssl_socket(rc, __FUNCTION__, 0);
-            }
-            if (rsock->rs_callhome){
-                restconf_callhome_timer_unreg(rsock);
-            }
-            else if (rsock->rs_ss != -1){
-                clixon_event_unreg_fd(rsock->rs_ss, restconf_accept_client);
-                close(rsock->rs_ss);
-            }
-            DELQ(rsock, rn->rn_sockets, restconf_socket *);
-            if (rsock->rs_description)
-                free(rsock->rs_description);
-            if (rsock->rs_addrstr)
-                free(rsock->rs_addrstr);
-            if (rsock->rs_addrtype)
-                free(rsock->rs_addrtype);
-            if (rsock->rs_from_addr)
-                free(rsock->rs_from_addr);
-            free(rsock);
-        }
+        while (rn->rn_sockets != NULL)
+            restconf_native_socket_free(rn, rn->rn_sockets);
         if (rn->rn_ctx)
             SSL_CTX_free(rn->rn_ctx);
         free(rn);
@@ -1131,6 +1159,300 @@ restconf_sig_term(int arg)
     clixon_exit_set(1);
 }
 
+/*! Log connection and request statistics of this process
+ *
+ * @param[in]  h    Clixon handle
+ */
+static int
+restconf_worker_stats_log(clixon_handle h)
+{
+    restconf_native_handle *rn;
+
+    if ((rn = restconf_native_handle_get(h)) == NULL)
+        return 0;
+    clixon_log(h, LOG_INFO, "%s worker %d pid %u: connections: %" PRIu64 " requests: %" PRIu64
+               " avg latency: %" PRIu64 " us",
+               __PROGRAM__, rn->rn_worker, getpid(), rn->rn_conns, rn->rn_requests,
+               rn->rn_requests ? rn->rn_latency/rn->rn_requests : 0);
+    return 0;
+}
+
+/* XXX Need global variables for SIGUSR1 signal handlers
+ */
+static volatile sig_atomic_t _restconf_stats_pending = 0;
+static volatile sig_atomic_t _restconf_stats_forward = 0;
+
+/* Pipe written by SIGUSR1 handler to wake up event loop, see restconf_stats_pipe_init */
+static int _restconf_stats_pipe[2] = {-1, -1};
+
+/*! Signal requests statistics of this process to be logged from the event loop
+ *
+ * Only async-signal-safe calls are made here, logging is made in restconf_stats_cb
+ * Also continue event loop that is interrupted by the signal
+ */
+static void
+restconf_sig_stats(int arg)
+{
+    int err = errno;
+
+    _restconf_stats_pending = 1;
+    if (_restconf_stats_pipe[1] != -1 &&
+        write(_restconf_stats_pipe[1], "", 1) < 0)
+        ; /* Pipe full, a wakeup is pending anyway */
+    clicon_sig_ignore_set(1);
+    errno = err;
+}
+
+/*! Event loop callback of stats pipe, log statistics if requested by SIGUSR1
+ *
+ * @param[in]  s    Read end of stats pipe
+ * @param[in]  arg  Clixon handle
+ * @retval     0    OK
+ */
+static int
+restconf_stats_cb(int   s,
+                  void *arg)
+{
+    clixon_handle h = (clixon_handle)arg;
+    char          buf[64];
+
+    while (read(s, buf, sizeof(buf)) > 0)
+        ;
+    if (_restconf_stats_pending){
+        _restconf_stats_pending = 0;
+        restconf_worker_stats_log(h);
+    }
+    return 0;
+}
+
+/*! Create stats pipe of this process and register it in the event loop
+ *
+ * A pipe inherited from a parent is closed, since it is shared with the parent and its
+ * other children
+ * @param[in]  h    Clixon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+restconf_stats_pipe_init(clixon_handle h)
+{
+    int i;
+
+    if (_restconf_stats_pipe[0] != -1){
+        clixon_event_unreg_fd(_restconf_stats_pipe[0], restconf_stats_cb);
+        close(_restconf_stats_pipe[0]);
+        close(_restconf_stats_pipe[1]);
+        _restconf_stats_pipe[0] = _restconf_stats_pipe[1] = -1;
+    }
+    if (pipe(_restconf_stats_pipe) < 0){
+        clixon_err(OE_UNIX, errno, "pipe");
+        return -1;
+    }
+    for (i=0; i<2; i++)
+        if (fcntl(_restconf_stats_pipe[i], F_SETFL, O_NONBLOCK) < 0 ||
+            fcntl(_restconf_stats_pipe[i], F_SETFD, FD_CLOEXEC) < 0){
+            clixon_err(OE_UNIX, errno, "fcntl");
+            return -1;
+        }
+    if (clixon_event_reg_fd(_restconf_stats_pipe[0], restconf_stats_cb, h, "restconf stats") < 0)
+        return -1;
+    return 0;
+}
+
+/*! Signal to parent of restconf workers, forward to workers in restconf_workers_run
+ */
+static void
+restconf_sig_stats_forward(int arg)
+{
+    _restconf_stats_forward = 1;
+}
+
+/*! Close backend socket, a new socket and session is made on next rpc
+ *
+ * Used when forking workers, which otherwise would share the socket
+ * @param[in]  h    Clixon handle
+ */
+static int
+restconf_backend_close(clixon_handle h)
+{
+    int s;
+
+    if ((s = clicon_client_socket_get(h)) >= 0){
+        close(s);
+        clicon_client_socket_set(h, -1);
+    }
+    clicon_session_id_del(h);
+    return 0;
+}
+
+/*! Fork a restconf worker process
+ *
+ * The worker inherits the listening sockets, and gets its own backend session.
+ * Only the first worker keeps callhome sockets, to not make several callhome connections.
+ * @param[in]  h       Clixon handle
+ * @param[in]  worker  Worker number
+ * @param[out] pid     Process id of worker (in parent)
+ * @retval     1       In worker process
+ * @retval     0       In parent process
+ * @retval    -1       Error
+ */
+static int
+restconf_worker_fork(clixon_handle h,
+                     int           worker,
+                     pid_t        *pid)
+{
+    restconf_native_handle *rn;
+    restconf_socket        *rsock;
+    restconf_socket        *rsock1;
+
+    if ((*pid = fork()) < 0){
+        clixon_err(OE_UNIX, errno, "fork");
+        return -1;
+    }
+    if (*pid != 0)
+        return 0;
+    /* Worker */
+    if (restconf_stats_pipe_init(h) < 0)
+        return -1;
+    if (set_signal(SIGTERM, restconf_sig_term, NULL) < 0 ||
+        set_signal(SIGINT, restconf_sig_term, NULL) < 0 ||
+        set_signal(SIGUSR1, restconf_sig_stats, NULL) < 0){
+        clixon_err(OE_DAEMON, errno, "Setting signal");
+        return -1;
+    }
+    if ((rn = restconf_native_handle_get(h)) == NULL){
+        clixon_err(OE_XML, EFAULT, "No openssl handle");
+        return -1;
+    }
+    rn->rn_worker = worker;
+    if (worker > 0 && (rsock = rn->rn_sockets) != NULL){
+        do {
+            rsock1 = NEXTQ(restconf_socket *, rsock);
+            if (rsock->rs_callhome){
+                restconf_native_socket_free(rn, rsock);
+                if (rn->rn_sockets == NULL)
+                    break;
+            }
+            rsock = rsock1;
+        } while (rsock != rn->rn_sockets);
+    }
+    clixon_debug(CLIXON_DBG_RESTCONF, "worker %d started", worker);
+    return 1;
+}
+
+/*! Fork restconf worker processes and wait for them, restart workers that exit
+ *
+ * Returns in the parent when it is terminated, after terminating the workers.
+ * A worker that exits soon after being started is restarted with an exponential
+ * backoff, up to RESTCONF_WORKER_BACKOFF_MAX seconds.
+ * SIGUSR1 to the parent is forwarded to the workers, which log their statistics.
+ * @param[in]  h         Clixon handle
+ * @param[in]  nworkers  Number of workers
+ * @retval     1         In worker process, continue to event loop
+ * @retval     0         In parent process, all workers have exited
+ * @retval    -1         Error
+ * @see CLICON_RESTCONF_WORKERS
+ */
+static int
+restconf_workers_run(clixon_handle h,
+                     int           nworkers)
+{
+    int          retval = -1;
+    pid_t       *pids = NULL;
+    time_t      *started = NULL; /* Start time of each worker */
+    int         *backoff = NULL; /* Restart delay of each worker in seconds */
+    pid_t        pid;
+    int          status;
+    int          i;
+    int          ret;
+    unsigned int t;
+
+    if ((pids = calloc(nworkers, sizeof(*pids))) == NULL ||
+        (started = calloc(nworkers, sizeof(*started))) == NULL ||
+        (backoff = calloc(nworkers, sizeof(*backoff))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    /* Workers create their own backend sessions */
+    restconf_backend_close(h);
+    for (i=0; i<nworkers; i++){
+        if ((ret = restconf_worker_fork(h, i, &pids[i])) < 0)
+            goto done;
+        if (ret == 1)
+            goto worker;
+        started[i] = time(NULL);
+    }
+    /* Wake up from waitpid on termination */
+    if (set_signal_flags(SIGTERM, 0, restconf_sig_term, NULL) < 0 ||
+        set_signal_flags(SIGINT, 0, restconf_sig_term, NULL) < 0 ||
+        set_signal_flags(SIGUSR1, 0, restconf_sig_stats_forward, NULL) < 0){
+        clixon_err(OE_DAEMON, errno, "Setting signal");
+        goto done;
+    }
+    clixon_log(h, LOG_NOTICE, "%s: %u started %d workers", __PROGRAM__, getpid(), nworkers);
+    while (!clixon_exit_get()){
+        if ((pid = waitpid(-1, &status, 0)) < 0){
+            if (errno == EINTR){
+                if (_restconf_stats_forward){
+                    _restconf_stats_forward = 0;
+                    for (i=0; i<nworkers; i++)
+                        if (pids[i] > 0)
+                            kill(pids[i], SIGUSR1);
+                }
+                continue;
+            }
+            clixon_err(OE_UNIX, errno, "waitpid");
+            goto done;
+        }
+        for (i=0; i<nworkers; i++)
+            if (pids[i] == pid)
+                break;
+        if (i == nworkers)
+            continue;
+        pids[i] = 0;
+        if (clixon_exit_get())
+            break;
+        /* Double delay if worker exited soon after start, eg on a persistent error */
+        if (time(NULL) - started[i] < RESTCONF_WORKER_BACKOFF_MAX)
+            backoff[i] = backoff[i] ? 2*backoff[i] : 1;
+        else
+            backoff[i] = 0;
+        if (backoff[i] > RESTCONF_WORKER_BACKOFF_MAX)
+            backoff[i] = RESTCONF_WORKER_BACKOFF_MAX;
+        clixon_log(h, LOG_WARNING, "%s: worker %d pid %u exited with status %d, restarting in %d s",
+                   __PROGRAM__, i, pid, WEXITSTATUS(status), backoff[i]);
+        /* Sleep is interrupted by signals, eg termination */
+        t = backoff[i];
+        while (t > 0 && !clixon_exit_get())
+            t = sleep(t);
+        if (clixon_exit_get())
+            break;
+        if ((ret = restconf_worker_fork(h, i, &pids[i])) < 0)
+            goto done;
+        if (ret == 1)
+            goto worker;
+        started[i] = time(NULL);
+    }
+    for (i=0; i<nworkers; i++)
+        if (pids[i] > 0)
+            kill(pids[i], SIGTERM);
+    for (i=0; i<nworkers; i++)
+        if (pids[i] > 0)
+            waitpid(pids[i], &status, 0);
+    retval = 0;
+ done:
+    if (pids)
+        free(pids);
+    if (started)
+        free(started);
+    if (backoff)
+        free(backoff);
+    return retval;
+ worker:
+    retval = 1;
+    goto done;
+}
+
 /*! Usage help routine
  *
  * @param[in]  argv0  command line
@@ -1188,6 +1510,7 @@ main(int    argc,
     int                     print_version = 0;
     int                     stream_timeout = 0;
     int32_t                 d;
+    int                     nworkers;
 
     /* Create handle */
     if ((h = restconf_handle_init()) == NULL)
@@ -1403,9 +1726,24 @@ main(int    argc,
      */
     clicon_data_set(h, "session-transport", "cl:restconf");
 
+    /* Log statistics on SIGUSR1, see restconf_worker_stats_log */
+    if (restconf_stats_pipe_init(h) < 0)
+        goto done;
+    if (set_signal(SIGUSR1, restconf_sig_stats, NULL) < 0){
+        clixon_err(OE_DAEMON, errno, "Setting signal");
+        goto done;
+    }
+    /* Fork worker processes sharing the listening sockets */
+    if ((nworkers = clicon_option_int(h, "CLICON_RESTCONF_WORKERS")) > 1){
+        if ((ret = restconf_workers_run(h, nworkers)) < 0)
+            goto done;
+        if (ret == 0) /* Parent, workers have exited */
+            goto ok;
+    }
     /* Main event loop */
     if (clixon_event_loop(h) < 0)
         goto done;
+    restconf_worker_stats_log(h);
  ok:
     retval = 0;
  done:
@@ -209,13 +209,24 @@ api_data_get2(clixon_handle  h,
     }
 
     clixon_debug(CLIXON_DBG_RESTCONF, "path:%s", xpath);
-    if ((ret = clicon_rpc_get(h, xpath, nsc, content, depth, defaults, &xret)) < 0){
+    if ((cbx = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    if (media_out == YANG_DATA_JSON)
+        /* Backend encodes JSON directly, if not, xret is set as with XML */
+        ret = clicon_rpc_get_json(h, xpath, nsc, content, depth, defaults, pretty, cbx, &xret);
+    else
+        ret = clicon_rpc_get(h, xpath, nsc, content, depth, defaults, &xret);
+    if (ret < 0){
         if (netconf_operation_failed_xml(&xerr, "protocol", clixon_err_reason()) < 0)
             goto done;
         if (api_return_err0(h, req, xerr, pretty, media_out, 0) < 0)
             goto done;
         goto ok;
     }
+    if (xret == NULL)
+        goto reply;
     /* We get return via netconf which is complete tree from root
      * We need to cut that tree to only the object.
      */
@@ -230,10 +241,6 @@ api_data_get2(clixon_handle  h,
         goto ok;
     }
     /* Normal return, no error */
-    if ((cbx = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
     if (xpath==NULL || strcmp(xpath,"/")==0){ /* Special case: data root */
         switch (media_out){
         case YANG_DATA_XML:
@@ -296,6 +303,7 @@ api_data_get2(clixon_handle  h,
             break;
         }
     }
+ reply:
     clixon_debug(CLIXON_DBG_RESTCONF, "cbuf:%s", cbuf_get(cbx));
     if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(media_out)) < 0)
         goto done;
@@ -942,6 +942,30 @@ restconf_native_handle_get(clixon_handle h)
     return NULL;
 }
 
+/*! Add request to statistics of this process
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  t0    Time when request processing started
+ * @retval     0     OK
+ * @see restconf_worker_stats_log
+ */
+int
+restconf_native_stats_request(clixon_handle   h,
+                              struct timeval *t0)
+{
+    restconf_native_handle *rn;
+    struct timeval          t1;
+    struct timeval          t;
+
+    if ((rn = restconf_native_handle_get(h)) != NULL){
+        gettimeofday(&t1, NULL);
+        timersub(&t1, t0, &t);
+        rn->rn_requests++;
+        rn->rn_latency += t.tv_sec*1000000 + t.tv_usec;
+    }
+    return 0;
+}
+
 /*---------------------------- Connect ---------------------------------*/
 
 /*! New data connection after accept, receive and reply on data socket
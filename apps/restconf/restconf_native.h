@@ -167,6 +167,10 @@ typedef struct {
     SSL_CTX         *rn_ctx;       /* SSL context */
     restconf_socket *rn_sockets;   /* List of restconf server (ready for accept) sockets */
     void            *rn_arg;       /* Packet specific handle */
+    int              rn_worker;    /* Worker number, see CLICON_RESTCONF_WORKERS */
+    uint64_t         rn_conns;     /* Number of accepted connections */
+    uint64_t         rn_requests;  /* Number of requests */
+    uint64_t         rn_latency;   /* Sum of request processing time in us */
 } restconf_native_handle;
 
 /*
@@ -186,6 +190,7 @@ int               restconf_connection(int s, void *arg);
 int               restconf_ssl_accept_client(clixon_handle h, int s, restconf_socket *rsock, restconf_conn  **rcp);
 int               restconf_callhome_timer_unreg(restconf_socket *rsock);
 int               restconf_callhome_timer(restconf_socket *rsock, int status);
+int               restconf_native_stats_request(clixon_handle h, struct timeval *t0);
 int               restconf_socket_extract(clixon_handle h, cxobj *xs, cvec *nsc, restconf_socket *rsock,
                                           char **namespace, char **address, char **addrtype, uint16_t *port);
 
@@ -302,8 +302,10 @@ restconf_nghttp2_path(restconf_stream_data *sd)
     char          *oneline = NULL;
     cvec          *cvv = NULL;
     char          *cn;
+    struct timeval t0;
 
     clixon_debug(CLIXON_DBG_RESTCONF, "------------");
+    gettimeofday(&t0, NULL);
     rc = sd->sd_conn;
     if ((h = rc->rc_h) == NULL){
         clixon_err(OE_RESTCONF, EINVAL, "arg is NULL");
@@ -358,6 +360,7 @@ restconf_nghttp2_path(restconf_stream_data *sd)
     /* Clear (fcgi) paramaters from this request */
     if (restconf_param_del_all(h) < 0)
         goto done;
+    restconf_native_stats_request(h, &t0);
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_RESTCONF, "retval:%d", retval);
@@ -55,6 +55,14 @@
  */
 #define XPATH_LIST_OPTIMIZE
 
+/*! Cache parsed XPath trees in xpath_vec_ctx, value is max number of cached trees
+ *
+ * XPaths are parsed once and kept in an LRU cache keyed by the XPath string, for example
+ * must and when statements evaluated for every list entry in validation.
+ * @see xpath_parse_cache_stats
+ */
+#define XPATH_PARSE_CACHE 1024
+
 /*! Add explicit search indexes, so that binary search can be made for non-key list indexes
  *
  * This also applies if there are multiple keys and you want to search on only the second for 
@@ -195,6 +203,16 @@
  */
 #undef YANG_SPEC_LINENR
 
+/*! Index children of YANG statements with more than this number of children
+ *
+ * yang_find, yang_find_datanode and yang_find_schemanode use a hash index over the
+ * children argument instead of a linear scan. The index is built on first lookup and
+ * reset when children are modified.
+ * Increases memory with 8 bytes per yang-stmt.
+ * Undefine to always use linear search.
+ */
+#define YANG_FIND_INDEX 32
+
 /*! Effort to clear system-only config data from candidate cache after commit
  *
  * The idea was that the candidate would be re-loaded from file and populated (as running)
@@ -244,3 +262,42 @@
  * If no problem with patch, remove at next release
  */
 #define STARTUP_COMMIT_REORDER
+
+/*! Allocate XML objects from slabs instead of one malloc per object
+ *
+ * Elements and body/attribute objects are allocated from separate fixed-size slabs of 64K
+ * chunks, which removes per-object malloc overhead and makes xml_free of large trees cheaper.
+ * Disabled by ./configure --disable-xml-slab, eg when hunting XML memory errors with valgrind,
+ * since objects in a slab are not individually tracked. Objects are then allocated with
+ * malloc and freed with free.
+ */
+#ifndef CLIXON_XML_NO_SLAB
+#define XML_SLAB_ALLOC
+#endif
+
+/*! Commit diffs only descend into subtrees changed since candidate was synced with running
+ *
+ * xmldb_put marks changes with XML_FLAG_DIFF, and compute_diffs skips unmarked subtrees
+ * if the marks are known to be complete, see xmldb_diff_marked.
+ * Experimental, disabled by default: defaults added by xmldb_populate, eg due to when
+ * statements elsewhere in the tree, are not marked, and are then missing from the
+ * transaction diff.
+ * If undefined, xmldb_put and xmldb_copy do not set or clear any marks.
+ */
+#undef XMLDB_DIFF_MARKS
+
+/*! Use epoll for file descriptor events in the event loop, if available
+ *
+ * File descriptors are registered in epoll once, and each event loop iteration only
+ * handles ready descriptors. Descriptors not supported by epoll, eg regular files, are
+ * polled as before. Undefine to poll all file descriptors.
+ */
+#define EVENT_EPOLL
+
+/*! Send large get replies from backend to clients in chunks of this size
+ *
+ * The reply is serialized and sent as NETCONF 1.1 chunks while the tree is traversed,
+ * so the reply text is never held in memory in full.
+ * Undefine to build the complete reply before sending it.
+ */
+#define BACKEND_REPLY_CHUNK (256*1024)
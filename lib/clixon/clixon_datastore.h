@@ -56,6 +56,12 @@ struct db_elmnt {
                                  */
     int            de_empty;    /* Empty on read from file, xmldb_readfile and xmldb_put sets it */
     int            de_volatile; /* Disable auto-sync of cache to disk on every update (ie xmldb_put) */
+    uint64_t       de_cid;      /* Content id of cache: two caches with the same non-zero id are
+                                 * equal. Set by xmldb_copy, reset when cache may be modified */
+    uint64_t       de_diffcid;  /* Running content id when XML_FLAG_DIFF marks were last cleared.
+                                 * If equal to running de_cid, the marks cover all changes */
+    int            de_journal;  /* Number of records in journal file, see CLICON_XMLDB_JOURNAL
+                                 * -1 if datastore file is not synced with cache */
 };
 typedef struct db_elmnt db_elmnt;
 
@@ -67,6 +73,7 @@ db_elmnt *clicon_db_elmnt_get(clixon_handle h, const char *db);
 int clicon_db_elmnt_set(clixon_handle h, const char *db, db_elmnt *xc);
 int xmldb_db2file(clixon_handle h, const char *db, char **filename);
 int xmldb_db2subdir(clixon_handle h, const char *db, char **dir);
+int xmldb_db2journal(clixon_handle h, const char *db, char **filename);
 
 /* API */
 int xmldb_connect(clixon_handle h);
@@ -96,6 +103,8 @@ int xmldb_create(clixon_handle h, const char *db);
 /* utility functions */
 int xmldb_db_reset(clixon_handle h, const char *db);
 cxobj *xmldb_cache_get(clixon_handle h, const char *db);
+void   xmldb_cache_cid_reset(clixon_handle h, const char *db);
+int xmldb_diff_marked(clixon_handle h, const char *db);
 int xmldb_modified_get(clixon_handle h, const char *db);
 int xmldb_modified_set(clixon_handle h, const char *db, int value);
 int xmldb_empty_get(clixon_handle h, const char *db);
@@ -39,13 +39,16 @@
 #define _CLIXON_HASH_H_
 
 struct clicon_hash {
-    qelem_t     h_qelem;
-    char       *h_key;  /* Key must be NULL-terinated string */
-    size_t      h_vlen;
-    void       *h_val;
+    qelem_t             h_qelem; /* List of all entries in table, insertion order */
+    struct clicon_hash *h_next;  /* Next in bucket chain */
+    uint32_t            h_hash;  /* Hash value of key */
+    char               *h_key;   /* Key must be NULL-terinated string */
+    size_t              h_vlen;
+    void               *h_val;
 };
 typedef struct clicon_hash *clicon_hash_t;
 
+uint32_t       clicon_hash_fnv1a(const char *str);
 clicon_hash_t *clicon_hash_init (void);
 int            clicon_hash_free (clicon_hash_t *);
 clicon_hash_t  clicon_hash_lookup (clicon_hash_t *head, const char *key);
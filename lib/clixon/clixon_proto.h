@@ -76,6 +76,8 @@ int clixon_rpc10(int sock, const char *descr, cbuf *msgin, cbuf *msgret, int *eo
 int clixon_msg_rcv11(int s, const char *descr, int intr, cbuf **cb, int *eof);
 int clicon_rpc(int sock, const char *descr, struct clicon_msg *msg, char **xret, int *eof);
 int send_msg_reply(int s, const char *descr, char *data, uint32_t datalen);
+int send_msg_reply_chunk(int s, const char *descr, char *data, size_t datalen);
+int send_msg_notify_data(int s, const char *descr, const char *data, size_t datalen);
 int send_msg_notify_xml(clixon_handle h, int s, const char *descr, cxobj *xev);
 
 #endif  /* _CLIXON_PROTO_H_ */
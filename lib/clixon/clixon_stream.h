@@ -55,21 +55,36 @@
  */
 typedef int (*stream_fn_t)(clixon_handle h, int op, cxobj *event, void *arg);
 
+/*! Subscription callback with serialized event
+ *
+ * @param[in]  h     Clicon handle
+ * @param[in]  data  Event serialized as XML, shared by all subscriptions
+ * @param[in]  len   Length of data
+ * @param[in]  arg   Extra argument provided in stream_ss_add
+ * @see stream_ss_datafn_set
+ */
+typedef int (*stream_data_fn_t)(clixon_handle h, const char *data, size_t len, void *arg);
+
+/* Compiled subscription filter, shared by subscriptions with same filter */
+struct stream_filter;
+
 struct stream_subscription{
     qelem_t                     ss_q;   /* queue header */
     char                       *ss_stream; /* Name of associated stream */
     char                       *ss_xpath;  /* Filter selector as xpath */
+    struct stream_filter       *ss_filter; /* Compiled ss_xpath, NULL if no filter */
     struct timeval              ss_starttime; /* Replay starttime */
     struct timeval              ss_stoptime; /* Replay stoptime */
     stream_fn_t                 ss_fn;     /* Callback when event occurs */
+    stream_data_fn_t            ss_datafn; /* If set, called with serialized event instead of ss_fn */
     void                       *ss_arg;    /* Callback argument */
 };
 
-/* Replay time-series */
+/* Replay time-series record, in ring buffer ordered by time */
 struct stream_replay{
-    qelem_t        r_q;   /* queue header */
-    struct timeval r_tv;  /* time index */
-    cxobj         *r_xml; /* event in xml form */
+    struct timeval r_tv;   /* time index */
+    char          *r_data; /* event serialized as xml, malloced */
+    size_t         r_len;  /* length of r_data */
 };
 
 /* See RFC8040 9.3, stream list, no replay support for now
@@ -79,10 +94,17 @@ struct event_stream{
     char                *es_name; /* name of notification event stream */
     char                *es_description;
     struct stream_subscription *es_subscription;
+    struct stream_filter *es_filters; /* Distinct filters of subscriptions */
+    uint64_t             es_event_nr; /* Number of events, to mark filter match results */
     int                  es_replay_enabled; /* set if replay is enables */
     struct timeval       es_retention; /* replay retention - how much to save */
-    struct stream_replay *es_replay;
-
+    struct stream_replay *es_replay;   /* replay ring buffer, vector of es_replay_max */
+    size_t               es_replay_max;   /* allocated length of es_replay */
+    size_t               es_replay_head;  /* index of oldest record */
+    size_t               es_replay_nr;    /* number of records */
+    size_t               es_replay_bytes; /* sum of record lengths */
+    size_t               es_replay_maxnr; /* max number of records, 0: no limit */
+    size_t               es_replay_maxbytes; /* max sum of record lengths, 0: no limit */
 };
 typedef struct event_stream event_stream_t;
 
@@ -103,8 +125,10 @@ struct stream_subscription *stream_ss_find(event_stream_t *es,
                                            stream_fn_t fn, void *arg);
 int stream_ss_delete_all(clixon_handle h, stream_fn_t fn, void *arg);
 int stream_ss_delete(clixon_handle h, char *name, stream_fn_t fn, void *arg);
+int stream_ss_datafn_set(struct stream_subscription *ss, stream_data_fn_t datafn);
 
 int stream_notify_xml(clixon_handle h, char *stream, cxobj *xml);
+int stream_notify_data(clixon_handle h, char *stream, const char *event);
 int stream_notify(clixon_handle h, char *stream, const char *event, ...)  __attribute__ ((format (printf, 3, 4)));
 
 /* Replay */
@@ -43,6 +43,7 @@
 /*
  * Prototypes
  */
+int xml_yang_validate_unique_incremental(int enable);
 int xml_yang_validate_minmax(cxobj *xt, int presence, cxobj **xret);
 int xml_duplicate_detect(cxobj *xt, int rm, cxobj **xret);
 
@@ -191,7 +191,8 @@ enum format_enum{
     FORMAT_CLI,
     FORMAT_NETCONF,  /* Last concrete format, used in code */
     FORMAT_DEFAULT,  /* Indirect: actual value in CLICON_CLI_OUTPUT_FORMAT */
-    FORMAT_PIPE_XML_DEFAULT /* Meta: If pipe, xml, if not default */
+    FORMAT_PIPE_XML_DEFAULT, /* Meta: If pipe, xml, if not default */
+    FORMAT_BINARY    /* Datastore only: binary snapshot, see CLICON_XMLDB_FORMAT */
 };
 
 /*
@@ -210,6 +211,8 @@ enum format_enum{
 #define XML_FLAG_ANYDATA  0x200 /* Treat as anydata, eg mount-points before bound */
 #define XML_FLAG_CACHE_DIRTY 0x400 /* This part of XML tree is not synced to disk */
 #define XML_FLAG_SKIP      0x800 /* Node is skipped in xml_diff */
+#define XML_FLAG_DIFF     0x1000 /* Datastore node changed since last sync with running,
+                                  * see xmldb_diff_marked */
 
 /*
  * Prototypes
@@ -40,6 +40,12 @@
 #ifndef _CLIXON_XML_IO_H_
 #define _CLIXON_XML_IO_H_
 
+/*
+ * Types
+ */
+/* Consume, ie write and reset, a buffer of serialized XML, see clixon_xml2cbuf_flush */
+typedef int (clixon_cbuf_flush_cb)(cbuf *cb, void *arg);
+
 /*
  * Prototypes
  */
@@ -50,10 +56,14 @@ int   clixon_xml2file(FILE *f, cxobj *xn, int level, int pretty, char *prefix, c
 int   clixon_xml2file_multi(clixon_handle h, const char *db, cxobj *xn, int level, int pretty,
                             char *prefix, clicon_output_cb *fn, int skiptop, int autocliext,
                             withdefaults_type wdef);
+int   xml_tree_prune_wdef(cxobj *xt, withdefaults_type wdef);
 int   xml_print(FILE *f, cxobj *xn);
 int   xml_dump(FILE  *f, cxobj *x);
 int   clixon_xml2cbuf1(cbuf *cb, cxobj *x, int level, int prettyprint, char *prefix,
                        int32_t depth, int skiptop, withdefaults_type wdef);
+int   clixon_xml2cbuf_flush(cbuf *cb, cxobj *xn, int level, int pretty, char *prefix,
+                            int32_t depth, int skiptop, withdefaults_type wdef,
+                            size_t chunk, clixon_cbuf_flush_cb *fn, void *arg);
 int   clixon_xml2cbuf(cbuf *cb, cxobj *x, int level, int prettyprint, char *prefix, int32_t depth, 
 int skiptop);
 int   xmltree2cbuf(cbuf *cb, cxobj *x, int level);
@@ -61,6 +71,8 @@ int   clixon_xml_parse_file(FILE *f, yang_bind yb, yang_stmt *yspec, cxobj **xt,
 int   clixon_xml_parse_string(const char *str, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
 int   clixon_xml_parse_va(yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr,
                         const char *format, ...)  __attribute__ ((format (printf, 5, 6)));
+int   clixon_xml2binary_file(FILE *f, cxobj *xn, withdefaults_type wdef, int system_only);
+int   clixon_xml_parse_binary_file(FILE *fp, cxobj **xt);
 int   clixon_xml_attr_copy(cxobj *xin, cxobj *xout, char *name);
 int   clixon_xml_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1);
 
@@ -297,6 +297,7 @@ yang_stmt *ydomain_new(clixon_handle h, char *domain);
 yang_stmt *ys_new(enum rfc_6020 keyw);
 yang_stmt *ys_prune(yang_stmt *yp, int i);
 int        ys_prune_self(yang_stmt *ys);
+int        yang_index_reset(yang_stmt *ys);
 int        ys_free1(yang_stmt *ys, int self);
 int        ys_free(yang_stmt *ys);
 int        ys_cp_one(yang_stmt *nw, yang_stmt *old);
@@ -42,6 +42,7 @@
 #endif
 
 #include <stdlib.h>
+#include <inttypes.h>
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
@@ -81,11 +82,19 @@
 #include "clixon_xml_bind.h"
 #include "clixon_xml_default.h"
 #include "clixon_xml_io.h"
+#include "clixon_xml_map.h"
 #include "clixon_json.h"
+#include "clixon_nacm.h"
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
 
+/*
+ * Variables
+ */
+/* Last content id given to a datastore cache, see de_cid */
+static uint64_t _xmldb_cid = 0;
+
 /*! Get xml database element including id, xml cache, empty on startup and dirty bit
  *
  * @param[in]  h    Clixon handle
@@ -192,6 +201,44 @@ xmldb_db2file(clixon_handle  h,
     return xmldb_db2file1(h, db, clicon_option_bool(h, "CLICON_XMLDB_MULTI"), filename);
 }
 
+/*! Translate from symbolic database name to journal filename
+ *
+ * @param[in]   h        Clixon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @param[out]  filename Filename. Unallocate after use with free()
+ * @retval      0        OK
+ * @retval     -1        Error
+ * @see CLICON_XMLDB_JOURNAL
+ */
+int
+xmldb_db2journal(clixon_handle h,
+                 const char   *db,
+                 char        **filename)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    char *dir;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if ((dir = clicon_xmldb_dir(h)) == NULL){
+        clixon_err(OE_XML, errno, "CLICON_XMLDB_DIR not set");
+        goto done;
+    }
+    cprintf(cb, "%s/%s_db.journal", dir, db);
+    if ((*filename = strdup4(cbuf_get(cb))) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 /*! Translate from symbolic database name to sub-directory of configure sub-files, no checks
  *
  * @param[in]   h       Clixon handle
@@ -271,6 +318,8 @@ xmldb_disconnect(clixon_handle h)
                 xml_free(de->de_xml);
                 de->de_xml = NULL;
             }
+            de->de_cid = 0;
+            de->de_diffcid = 0;
         }
     retval = 0;
  done:
@@ -329,6 +378,51 @@ check_create_multidir(clixon_handle h,
     return retval;
 }
 
+#ifdef XMLDB_DIFF_MARKS
+/*! Clear XML_FLAG_DIFF marks, only descend marked nodes
+ *
+ * @param[in]  x    XML node
+ * @param[in]  arg  Not used
+ * @retval     2    Not marked, skip subtree
+ * @retval     0    OK, continue
+ */
+static int
+xmldb_diff_reset(cxobj *x,
+                 void  *arg)
+{
+    if (xml_flag(x, XML_FLAG_DIFF) == 0)
+        return 2;
+    xml_flag_reset(x, XML_FLAG_DIFF);
+    return 0;
+}
+#endif /* XMLDB_DIFF_MARKS */
+
+/*! Check if NACM config differs between two datastore trees
+ *
+ * @param[in]  x0   Datastore top, or NULL
+ * @param[in]  x1   Datastore top, or NULL
+ * @retval     1    Differs, or unknown since a tree is not in cache
+ * @retval     0    Equal
+ * @see nacm_cache_reset
+ */
+static int
+xmldb_nacm_changed(cxobj *x0,
+                   cxobj *x1)
+{
+    cxobj *xn0;
+    cxobj *xn1;
+
+    if (x0 == NULL || x1 == NULL)
+        return 1;
+    xn0 = xml_find_type(x0, NULL, "nacm", CX_ELMNT);
+    xn1 = xml_find_type(x1, NULL, "nacm", CX_ELMNT);
+    if (xn0 == NULL && xn1 == NULL)
+        return 0;
+    if (xn0 == NULL || xn1 == NULL)
+        return 1;
+    return xml_tree_equal(xn0, xn1) != 0;
+}
+
 /*! Copy datastore from db1 to db2, both cache and datastore
  *
  * May include copying datastore directory structure
@@ -353,8 +447,12 @@ xmldb_copy(clixon_handle h,
     cxobj      *x2 = NULL;  /* to */
     char       *fromdir = NULL;
     char       *todir = NULL;
+    char       *tojournal = NULL;
 
     clixon_debug(CLIXON_DBG_DATASTORE, "%s %s", from, to);
+    /* Files are copied below, first fold any edits in journal into file */
+    if (xmldb_journal_compact(h, from) < 0)
+        goto done;
     /* XXX lock */
     /* Copy in-memory cache */
     /* 1. "to" xml tree in x1 */
@@ -362,9 +460,18 @@ xmldb_copy(clixon_handle h,
         x1 = de1->de_xml;
     if ((de2 = clicon_db_elmnt_get(h, to)) != NULL)
         x2 = de2->de_xml;
+    /* Cached NACM config of running is only reset if NACM changes */
+    if (strcmp(to, "running") == 0 &&
+        xmldb_nacm_changed(x1, x2) &&
+        nacm_cache_reset(h) < 0)
+        goto done;
     if (x1 == NULL && x2 == NULL){
         /* do nothing */
     }
+    else if (x1 && x2 && de1->de_cid != 0 && de1->de_cid == de2->de_cid){
+        /* Caches are unmodified since last copy, eg discard-changes without edits */
+        clixon_debug(CLIXON_DBG_DATASTORE, "%s and %s equal, skip cache copy", from, to);
+    }
     else if (x1 == NULL){  /* free x2 and set to NULL */
         xml_free(x2);
         x2 = NULL;
@@ -391,6 +498,28 @@ xmldb_copy(clixon_handle h,
     if (de2)
         de0 = *de2;
     de0.de_xml = x2; /* The new tree */
+    /* Mark both caches with same content id */
+    if (x1){
+        if (de1->de_cid == 0)
+            de1->de_cid = ++_xmldb_cid;
+        de0.de_cid = de1->de_cid;
+    }
+    else
+        de0.de_cid = 0;
+    /* Caches synced with running start a new diff journal, see xmldb_diff_marked */
+    if (x1 && (strcmp(from, "running") == 0 || strcmp(to, "running") == 0)){
+#ifdef XMLDB_DIFF_MARKS
+        if (xml_apply(x1, CX_ELMNT, xmldb_diff_reset, NULL) < 0)
+            goto done;
+        if (x2 != x1 && xml_apply(x2, CX_ELMNT, xmldb_diff_reset, NULL) < 0)
+            goto done;
+#endif
+        de1->de_diffcid = de1->de_cid;
+        de0.de_diffcid = de0.de_cid;
+    }
+    else
+        de0.de_diffcid = 0;
+    de0.de_journal = 0;
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
         if (check_create_multidir(h, to) < 0)
             goto done;
@@ -405,6 +534,12 @@ xmldb_copy(clixon_handle h,
         goto done;
     if (clicon_file_copy(fromfile, tofile) < 0)
         goto done;
+    if (xmldb_db2journal(h, to, &tojournal) < 0)
+        goto done;
+    if (unlink(tojournal) < 0 && errno != ENOENT){
+        clixon_err(OE_UNIX, errno, "unlink(%s)", tojournal);
+        goto done;
+    }
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")) {
         if (xmldb_db2subdir(h, from, &fromdir) < 0)
             goto done;
@@ -420,6 +555,8 @@ xmldb_copy(clixon_handle h,
         free(fromdir);
     if (todir)
         free(todir);
+    if (tojournal)
+        free(tojournal);
     if (fromfile)
         free(fromfile);
     if (tofile)
@@ -605,6 +742,8 @@ xmldb_clear(clixon_handle h,
             xml_free(xt);
             de->de_xml = NULL;
         }
+        de->de_cid = 0;
+        de->de_diffcid = 0;
         de->de_modified = 0;
         de->de_id = 0;
         memset(&de->de_tv, 0, sizeof(struct timeval));
@@ -636,6 +775,8 @@ xmldb_delete(clixon_handle h,
     char          *regexp = NULL;
 
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "%s", db);
+    if (strcmp(db, "running") == 0 && nacm_cache_reset(h) < 0)
+        goto done;
     if (xmldb_clear(h, db) < 0)
         goto done;
     if (xmldb_db2file(h, db, &filename) < 0)
@@ -645,6 +786,14 @@ xmldb_delete(clixon_handle h,
             clixon_err(OE_DB, errno, "truncate %s", filename);
             goto done;
         }
+    free(filename);
+    filename = NULL;
+    if (xmldb_db2journal(h, db, &filename) < 0)
+        goto done;
+    if (unlink(filename) < 0 && errno != ENOENT){
+        clixon_err(OE_UNIX, errno, "unlink(%s)", filename);
+        goto done;
+    }
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
         if (xmldb_db2subdir(h, db, &subdir) < 0)
             goto done;
@@ -697,11 +846,15 @@ xmldb_create(clixon_handle h,
     cxobj      *xt = NULL;
 
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "%s", db);
+    if (strcmp(db, "running") == 0 && nacm_cache_reset(h) < 0)
+        goto done;
     if ((de = clicon_db_elmnt_get(h, db)) != NULL){
         if ((xt = de->de_xml) != NULL){
             xml_free(xt);
             de->de_xml = NULL;
         }
+        de->de_cid = 0;
+        de->de_diffcid = 0;
     }
     if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
         if (check_create_multidir(h, db) < 0)
@@ -750,6 +903,7 @@ xmldb_db_reset(clixon_handle h,
  * @param[in]  db   Database name
  * @retval     xml  XML cached tree or NULL
  * @see xmldb_get_cache  Read from store if miss
+ * @note A caller modifying the cache content in place should call xmldb_cache_cid_reset
  */
 cxobj *
 xmldb_cache_get(clixon_handle h,
@@ -762,6 +916,54 @@ xmldb_cache_get(clixon_handle h,
     return de->de_xml;
 }
 
+/*! Datastore cache is modified in place, it is no longer equal to any copy
+ *
+ * Called by code modifying a cache tree directly, not via xmldb_put or xmldb_copy, so
+ * that a later xmldb_copy does not skip copying the modified cache
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Database name
+ * @note Not necessary for yang binding and defaults, see xmldb_populate, which are derived
+ *       from the content
+ */
+void
+xmldb_cache_cid_reset(clixon_handle h,
+                      const char   *db)
+{
+    db_elmnt *de;
+
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+        de->de_cid = 0;
+}
+
+/*! Check if all changes of a datastore relative to running are marked with XML_FLAG_DIFF
+ *
+ * The marks are cleared when a cache is copied to or from running. Thereafter xmldb_put
+ * marks added, deleted and changed nodes and their ancestors.
+ * If so, the diff against running need only descend into marked nodes.
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Database name
+ * @retval     1    Yes, all changes since running are marked
+ * @retval     0    No, or unknown, a full diff is necessary
+ * @see xml_diff_flag
+ */
+int
+xmldb_diff_marked(clixon_handle h,
+                  const char   *db)
+{
+#ifdef XMLDB_DIFF_MARKS
+    db_elmnt *de;
+    db_elmnt *der;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL || de->de_xml == NULL)
+        return 0;
+    if ((der = clicon_db_elmnt_get(h, "running")) == NULL || der->de_xml == NULL)
+        return 0;
+    return der->de_cid != 0 && de->de_diffcid == der->de_cid;
+#else
+    return 0;
+#endif
+}
+
 /*! Get modified flag from datastore
  *
  * @param[in]  h     Clixon handle
@@ -921,6 +1123,8 @@ xmldb_print(clixon_handle h,
         fprintf(f, "  Session:  %u\n", de->de_id);
         fprintf(f, "  XML:      %p\n", de->de_xml);
         fprintf(f, "  Modified: %d\n", de->de_modified);
+        fprintf(f, "  Cid:      %" PRIu64 "\n", de->de_cid);
+        fprintf(f, "  Diffcid:  %" PRIu64 "\n", de->de_diffcid);
         fprintf(f, "  Empty:    %d\n", de->de_empty);
     }
     retval = 0;
@@ -955,6 +1159,9 @@ xmldb_rename(clixon_handle h,
         goto done;
     if (newdb == NULL && suffix == NULL)        // no-op
         goto done;
+    /* File is renamed below, first fold any edits in journal into file */
+    if (xmldb_journal_compact(h, db) < 0)
+        goto done;
     if ((cb = cbuf_new()) == NULL){
         clixon_err(OE_XML, errno, "cbuf_new");
         goto done;
@@ -1078,6 +1285,14 @@ xmldb_drop_priv(clixon_handle h,
         clixon_err(OE_UNIX, errno, "chown %s", filename);
         goto done;
     }
+    free(filename);
+    filename = NULL;
+    if (xmldb_db2journal(h, db, &filename) < 0)
+        goto done;
+    if (chown(filename, uid, gid) < 0 && errno != ENOENT){
+        clixon_err(OE_UNIX, errno, "chown %s", filename);
+        goto done;
+    }
     retval = 0;
  done:
     if (filename)
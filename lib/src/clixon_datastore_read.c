@@ -83,6 +83,7 @@
 #include "clixon_xml_nsctx.h"
 #include "clixon_datastore.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_write.h"
 
 #define handle(xh) (assert(text_handle_check(xh)==0),(struct text_handle *)(xh))
 
@@ -569,6 +570,7 @@ xmldb_readfile(clixon_handle    h,
     cxobj           *x;
     yang_stmt       *yspec1 = NULL;
     struct xmldb_multi_read_arg mr = {0, };
+    int              nr = 0;
 
     if (yb != YB_MODULE && yb != YB_NONE){
         clixon_err(OE_XML, EINVAL, "yb is %d but should be module or none", yb);
@@ -610,6 +612,16 @@ xmldb_readfile(clixon_handle    h,
         if (clixon_xml_parse_file(fp, YB_NONE, yspec, &x0, xerr) < 0)
             goto done;
         break;
+    case FORMAT_BINARY:
+        if ((ret = clixon_xml_parse_binary_file(fp, &x0)) < 0)
+            goto done;
+        /* Not a binary snapshot, eg written before format was changed, try XML */
+        if (ret == 0){
+            clixon_debug(CLIXON_DBG_DATASTORE, "%s not binary, reading as XML", dbfile);
+            if (clixon_xml_parse_file(fp, YB_NONE, yspec, &x0, xerr) < 0)
+                goto done;
+        }
+        break;
     default:
         clixon_err(OE_DB, 0, "Format %s not supported", formatstr);
         goto done;
@@ -735,6 +747,11 @@ xmldb_readfile(clixon_handle    h,
         if (xml_sort_recurse(x0) < 0)
             goto done;
     }
+    /* Replay edits appended to journal after datastore file was written */
+    if ((ret = xmldb_journal_replay(h, db, x0, yspec1?yspec1:yspec, yb, &nr)) < 0)
+        goto done;
+    if (de)
+        de->de_journal = ret?nr:-1;
     if (xp){
         *xp = x0;
         x0 = NULL;
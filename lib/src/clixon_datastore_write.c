@@ -1359,6 +1359,355 @@ xml_mark_cache_dirty(cxobj *x,
     return 2;
 }
 
+#ifdef XMLDB_DIFF_MARKS
+/*! Mark changed xml with XML_FLAG_DIFF for incremental diffs, see xmldb_diff_marked
+ *
+ * Added nodes, and nodes with deleted children, are marked in the whole subtree since
+ * defaults may also have been added there. Changed ancestors are marked themselves.
+ * @param[in]  x    XML node
+ * @param[in]  arg  Not used
+ * @retval     2    Locally abort this subtree, continue with others
+ * @retval     0    OK, continue
+ * @retval    -1    Error
+ */
+static int
+xml_mark_diff(cxobj *x,
+              void  *arg)
+{
+    if (xml_flag(x, XML_FLAG_ADD|XML_FLAG_DEL)){
+        xml_flag_set(x, XML_FLAG_DIFF);
+        if (xml_apply(x, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_DIFF) < 0)
+            return -1;
+    }
+    else if (xml_flag(x, XML_FLAG_CHANGE)){
+        xml_flag_set(x, XML_FLAG_DIFF);
+        return 0;
+    }
+    return 2;
+}
+#endif /* XMLDB_DIFF_MARKS */
+
+/*! Print datastore file identity used to detect a journal not belonging to the file
+ *
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Symbolic database name
+ * @param[out] cb   Buffer to print identity to
+ * @retval     1    OK
+ * @retval     0    Datastore file does not exist
+ * @retval    -1    Error
+ */
+static int
+xmldb_journal_id(clixon_handle h,
+                 const char   *db,
+                 cbuf         *cb)
+{
+    int         retval = -1;
+    char       *dbfile = NULL;
+    struct stat st = {0,};
+
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+        goto done;
+    if (stat(dbfile, &st) < 0){
+        retval = 0;
+        goto done;
+    }
+    /* Nanoseconds since a rewrite within the same second may reuse inode and size */
+    cprintf(cb, "clixon-journal %ju %jd %jd.%09ld\n",
+            (uintmax_t)st.st_ino, (intmax_t)st.st_size,
+            (intmax_t)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec);
+    retval = 1;
+ done:
+    if (dbfile)
+        free(dbfile);
+    return retval;
+}
+
+/*! Serialize an edit as a journal record payload
+ *
+ * The namespace context of x1 is declared on the config element since
+ * prefixes may be declared by ancestors, such as nc:operation in the rpc
+ * @param[in]  x1   Modification tree, top-level is config
+ * @param[out] cb   Buffer to print payload to
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_journal_edit2cbuf(cxobj *x1,
+                        cbuf  *cb)
+{
+    int     retval = -1;
+    cvec   *nsc = NULL;
+    cg_var *cv;
+    char   *prefix;
+    cxobj  *x;
+
+    if (xml_nsctx_node(x1, &nsc) < 0)
+        goto done;
+    cprintf(cb, "<%s", NETCONF_INPUT_CONFIG);
+    cv = NULL;
+    while ((cv = cvec_each(nsc, cv)) != NULL){
+        if ((prefix = cv_name_get(cv)) == NULL)
+            cprintf(cb, " xmlns=\"%s\"", cv_string_get(cv));
+        else
+            cprintf(cb, " xmlns:%s=\"%s\"", prefix, cv_string_get(cv));
+    }
+    cprintf(cb, ">");
+    x = NULL;
+    while ((x = xml_child_each(x1, x, CX_ELMNT)) != NULL)
+        if (clixon_xml2cbuf(cb, x, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+    cprintf(cb, "</%s>", NETCONF_INPUT_CONFIG);
+    retval = 0;
+ done:
+    if (nsc)
+        xml_nsctx_free(nsc);
+    return retval;
+}
+
+/*! Append an edit record to the datastore journal and sync it to disk
+ *
+ * Record format: "<operation> <length>\n<payload>\n"
+ * The journal starts with a line identifying the datastore file it applies to.
+ * @param[in]  h    Clixon handle
+ * @param[in]  db   Symbolic database name
+ * @param[in]  op   Top-level operation of edit
+ * @param[in]  cbj  Record payload, see xmldb_journal_edit2cbuf
+ * @retval     1    OK, record appended
+ * @retval     0    Journal not available, write datastore file instead
+ * @retval    -1    Error
+ */
+static int
+xmldb_journal_append(clixon_handle       h,
+                     const char         *db,
+                     enum operation_type op,
+                     cbuf               *cbj)
+{
+    int         retval = -1;
+    char       *jfile = NULL;
+    cbuf       *cb = NULL;
+    int         fd = -1;
+    struct stat st = {0,};
+    char       *p;
+    size_t      len;
+    ssize_t     n;
+    int         ret;
+
+    if (xmldb_db2journal(h, db, &jfile) < 0)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if ((fd = open(jfile, O_WRONLY|O_APPEND|O_CREAT, S_IRUSR|S_IWUSR)) < 0){
+        /* Eg no permission to create files in xmldb dir */
+        clixon_debug(CLIXON_DBG_DATASTORE, "open(%s): %s", jfile, strerror(errno));
+        retval = 0;
+        goto done;
+    }
+    if (fstat(fd, &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat(%s)", jfile);
+        goto done;
+    }
+    if (st.st_size == 0){
+        if ((ret = xmldb_journal_id(h, db, cb)) < 0)
+            goto done;
+        if (ret == 0){
+            retval = 0;
+            goto done;
+        }
+    }
+    cprintf(cb, "%s %zu\n%s\n", xml_operation2str(op), cbuf_len(cbj), cbuf_get(cbj));
+    p = cbuf_get(cb);
+    len = cbuf_len(cb);
+    while (len > 0){
+        if ((n = write(fd, p, len)) < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "write(%s)", jfile);
+            goto done;
+        }
+        p += n;
+        len -= n;
+    }
+    if (fsync(fd) < 0){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", jfile);
+        goto done;
+    }
+    retval = 1;
+ done:
+    if (fd != -1)
+        close(fd);
+    if (cb)
+        cbuf_free(cb);
+    if (jfile)
+        free(jfile);
+    return retval;
+}
+
+/*! Replay datastore journal on an XML tree read from the datastore file
+ *
+ * A journal not belonging to the datastore file, eg left by an interrupted compaction,
+ * is removed. An incomplete last record, eg from a crash during append, is truncated.
+ * @param[in]  h      Clixon handle
+ * @param[in]  db     Symbolic database name
+ * @param[in]  x0     XML tree read from datastore file, top-level is config
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  yb     How x0 is bound, if YB_NONE it is bound before first record is replayed
+ * @param[out] nrp    Number of records replayed
+ * @retval     1      OK
+ * @retval     0      Journal not, or not fully, replayed since x0 or a record could
+ *                    not be bound to yang
+ * @retval    -1      Error
+ * @see CLICON_XMLDB_JOURNAL
+ */
+int
+xmldb_journal_replay(clixon_handle h,
+                     const char   *db,
+                     cxobj        *x0,
+                     yang_stmt    *yspec,
+                     yang_bind     yb,
+                     int          *nrp)
+{
+    int                 retval = -1;
+    char               *jfile = NULL;
+    FILE               *f = NULL;
+    cbuf               *cb = NULL;
+    cbuf               *cbret = NULL;
+    char                line[128];
+    char                opstr[16];
+    size_t              len;
+    char               *payload = NULL;
+    long                pos;
+    enum operation_type op;
+    cxobj              *xt = NULL;
+    cxobj              *xc;
+    int                 nr = 0;
+    int                 bindfail = 0;
+    int                 ret;
+
+    if (xmldb_db2journal(h, db, &jfile) < 0)
+        goto done;
+    if ((f = fopen(jfile, "r+")) == NULL){
+        if (errno == ENOENT)
+            goto ok;
+        clixon_err(OE_UNIX, errno, "fopen(%s)", jfile);
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL || (cbret = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if ((ret = xmldb_journal_id(h, db, cb)) < 0)
+        goto done;
+    if (ret == 0 ||
+        fgets(line, sizeof(line), f) == NULL ||
+        strcmp(line, cbuf_get(cb)) != 0){
+        clixon_debug(CLIXON_DBG_DATASTORE, "Removing stale journal %s", jfile);
+        if (unlink(jfile) < 0){
+            clixon_err(OE_UNIX, errno, "unlink(%s)", jfile);
+            goto done;
+        }
+        goto ok;
+    }
+    pos = ftell(f);
+    while (fgets(line, sizeof(line), f) != NULL){
+        if (sscanf(line, "%15s %zu", opstr, &len) != 2 ||
+            xml_operation(opstr, &op) < 0)
+            break;
+        if ((payload = malloc(len + 1)) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        if (fread(payload, 1, len + 1, f) != len + 1 || payload[len] != '\n')
+            break; /* Incomplete record */
+        payload[len] = '\0';
+        if (yb == YB_NONE){
+            if ((ret = xml_bind_yang(h, x0, YB_MODULE, yspec, NULL)) < 0)
+                goto done;
+            if (ret == 0){
+                clixon_log(h, LOG_WARNING, "%s: journal of %s not replayed: yang binding failed",
+                           __FUNCTION__, db);
+                goto fail;
+            }
+            if (xml_sort_recurse(x0) < 0)
+                goto done;
+            yb = YB_MODULE;
+        }
+        if (clixon_xml_parse_string(payload, YB_NONE, yspec, &xt, NULL) < 0)
+            goto done;
+        if ((xc = xml_find_type(xt, NULL, NETCONF_INPUT_CONFIG, CX_ELMNT)) != NULL){
+            if ((ret = xml_bind_yang(h, xc, YB_MODULE, yspec, NULL)) < 0)
+                goto done;
+            if (ret == 0){
+                /* Skip record but replay the rest, file is rewritten since journal is
+                 * reported as not replayed */
+                clixon_log(h, LOG_WARNING, "%s: journal record %d of %s not replayed: yang binding failed",
+                           __FUNCTION__, nr, db);
+                bindfail++;
+                goto next;
+            }
+            if (xml_sort_recurse(xc) < 0)
+                goto done;
+            cbuf_reset(cbret);
+            if ((ret = text_modify_top(h, x0, xc, yspec, op, NULL, NULL, 1, cbret)) < 0)
+                goto done;
+            if (ret == 0)
+                clixon_log(h, LOG_WARNING, "%s: journal record %d of %s failed: %s",
+                           __FUNCTION__, nr, db, cbuf_get(cbret));
+            /* Same post-processing as xmldb_put, defaults are added by caller */
+            if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) < 0)
+                goto done;
+            if (xml_apply(x0, CX_ELMNT, xml_mark_added_ancestors, (void*)(XML_FLAG_ADD|XML_FLAG_DEL)) < 0)
+                goto done;
+            if (xml_default_nopresence(x0, 3, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
+                goto done;
+            if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+                          (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE)) < 0)
+                goto done;
+        }
+ next:
+        xml_free(xt);
+        xt = NULL;
+        free(payload);
+        payload = NULL;
+        nr++;
+        pos = ftell(f);
+    }
+    /* Remove incomplete record so that new records are appended after the last complete */
+    if (!feof(f) || pos != ftell(f)){
+        clixon_log(h, LOG_WARNING, "%s: truncating incomplete journal record %d of %s",
+                   __FUNCTION__, nr, db);
+        if (ftruncate(fileno(f), pos) < 0){
+            clixon_err(OE_UNIX, errno, "ftruncate(%s)", jfile);
+            goto done;
+        }
+    }
+    clixon_debug(CLIXON_DBG_DATASTORE, "Replayed %d journal records of %s", nr, db);
+    if (bindfail)
+        goto fail;
+ ok:
+    if (nrp)
+        *nrp = nr;
+    retval = 1;
+ done:
+    if (xt)
+        xml_free(xt);
+    if (payload)
+        free(payload);
+    if (cb)
+        cbuf_free(cb);
+    if (cbret)
+        cbuf_free(cbret);
+    if (f)
+        fclose(f);
+    if (jfile)
+        free(jfile);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Modify database given an xml tree and an operation
  *
  * @param[in]  h      CLICON handle
@@ -1403,6 +1752,9 @@ xmldb_put(clixon_handle       h,
     cvec       *nsc = NULL; /* nacm namespace context */
     int         firsttime = 0;
     cxobj      *xerr = NULL;
+    cbuf       *cbj = NULL; /* journal record */
+    int         journal = 0;
+    int         nacmreset = 0;
 
     clixon_debug(CLIXON_DBG_DATASTORE|CLIXON_DBG_DETAIL, "db %s", db);
     if (cbret == NULL){
@@ -1418,9 +1770,9 @@ xmldb_put(clixon_handle       h,
                    xml_name(x1), NETCONF_INPUT_CONFIG);
         goto done;
     }
-    if ((de = clicon_db_elmnt_get(h, db)) != NULL){
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
         x0 = de->de_xml; /* XXX flag is not XML_FLAG_TOP */
-    }
+    xmldb_cache_cid_reset(h, db); /* Cache is modified */
     /* If there is no xml x0 tree (in cache), then read it from file */
     if (x0 == NULL){
         firsttime++; /* to avoid leakage on error, see fail from text_modify */
@@ -1443,6 +1795,22 @@ xmldb_put(clixon_handle       h,
         goto done;
     }
     /* Here x0 looks like: <config>...</config> */
+    /* Serialize edit for journal before x1 is modified */
+    if (x1 && clicon_option_int(h, "CLICON_XMLDB_JOURNAL") > 0 &&
+        !clicon_option_bool(h, "CLICON_XMLDB_MULTI") &&
+        xmldb_volatile_get(h, db) == 0 &&
+        (de == NULL || de->de_journal >= 0)){
+        if ((cbj = cbuf_new()) == NULL){
+            clixon_err(OE_XML, errno, "cbuf_new");
+            goto done;
+        }
+        if (xmldb_journal_edit2cbuf(x1, cbj) < 0)
+            goto done;
+    }
+    /* Edit may change NACM config in running, checked before x1 is modified */
+    if (strcmp(db, "running") == 0 &&
+        (x1 == NULL || op == OP_REPLACE || xml_find_type(x1, NULL, "nacm", CX_ELMNT) != NULL))
+        nacmreset++;
     xnacm = clicon_nacm_cache(h);
     permit = (xnacm==NULL);
     /* Here assume if xnacm is set and !permit do NACM */
@@ -1487,6 +1855,11 @@ xmldb_put(clixon_handle       h,
      */
     if (xml_default_recurse(x0, 0, XML_FLAG_ADD|XML_FLAG_DEL) < 0)
         goto done;
+#endif
+#ifdef XMLDB_DIFF_MARKS
+    /* Mark changes relative to running, after defaults have been added */
+    if (xml_apply(x0, CX_ELMNT, xml_mark_diff, NULL) < 0)
+        goto done;
 #endif
     /* Write back to datastore cache if first time */
     if (de != NULL)
@@ -1497,14 +1870,26 @@ xmldb_put(clixon_handle       h,
     clicon_db_elmnt_set(h, db, &de0);
     /* Write cache to file unless volatile (ie stop syncing to store) */
     if (xmldb_volatile_get(h, db) == 0){
-        if (xmldb_write_cache2file(h, db) < 0)
+        /* Append edit to journal instead of writing whole file, if enabled */
+        if (cbj && (journal = xmldb_journal_append(h, db, op, cbj)) < 0)
             goto done;
+        if (journal && (de = clicon_db_elmnt_get(h, db)) != NULL)
+            de->de_journal++;
+        /* Write whole file which also compacts the journal */
+        if (journal == 0 ||
+            de->de_journal >= clicon_option_int(h, "CLICON_XMLDB_JOURNAL")){
+            if (xmldb_write_cache2file(h, db) < 0)
+                goto done;
+        }
         /* Clear flags from previous steps + dirty */
         if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
                       (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE|XML_FLAG_CACHE_DIRTY)) < 0)
             goto done;
     }
     else {
+        /* Datastore file no longer synced with cache */
+        if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+            de->de_journal = -1;
         /* Clear flags from previous steps */
         if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
                       (void*)(XML_FLAG_NONE|XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE)) < 0)
@@ -1513,6 +1898,17 @@ xmldb_put(clixon_handle       h,
     retval = 1;
  done:
     clixon_debug(CLIXON_DBG_DATASTORE | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    /* On failure, cache may be partially modified without diff marks or journal record */
+    if (retval != 1 && (de = clicon_db_elmnt_get(h, db)) != NULL){
+        de->de_diffcid = 0;
+        de->de_journal = -1;
+    }
+    /* Also on failure since running may be partially modified.
+     * Reset is lazy since xnacm above may point into the cached NACM tree */
+    if (nacmreset)
+        nacm_cache_reset(h);
+    if (cbj)
+        cbuf_free(cbj);
     if (xerr)
         xml_free(xerr);
     if (nsc)
@@ -1669,6 +2065,16 @@ xmldb_dump(clixon_handle     h,
                              clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG")) < 0)
             goto done;
         break;
+    case FORMAT_BINARY:
+        if (multi){
+            clixon_err(OE_CFG, errno, "Binary+multi not supported");
+            goto done;
+        }
+        /* pretty is ignored */
+        if (clixon_xml2binary_file(f, xt, wdef,
+                                   clicon_option_bool(h, "CLICON_XMLDB_SYSTEM_ONLY_CONFIG")) < 0)
+            goto done;
+        break;
     default:
         clixon_err(OE_XML, 0, "Format %s not supported", format_int2str(format));
         goto done;
@@ -1682,20 +2088,66 @@ xmldb_dump(clixon_handle     h,
     return retval;
 }
 
+/*! Sync directory of a file, eg after rename
+ *
+ * @param[in]  file  Filename
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xmldb_dir_fsync(const char *file)
+{
+    int   retval = -1;
+    char *dir = NULL;
+    char *p;
+    int   fd = -1;
+
+    if ((dir = strdup(file)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((p = strrchr(dir, '/')) == NULL)
+        strcpy(dir, ".");
+    else if (p == dir)
+        p[1] = '\0';
+    else
+        *p = '\0';
+    if ((fd = open(dir, O_RDONLY)) < 0){
+        clixon_err(OE_UNIX, errno, "open(%s)", dir);
+        goto done;
+    }
+    if (fsync(fd) < 0){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", dir);
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (fd != -1)
+        close(fd);
+    if (dir)
+        free(dir);
+    return retval;
+}
+
 /*! Given datastore, get cache and format, set wdef, add modstate and print to multiple files
  *
  * Also add mod-state if applicable
+ * The datastore file is written to a temporary file which is synced and renamed to the
+ * datastore file. Only thereafter the journal is removed, so that a crash at any point
+ * leaves either the old file and the journal, or the new file.
  * @param[in]  h   Clixon handle
  * @param[in]  db  Name of database to search in (filename including dir path
  * @retval     0   OK
  * @retval    -1   Error
+ * @note In multi mode, split sub-files are written in place
  */
 int
 xmldb_write_cache2file(clixon_handle h,
                        const char   *db)
 {
     int               retval = -1;
-    cxobj            *xt;
+    cxobj            *xt = NULL;
+    db_elmnt         *de;
     char             *formatstr;
     enum format_enum  format = FORMAT_XML;
     withdefaults_type wdef = WITHDEFAULTS_EXPLICIT;
@@ -1703,9 +2155,16 @@ xmldb_write_cache2file(clixon_handle h,
     int               multi;
     FILE             *f = NULL;
     char             *dbfile = NULL;
+    char             *jfile = NULL;
+    cbuf             *cbtmp = NULL;
+    char             *tmpfile;
+    struct stat       st;
     int               ret;
 
-    if ((xt = xmldb_cache_get(h, db)) == NULL){
+    /* Read-only access, not xmldb_cache_get */
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+        xt = de->de_xml;
+    if (xt == NULL){
         clixon_err(OE_XML, 0, "XML cache not found");
         goto done;
     }
@@ -1720,17 +2179,102 @@ xmldb_write_cache2file(clixon_handle h,
     }
     if (xmldb_db2file(h, db, &dbfile) < 0)
         goto done;
-    if ((f = fopen(dbfile, "w")) == NULL){
-        clixon_err(OE_CFG, errno, "fopen(%s)", dbfile);
+    if ((cbtmp = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cbtmp, "%s.tmp", dbfile);
+    tmpfile = cbuf_get(cbtmp);
+    if ((f = fopen(tmpfile, "w")) == NULL){
+        clixon_err(OE_CFG, errno, "fopen(%s)", tmpfile);
+        goto done;
+    }
+    /* Keep permissions of existing datastore file */
+    if (stat(dbfile, &st) == 0 &&
+        fchmod(fileno(f), st.st_mode & 07777) < 0){
+        clixon_err(OE_UNIX, errno, "fchmod(%s)", tmpfile);
         goto done;
     }
     if (xmldb_dump(h, f, xt, format, pretty, wdef, multi, db) < 0)
         goto done;
+    if (fflush(f) < 0 || fsync(fileno(f)) < 0){
+        clixon_err(OE_UNIX, errno, "fsync(%s)", tmpfile);
+        goto done;
+    }
+    if (fclose(f) < 0){
+        f = NULL;
+        clixon_err(OE_UNIX, errno, "fclose(%s)", tmpfile);
+        goto done;
+    }
+    f = NULL;
+    if (rename(tmpfile, dbfile) < 0){
+        clixon_err(OE_UNIX, errno, "rename(%s, %s)", tmpfile, dbfile);
+        goto done;
+    }
+    if (xmldb_dir_fsync(dbfile) < 0)
+        goto done;
+    /* Datastore file is now synced with cache, remove journal, see CLICON_XMLDB_JOURNAL */
+    if (xmldb_db2journal(h, db, &jfile) < 0)
+        goto done;
+    if (unlink(jfile) < 0 && errno != ENOENT){
+        clixon_err(OE_UNIX, errno, "unlink(%s)", jfile);
+        goto done;
+    }
+    de->de_journal = 0;
     retval = 0;
  done:
+    if (f){
+        fclose(f);
+        unlink(tmpfile);
+    }
+    if (cbtmp)
+        cbuf_free(cbtmp);
+    if (jfile)
+        free(jfile);
     if (dbfile)
         free(dbfile);
-    if (f)
-        fclose(f);
+    return retval;
+}
+
+/*! Compact datastore journal into the datastore file, if journal exists
+ *
+ * Done before the datastore file is used directly, eg copied or renamed
+ * @param[in]  h   Clixon handle
+ * @param[in]  db  Symbolic database name
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see CLICON_XMLDB_JOURNAL
+ */
+int
+xmldb_journal_compact(clixon_handle h,
+                      const char   *db)
+{
+    int         retval = -1;
+    char       *jfile = NULL;
+    struct stat st = {0,};
+    db_elmnt   *de;
+    cxobj      *xt = NULL;
+    int         ret;
+
+    if (xmldb_db2journal(h, db, &jfile) < 0)
+        goto done;
+    if (stat(jfile, &st) < 0)
+        goto ok;
+    /* Read datastore file and replay journal if not cached */
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL || de->de_xml == NULL){
+        if ((ret = xmldb_get_cache(h, db, YB_MODULE, &xt, NULL, NULL)) < 0)
+            goto done;
+        if (ret == 0){
+            clixon_err(OE_DB, 0, "Read datastore %s", db);
+            goto done;
+        }
+    }
+    if (xmldb_write_cache2file(h, db) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (jfile)
+        free(jfile);
     return retval;
 }
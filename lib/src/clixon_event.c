@@ -54,6 +54,10 @@
 #include <sys/param.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#if defined(EVENT_EPOLL) && defined(HAVE_EPOLL_CREATE1)
+#define EVENT_USE_EPOLL
+#include <sys/epoll.h>
+#endif
 
 #include <cligen/cligen.h>
 
@@ -75,6 +79,9 @@
  */
 #define EVENT_STRLEN 32
 
+/* Max number of epoll events handled per event loop iteration */
+#define EVENT_EPOLL_MAX 64
+
 /*
  * Types
  */
@@ -87,6 +94,11 @@ struct event_data{
     void                       *e_arg;                  /* Function argument */
     char                        e_descr[EVENT_STRLEN]; /* String for debugging */
     struct pollfd              *e_pollfd;               /* Pointer to pull struct */
+    int                         e_prio;                 /* Prioritized file event */
+    uint64_t                    e_seq;                  /* Timer registration order */
+#ifdef EVENT_USE_EPOLL
+    uint32_t                    e_gen;                  /* Epoll registration, 0 if polled */
+#endif
 };
 
 /*
@@ -101,8 +113,33 @@ static int _ee_nr = 0;
 static struct event_data *_ee_prio = NULL;
 static int _ee_prio_nr = 0;
 
-/* Timer event handlers */
-static struct event_data *_ee_timers = NULL;
+/* Number of file event handlers that are polled, ie not in epoll */
+static int _ee_poll_nr = 0;
+
+/* Timer event handlers, binary min-heap ordered by time and registration order */
+static struct event_data **_ee_timers = NULL;
+static int _ee_timers_nr = 0;
+static int _ee_timers_max = 0;
+static uint64_t _ee_timers_seq = 0;
+
+#ifdef EVENT_USE_EPOLL
+/* Epoll instance, -1 if not created */
+static int _ee_epfd = -1;
+
+/* Process that created the epoll instance, a forked child creates its own */
+static pid_t _ee_epoll_pid = 0;
+
+/* Last epoll registration, identifies handler in epoll events together with fd */
+static uint32_t _ee_epoll_gen = 0;
+
+/* File event handlers registered in epoll indexed by fd */
+static struct event_data **_ee_fdvec = NULL;
+static int _ee_fdvec_len = 0;
+
+/* Epoll events of current event loop iteration, handled events are zeroed */
+static struct epoll_event _ee_epevs[EVENT_EPOLL_MAX];
+static int _ee_epevs_nr = 0;
+#endif /* EVENT_USE_EPOLL */
 
 /* Set if element in _ee is deleted (clixon_event_unreg_fd). Check in _ee loops
  * XXX: algorithm has flaw: which _ee is unregged?
@@ -179,6 +216,305 @@ clicon_sig_ignore_get(void)
     return _clicon_sig_ignore;
 }
 
+/*! Timer a expires before timer b, if same time the one registered first
+ */
+static int
+timer_before(struct event_data *a,
+             struct event_data *b)
+{
+    if (timercmp(&a->e_time, &b->e_time, <))
+        return 1;
+    if (timercmp(&b->e_time, &a->e_time, <))
+        return 0;
+    return a->e_seq < b->e_seq;
+}
+
+/*! Move timer at position i up in the heap until its parent expires before it
+ */
+static void
+timer_heap_up(int i)
+{
+    struct event_data *e = _ee_timers[i];
+    int                p;
+
+    while (i > 0){
+        p = (i-1)/2;
+        if (!timer_before(e, _ee_timers[p]))
+            break;
+        _ee_timers[i] = _ee_timers[p];
+        i = p;
+    }
+    _ee_timers[i] = e;
+}
+
+/*! Move timer at position i down in the heap until its children expire after it
+ */
+static void
+timer_heap_down(int i)
+{
+    struct event_data *e = _ee_timers[i];
+    int                c;
+
+    while ((c = 2*i+1) < _ee_timers_nr){
+        if (c+1 < _ee_timers_nr && timer_before(_ee_timers[c+1], _ee_timers[c]))
+            c++;
+        if (!timer_before(_ee_timers[c], e))
+            break;
+        _ee_timers[i] = _ee_timers[c];
+        i = c;
+    }
+    _ee_timers[i] = e;
+}
+
+/*! Remove timer at position i from the heap
+ *
+ * @param[in]  i  Position in heap, 0 is first to expire
+ * @retval     e  Removed timer, to be freed by caller
+ */
+static struct event_data *
+timer_heap_rm(int i)
+{
+    struct event_data *e = _ee_timers[i];
+
+    _ee_timers_nr--;
+    if (i < _ee_timers_nr){
+        _ee_timers[i] = _ee_timers[_ee_timers_nr];
+        if (i > 0 && timer_before(_ee_timers[i], _ee_timers[(i-1)/2]))
+            timer_heap_up(i);
+        else
+            timer_heap_down(i);
+    }
+    return e;
+}
+
+#ifdef EVENT_USE_EPOLL
+/*! Get file event handler from epoll event data, NULL if unregistered since
+ */
+static struct event_data *
+event_epoll_get(uint64_t data)
+{
+    int                fd = (int)(uint32_t)data;
+    struct event_data *e;
+
+    if (fd < 0 || fd >= _ee_fdvec_len)
+        return NULL;
+    if ((e = _ee_fdvec[fd]) == NULL || e->e_gen != (uint32_t)(data >> 32))
+        return NULL;
+    return e;
+}
+
+/*! Check if epoll instance is inherited from a parent process
+ *
+ * A forked child must not modify the epoll instance of its parent, since eg an
+ * unregistration in the child would remove the fd from the parent's instance. The child
+ * creates its own instance on first use of the event loop, see event_epoll_init.
+ * @retval     1   Inherited, do not use
+ * @retval     0   Created by this process, or none
+ */
+static int
+event_epoll_inherited(void)
+{
+    return _ee_epfd != -1 && getpid() != _ee_epoll_pid;
+}
+
+/*! Arm file event handler in epoll
+ *
+ * Handlers are one-shot and re-armed after being handled. Events of a handler that is
+ * unregistered or re-registered after its fd was closed are thereby reported at most once
+ * and then ignored, see event_epoll_get.
+ * Events are level-triggered, not edge-triggered: callbacks typically read one message
+ * and rely on being called again if more data is available.
+ * @param[in]  e   File event handler
+ * @param[in]  op  EPOLL_CTL_ADD or EPOLL_CTL_MOD
+ * @retval     0   OK
+ * @retval    -1   epoll_ctl failed, errno set
+ */
+static int
+event_epoll_arm(struct event_data *e,
+                int                op)
+{
+    struct epoll_event ev = {0,};
+
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.u64 = ((uint64_t)e->e_gen << 32) | (uint32_t)e->e_fd;
+    return epoll_ctl(_ee_epfd, op, e->e_fd, &ev);
+}
+#endif /* EVENT_USE_EPOLL */
+
+/*! Add file event handler to epoll, or to polled handlers if not possible
+ *
+ * @param[in]  e   File event handler
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+event_fd_add(struct event_data *e)
+{
+#ifdef EVENT_USE_EPOLL
+    struct event_data **vec;
+    int                 len;
+
+    e->e_gen = 0;
+    /* If inherited, handlers are registered when the instance is re-created */
+    if (_ee_epfd == -1 || e->e_fd < 0 || event_epoll_inherited())
+        goto poll;
+    if (e->e_fd >= _ee_fdvec_len){
+        len = 2*_ee_fdvec_len > e->e_fd ? 2*_ee_fdvec_len : e->e_fd + 1;
+        if ((vec = realloc(_ee_fdvec, len*sizeof(*vec))) == NULL){
+            clixon_err(OE_EVENTS, errno, "realloc");
+            return -1;
+        }
+        memset(vec + _ee_fdvec_len, 0, (len - _ee_fdvec_len)*sizeof(*vec));
+        _ee_fdvec = vec;
+        _ee_fdvec_len = len;
+    }
+    if (++_ee_epoll_gen == 0)
+        _ee_epoll_gen++;
+    e->e_gen = _ee_epoll_gen;
+    if (event_epoll_arm(e, EPOLL_CTL_ADD) < 0){
+        /* Eg regular file (EPERM) or fd registered twice (EEXIST) */
+        clixon_debug(CLIXON_DBG_EVENT, "epoll %s: %s, poll instead", e->e_descr, strerror(errno));
+        e->e_gen = 0;
+        goto poll;
+    }
+    /* Previous handler of fd was closed but not unregistered, poll it as before */
+    if (_ee_fdvec[e->e_fd] != NULL){
+        _ee_fdvec[e->e_fd]->e_gen = 0;
+        _ee_poll_nr++;
+    }
+    _ee_fdvec[e->e_fd] = e;
+    return 0;
+ poll:
+#endif /* EVENT_USE_EPOLL */
+    _ee_poll_nr++;
+    return 0;
+}
+
+/*! Remove file event handler from epoll or polled handlers
+ *
+ * @param[in]  e   File event handler
+ */
+static void
+event_fd_rm(struct event_data *e)
+{
+#ifdef EVENT_USE_EPOLL
+    if (e->e_gen != 0){
+        if (_ee_fdvec[e->e_fd] == e){
+            /* May fail if fd is already closed */
+            if (!event_epoll_inherited())
+                epoll_ctl(_ee_epfd, EPOLL_CTL_DEL, e->e_fd, NULL);
+            _ee_fdvec[e->e_fd] = NULL;
+        }
+        return;
+    }
+#endif
+    _ee_poll_nr--;
+}
+
+#ifdef EVENT_USE_EPOLL
+/*! Create epoll instance and register file event handlers
+ *
+ * Done once per process: a forked child does not share the epoll instance of its parent,
+ * it is re-created lazily when the child first runs the event loop, see
+ * event_epoll_inherited. A child that never runs the event loop, eg a validation worker,
+ * does not pay for it.
+ * If epoll cannot be created, all file descriptors are polled.
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+event_epoll_init(void)
+{
+    struct event_data *e;
+    pid_t              pid;
+
+    if ((pid = getpid()) == _ee_epoll_pid)
+        return 0;
+    _ee_epoll_pid = pid;
+    if (_ee_epfd != -1)
+        close(_ee_epfd);
+    if ((_ee_epfd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+        clixon_debug(CLIXON_DBG_EVENT, "epoll_create1: %s, poll instead", strerror(errno));
+    /* Re-register existing handlers, eg registered before fork */
+    if (_ee_fdvec)
+        memset(_ee_fdvec, 0, _ee_fdvec_len*sizeof(*_ee_fdvec));
+    _ee_poll_nr = 0;
+    for (e = _ee_prio; e; e = e->e_next)
+        if (event_fd_add(e) < 0)
+            return -1;
+    for (e = _ee; e; e = e->e_next)
+        if (event_fd_add(e) < 0)
+            return -1;
+    return 0;
+}
+
+/*! Handle ready epoll file events of one priority
+ *
+ * Handled events are zeroed in _ee_epevs, and handlers that remain registered are re-armed
+ * @param[in]  prio  Priority: handle prioritized (1) or un-prioritized (0) handlers
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see event_handle_fds  for polled file events
+ */
+static int
+event_epoll_handle(int prio)
+{
+    int                retval = -1;
+    struct event_data *e;
+    uint64_t           data;
+    int                i;
+
+    for (i = 0; i < _ee_epevs_nr; i++){
+        if ((data = _ee_epevs[i].data.u64) == 0)
+            continue;
+        if ((e = event_epoll_get(data)) == NULL){
+            _ee_epevs[i].data.u64 = 0;
+            continue;
+        }
+        if (e->e_prio != prio)
+            continue;
+        _ee_epevs[i].data.u64 = 0;
+        /* As POLLHUP in event_handle_fds, callback reads end-of-file */
+        if ((_ee_epevs[i].events & (EPOLLIN|EPOLLHUP)) == 0){
+            /* As POLLNVAL in event_handle_fds */
+            clixon_err(OE_EVENTS, 0, "epoll: Error condition: %s fd %d events:0x%x",
+                       e->e_descr, e->e_fd, _ee_epevs[i].events);
+            goto done;
+        }
+        clixon_debug(CLIXON_DBG_EVENT, "fd %s", e->e_descr);
+        if ((*e->e_fn)(e->e_fd, e->e_arg) < 0) {
+            clixon_debug(CLIXON_DBG_EVENT, "Error in: %s", e->e_descr);
+            goto done;
+        }
+        /* Callback may have unregistered the handler */
+        if ((e = event_epoll_get(data)) != NULL &&
+            event_epoll_arm(e, EPOLL_CTL_MOD) < 0)
+            clixon_debug(CLIXON_DBG_EVENT, "epoll %s: %s", e->e_descr, strerror(errno));
+        if (prio == 0 && _ee_prio_nr > 0) /* Prioritized exists, break unprio fairness */
+            break;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Re-arm epoll file event handlers that were ready but not handled, and clear events
+ */
+static void
+event_epoll_rearm(void)
+{
+    struct event_data *e;
+    int                i;
+
+    for (i = 0; i < _ee_epevs_nr; i++){
+        if ((e = event_epoll_get(_ee_epevs[i].data.u64)) != NULL &&
+            event_epoll_arm(e, EPOLL_CTL_MOD) < 0)
+            clixon_debug(CLIXON_DBG_EVENT, "epoll %s: %s", e->e_descr, strerror(errno));
+    }
+    _ee_epevs_nr = 0;
+}
+#endif /* EVENT_USE_EPOLL */
+
 /*! Register a callback function to be called on input on a file descriptor.
  *
  * Prio is primitive, non-preemptive as follows:
@@ -217,6 +553,17 @@ clixon_event_reg_fd_prio(int   fd,
     e->e_fn = fn;
     e->e_arg = arg;
     e->e_type = EVENT_FD;
+    e->e_prio = prio;
+#ifdef EVENT_USE_EPOLL
+    if (event_epoll_init() < 0){
+        free(e);
+        return -1;
+    }
+#endif
+    if (event_fd_add(e) < 0){
+        free(e);
+        return -1;
+    }
     if (prio){
         e->e_next = _ee_prio;
         _ee_prio = e;
@@ -271,6 +618,7 @@ clixon_event_unreg_fd(int   s,
             *e_prev = e->e_next;
             _ee_prio_nr--;
             _ee_unreg++;
+            event_fd_rm(e);
             free(e);
             break;
         }
@@ -284,6 +632,7 @@ clixon_event_unreg_fd(int   s,
                 *e_prev = e->e_next;
                 _ee_nr--;
                 _ee_unreg++;
+                event_fd_rm(e);
                 free(e);
                 break;
             }
@@ -325,8 +674,7 @@ clixon_event_reg_timeout(struct timeval t,
 {
     int                 retval = -1;
     struct event_data  *e;
-    struct event_data  *e1;
-    struct event_data **e_prev;
+    struct event_data **vec;
 
     if (str == NULL || fn == NULL){
         clixon_err(OE_CFG, EINVAL, "str or fn is NULL");
@@ -342,15 +690,18 @@ clixon_event_reg_timeout(struct timeval t,
     e->e_arg = arg;
     e->e_type = EVENT_TIME;
     e->e_time = t;
-    /* Sort into right place */
-    e_prev = &_ee_timers;
-    for (e1=_ee_timers; e1; e1=e1->e_next){
-        if (timercmp(&e->e_time, &e1->e_time, <))
-            break;
-        e_prev = &e1->e_next;
+    e->e_seq = _ee_timers_seq++;
+    if (_ee_timers_nr == _ee_timers_max){
+        _ee_timers_max = _ee_timers_max ? 2*_ee_timers_max : 16;
+        if ((vec = realloc(_ee_timers, _ee_timers_max*sizeof(*vec))) == NULL){
+            clixon_err(OE_EVENTS, errno, "realloc");
+            free(e);
+            goto done;
+        }
+        _ee_timers = vec;
     }
-    e->e_next = e1;
-    *e_prev = e;
+    _ee_timers[_ee_timers_nr++] = e;
+    timer_heap_up(_ee_timers_nr-1);
     clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "%s", str);
     retval = 0;
  done:
@@ -373,21 +724,17 @@ int
 clixon_event_unreg_timeout(int (*fn)(int, void*),
                            void *arg)
 {
-    struct event_data  *e;
-    int                 found = 0;
-    struct event_data **e_prev;
+    struct event_data *e;
+    int                i;
 
-    e_prev = &_ee_timers;
-    for (e = _ee_timers; e; e = e->e_next){
+    for (i = 0; i < _ee_timers_nr; i++){
+        e = _ee_timers[i];
         if (fn == e->e_fn && arg == e->e_arg) {
-            found++;
-            *e_prev = e->e_next;
-            free(e);
-            break;
+            free(timer_heap_rm(i));
+            return 0;
         }
-        e_prev = &e->e_next;
     }
-    return found?0:-1;
+    return -1;
 }
 
 /*! Poll to see if there is any data available on this file descriptor.
@@ -470,6 +817,8 @@ event_handle_fds(struct event_data *ee,
     struct pollfd     *pfd;
     struct event_data *e = NULL;
 
+    if (_ee_poll_nr == 0)
+        goto ok;
     for (e = ee; e; e = e->e_next) {
         if (e->e_type != EVENT_FD)
             continue;
@@ -503,6 +852,7 @@ event_handle_fds(struct event_data *ee,
             }
         }
     }
+ ok:
     retval = 0;
  done:
     return retval;
@@ -525,6 +875,9 @@ clixon_event_loop(clixon_handle h)
     struct event_data *e = NULL;
     struct pollfd     *fds = NULL;
     struct pollfd     *pfd;
+#ifdef EVENT_USE_EPOLL
+    struct pollfd     *epfd = NULL;   /* Poll struct of epoll instance */
+#endif
     uint32_t           nfds_max = 0;
     int                nfds = 0;
     struct timeval     t0;
@@ -535,7 +888,11 @@ clixon_event_loop(clixon_handle h)
     int                ret;
 
     while (clixon_exit_get() != 1) {
-        nfds = _ee_prio_nr + _ee_nr;
+#ifdef EVENT_USE_EPOLL
+        if (event_epoll_init() < 0)
+            goto done;
+#endif
+        nfds = _ee_poll_nr + 1; /* Also epoll instance */
         if (nfds > nfds_max){
             nfds_max = nfds;
             if ((fds = realloc(fds, nfds_max*sizeof(struct pollfd))) == NULL){
@@ -545,7 +902,12 @@ clixon_event_loop(clixon_handle h)
         }
         nfds = 0;
         clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "register prio");
-        for (e = _ee_prio; e; e = e->e_next) {
+        for (e = _ee_poll_nr?_ee_prio:NULL; e; e = e->e_next) {
+            e->e_pollfd = NULL;
+#ifdef EVENT_USE_EPOLL
+            if (e->e_gen != 0)
+                continue;
+#endif
             if (e->e_type == EVENT_FD) {
                 pfd = &fds[nfds];
                 pfd->fd = e->e_fd;
@@ -557,7 +919,12 @@ clixon_event_loop(clixon_handle h)
             }
         }
         clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "register unprio");
-        for (e = _ee; e; e = e->e_next) {
+        for (e = _ee_poll_nr?_ee:NULL; e; e = e->e_next) {
+            e->e_pollfd = NULL;
+#ifdef EVENT_USE_EPOLL
+            if (e->e_gen != 0)
+                continue;
+#endif
             if (e->e_type == EVENT_FD) {
                 pfd = &fds[nfds];
                 pfd->fd = e->e_fd;
@@ -568,15 +935,24 @@ clixon_event_loop(clixon_handle h)
                 nfds++;
             }
         }
-        if (nfds != _ee_nr + _ee_prio_nr){
+        if (nfds != _ee_poll_nr){
             clixon_err(OE_EVENTS, 0, "File descriptor mismatch");
             goto done;
         }
+#ifdef EVENT_USE_EPOLL
+        epfd = NULL;
+        /* Poll epoll instance if any handler is registered in it */
+        if (_ee_epfd != -1 && _ee_poll_nr < _ee_nr + _ee_prio_nr){
+            epfd = &fds[nfds++];
+            epfd->fd = _ee_epfd;
+            epfd->events = POLLIN;
+        }
+#endif
         timeout = -1;
         clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "timeout");
-        if (_ee_timers != NULL) {
+        if (_ee_timers_nr > 0) {
             gettimeofday(&t0, NULL);
-            timersub(&_ee_timers->e_time, &t0, &t);
+            timersub(&_ee_timers[0]->e_time, &t0, &t);
             tdiff = t.tv_sec * 1000 + t.tv_usec / 1000;
             if (tdiff < 0)
                 timeout = 0;
@@ -605,10 +981,9 @@ clixon_event_loop(clixon_handle h)
                 clixon_err(OE_EVENTS, errno, "poll");
             goto done;
         }
-        if (n == 0) { /* timeout */
+        if (n == 0 && _ee_timers_nr > 0) { /* timeout */
             clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "n=0 Timeout");
-            e = _ee_timers;
-            _ee_timers = _ee_timers->e_next;
+            e = timer_heap_rm(0);
             clixon_debug(CLIXON_DBG_EVENT | CLIXON_DBG_DETAIL, "timeout: %s", e->e_descr);
             if ((*e->e_fn)(0, e->e_arg) < 0) {
                 free(e);
@@ -616,9 +991,29 @@ clixon_event_loop(clixon_handle h)
             }
             free(e);
         }
+#ifdef EVENT_USE_EPOLL
+        if (epfd && epfd->revents){
+            if ((_ee_epevs_nr = epoll_wait(_ee_epfd, _ee_epevs, EVENT_EPOLL_MAX, 0)) < 0){
+                _ee_epevs_nr = 0;
+                if (errno != EINTR){
+                    clixon_err(OE_EVENTS, errno, "epoll_wait");
+                    goto done;
+                }
+            }
+        }
+        /* Prio files */
+        if (event_epoll_handle(1) < 0)
+            goto done;
+#endif
         /* Prio files */
         if ((ret = event_handle_fds(_ee_prio, 1)) < 0)
             goto done;
+#ifdef EVENT_USE_EPOLL
+        /* Unprio files */
+        if (event_epoll_handle(0) < 0)
+            goto done;
+        event_epoll_rearm();
+#endif
         /* Unprio files */
         if ((ret = event_handle_fds(_ee, 0)) < 0)
             goto done;
@@ -654,11 +1049,25 @@ clixon_event_exit(void)
     }
     _ee = NULL;
 
-    e_next = _ee_timers;
-    while ((e = e_next) != NULL){
-        e_next = e->e_next;
-        free(e);
-    }
+    while (_ee_timers_nr > 0)
+        free(_ee_timers[--_ee_timers_nr]);
+    if (_ee_timers)
+        free(_ee_timers);
     _ee_timers = NULL;
+    _ee_timers_max = 0;
+    _ee_prio_nr = 0;
+    _ee_nr = 0;
+    _ee_poll_nr = 0;
+#ifdef EVENT_USE_EPOLL
+    if (_ee_epfd != -1)
+        close(_ee_epfd);
+    _ee_epfd = -1;
+    _ee_epoll_pid = 0;
+    if (_ee_fdvec)
+        free(_ee_fdvec);
+    _ee_fdvec = NULL;
+    _ee_fdvec_len = 0;
+    _ee_epevs_nr = 0;
+#endif
     return 0;
 }
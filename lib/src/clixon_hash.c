@@ -100,19 +100,78 @@
 #include "clixon_xml.h"
 #include "clixon_err.h"
 
-#define HASH_SIZE       1031    /* Number of hash buckets. Should be a prime */
+#define HASH_SIZE       64      /* Initial number of hash buckets. Must be power of 2 */
 #define align4(s) (((s)/4)*4 + 4)
 
-/*! A very simplistic algorithm to calculate a hash bucket index
+/*
+ * Types
+ */
+/*! Hash table
+ *
+ * Users see this as an opaque clicon_hash_t pointer.
+ * Entries are in bucket chains via h_next, and in a list of all entries via h_qelem
+ * in insertion order.
+ * The number of buckets is doubled when the number of entries exceeds it.
+ */
+struct clicon_hash_table {
+    clicon_hash_t *ht_bucket;  /* Vector of bucket chains */
+    uint32_t       ht_size;    /* Number of buckets, power of 2 */
+    size_t         ht_nr;      /* Number of entries */
+    clicon_hash_t  ht_list;    /* All entries in insertion order */
+};
+
+#define hash_table(hash) ((struct clicon_hash_table *)(hash))
+
+/*! Compute 32-bit FNV-1a hash of a string
+ *
+ * Also used by other hash tables, eg the XML name intern table
+ * @param[in]  str  Null-terminated string
+ * @retval     hash Hash value, bucket index is given by masking with table size
+ * @see http://www.isthe.com/chongo/tech/comp/fnv/
  */
-static uint32_t
-hash_bucket(const char *str)
+uint32_t
+clicon_hash_fnv1a(const char *str)
 {
-    uint32_t n = 0;
+    uint32_t n = 2166136261U;
+
+    while (*str){
+        n ^= (uint8_t)*str++;
+        n *= 16777619U;
+    }
+    return n;
+}
 
-    while(*str)
-        n += (uint32_t)*str++;
-    return n % HASH_SIZE;
+/*! Double number of buckets and rehash all entries
+ *
+ * @param[in]  ht   Hash table
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+hash_grow(struct clicon_hash_table *ht)
+{
+    clicon_hash_t *bucket;
+    clicon_hash_t  h;
+    uint32_t       size;
+    uint32_t       bkt;
+
+    size = ht->ht_size*2;
+    if ((bucket = calloc(size, sizeof(clicon_hash_t))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    if ((h = ht->ht_list) != NULL){
+        do {
+            bkt = h->h_hash & (size-1);
+            h->h_next = bucket[bkt];
+            bucket[bkt] = h;
+            h = NEXTQ(clicon_hash_t, h);
+        } while (h != ht->ht_list);
+    }
+    free(ht->ht_bucket);
+    ht->ht_bucket = bucket;
+    ht->ht_size = size;
+    return 0;
 }
 
 /*! Initialize hash table.
@@ -124,14 +183,20 @@ hash_bucket(const char *str)
 clicon_hash_t *
 clicon_hash_init(void)
 {
-  clicon_hash_t *hash;
-
-  if ((hash = (clicon_hash_t *)malloc(sizeof(clicon_hash_t) * HASH_SIZE)) == NULL){
-      clixon_err(OE_UNIX, errno, "malloc");
-      return NULL;
-  }
-  memset(hash, 0, sizeof(clicon_hash_t)*HASH_SIZE);
-  return hash;
+    struct clicon_hash_table *ht;
+
+    if ((ht = malloc(sizeof(*ht))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(ht, 0, sizeof(*ht));
+    if ((ht->ht_bucket = calloc(HASH_SIZE, sizeof(clicon_hash_t))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        free(ht);
+        return NULL;
+    }
+    ht->ht_size = HASH_SIZE;
+    return (clicon_hash_t *)ht;
 }
 
 /*! Free hash table.
@@ -143,18 +208,18 @@ clicon_hash_init(void)
 int
 clicon_hash_free(clicon_hash_t *hash)
 {
-    int i;
-    clicon_hash_t tmp;
-    for (i = 0; i < HASH_SIZE; i++) {
-        while (hash[i]) {
-            tmp = hash[i];
-            DELQ(tmp, hash[i], clicon_hash_t);
-            free(tmp->h_key);
+    struct clicon_hash_table *ht = hash_table(hash);
+    clicon_hash_t             tmp;
+
+    while ((tmp = ht->ht_list) != NULL) {
+        DELQ(tmp, ht->ht_list, clicon_hash_t);
+        free(tmp->h_key);
+        if (tmp->h_val)
             free(tmp->h_val);
-            free(tmp);
-        }
+        free(tmp);
     }
-    free(hash);
+    free(ht->ht_bucket);
+    free(ht);
     return 0;
 }
 
@@ -169,18 +234,14 @@ clicon_hash_t
 clicon_hash_lookup(clicon_hash_t *hash,
                    const char    *key)
 {
-    uint32_t      bkt;
-    clicon_hash_t h;
-
-    bkt = hash_bucket(key);
-    h = hash[bkt];
-    if (h) {
-        do {
-            if (!strcmp(h->h_key, key))
-                return h;
-            h = NEXTQ(clicon_hash_t, h);
-        } while (h != hash[bkt]);
-    }
+    struct clicon_hash_table *ht = hash_table(hash);
+    uint32_t                  n;
+    clicon_hash_t             h;
+
+    n = clicon_hash_fnv1a(key);
+    for (h = ht->ht_bucket[n & (ht->ht_size-1)]; h != NULL; h = h->h_next)
+        if (h->h_hash == n && strcmp(h->h_key, key) == 0)
+            return h;
     return NULL;
 }
 
@@ -228,9 +289,11 @@ clicon_hash_add(clicon_hash_t *hash,
                 void          *val,
                 size_t         vlen)
 {
-    void         *newval = NULL;
-    clicon_hash_t h;
-    clicon_hash_t new = NULL;
+    struct clicon_hash_table *ht = hash_table(hash);
+    void                     *newval = NULL;
+    clicon_hash_t             h;
+    clicon_hash_t             new = NULL;
+    uint32_t                  bkt;
 
     if (hash == NULL){
         clixon_err(OE_UNIX, EINVAL, "hash is NULL");
@@ -255,6 +318,10 @@ clicon_hash_add(clicon_hash_t *hash,
             clixon_err(OE_UNIX, errno, "strdup");
             goto catch;
         }
+        new->h_hash = clicon_hash_fnv1a(key);
+        /* Grow before adding to keep load factor at most 1 */
+        if (ht->ht_nr >= ht->ht_size && hash_grow(ht) < 0)
+            goto catch;
         h = new;
     }
     if (vlen){
@@ -272,9 +339,14 @@ clicon_hash_add(clicon_hash_t *hash,
     h->h_val = newval;
     h->h_vlen =  vlen;
 
-    /* Add to list only if new variable */
-    if (new)
-        INSQ(h, hash[hash_bucket(key)]);
+    /* Add to lists only if new variable */
+    if (new){
+        bkt = h->h_hash & (ht->ht_size-1);
+        h->h_next = ht->ht_bucket[bkt];
+        ht->ht_bucket[bkt] = h;
+        ADDQ(h, ht->ht_list);
+        ht->ht_nr++;
+    }
 
     return h;
 
@@ -299,7 +371,9 @@ int
 clicon_hash_del(clicon_hash_t *hash,
                 const char    *key)
 {
-    clicon_hash_t h;
+    struct clicon_hash_table *ht = hash_table(hash);
+    clicon_hash_t             h;
+    clicon_hash_t            *hp;
 
     if (hash == NULL){
         clixon_err(OE_UNIX, EINVAL, "hash is NULL");
@@ -308,7 +382,12 @@ clicon_hash_del(clicon_hash_t *hash,
     h = clicon_hash_lookup(hash, key);
     if (h == NULL)
         return -1;
-    DELQ(h, hash[hash_bucket(key)], clicon_hash_t);
+    /* Unlink from bucket chain */
+    for (hp = &ht->ht_bucket[h->h_hash & (ht->ht_size-1)]; *hp != h; hp = &(*hp)->h_next)
+        ;
+    *hp = h->h_next;
+    DELQ(h, ht->ht_list, clicon_hash_t);
+    ht->ht_nr--;
     free(h->h_key);
     free(h->h_val);
     free(h);
@@ -330,32 +409,26 @@ clicon_hash_keys(clicon_hash_t *hash,
                  char        ***vector,
                  size_t        *nkeys)
 {
-    int           retval = -1;
-    int           bkt;
-    clicon_hash_t h;
-    char        **tmp;
-    char        **keys = NULL;
+    int                       retval = -1;
+    struct clicon_hash_table *ht = hash_table(hash);
+    clicon_hash_t             h;
+    char                    **keys = NULL;
 
     if (hash == NULL){
         clixon_err(OE_UNIX, EINVAL, "hash is NULL");
         return -1;
     }
     *nkeys = 0;
-    for (bkt = 0; bkt < HASH_SIZE; bkt++) {
-        h = hash[bkt];
+    if (ht->ht_nr &&
+        (keys = malloc(ht->ht_nr * sizeof(char *))) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        goto catch;
+    }
+    if ((h = ht->ht_list) != NULL){
         do {
-            if (h == NULL)
-                break;
-            tmp = realloc(keys, ((*nkeys)+1) * sizeof(char *));
-            if (tmp == NULL){
-                clixon_err(OE_UNIX, errno, "realloc");
-                goto catch;
-            }
-            keys = tmp;
-            keys[*nkeys] = h->h_key;
-            (*nkeys)++;
+            keys[(*nkeys)++] = h->h_key;
             h = NEXTQ(clicon_hash_t, h);
-        } while (h != hash[bkt]);
+        } while (h != ht->ht_list);
     }
     if (vector){
         *vector = keys;
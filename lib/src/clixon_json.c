@@ -210,7 +210,7 @@ array_eval(cxobj *xprev,
     }
     if (xnext &&
         xml_type(xnext)==CX_ELMNT &&
-        strcmp(xml_name(x), xml_name(xnext))==0){
+        xml_name(x) == xml_name(xnext)){ /* names are interned */
         ns2 = xml_find_type_value(xnext, NULL, "xmlns", CX_ATTR);
         if ((!nsx && !ns2)
             || (nsx && ns2 && strcmp(nsx,ns2)==0))
@@ -218,7 +218,7 @@ array_eval(cxobj *xprev,
     }
     if (xprev &&
         xml_type(xprev)==CX_ELMNT &&
-        strcmp(xml_name(x),xml_name(xprev))==0){
+        xml_name(x) == xml_name(xprev)){
         ns2 = xml_find_type_value(xprev, NULL, "xmlns", CX_ATTR);
         if ((!nsx && !ns2)
             || (nsx && ns2 && strcmp(nsx,ns2)==0))
@@ -1698,7 +1698,7 @@ clixon_json_parse_file(FILE      *fp,
     retval = 1;
  done:
     if (retval < 0 && *xt){
-        free(*xt);
+        xml_free(*xt);
         *xt = NULL;
     }
     if (jsonbuf)
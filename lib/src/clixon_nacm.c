@@ -81,6 +81,151 @@
 /* NACM namespace for use with xml namespace contexts and xpath */
 #define NACM_NS "urn:ietf:params:xml:ns:yang:ietf-netconf-acm"
 
+/* Groups and rule-lists of a user in the cached NACM tree, see nacm_user_rulelists */
+struct nacm_user_entry {
+    size_t  ue_glen;     /* Number of groups of user */
+    size_t  ue_rlistlen; /* Number of rule-lists of the groups */
+    cxobj  *ue_vec[];    /* Groups followed by rule-lists */
+};
+
+/* nacm node of cached NACM tree of running, see nacm_access_pre_cached */
+static cxobj         *_nacm_cache_xnacm = NULL;
+/* Username -> struct nacm_user_entry, valid for _nacm_cache_xnacm */
+static clicon_hash_t *_nacm_cache_users = NULL;
+
+/*! Clear per-user cache of groups and rule-lists
+ */
+static void
+nacm_user_cache_clear(void)
+{
+    if (_nacm_cache_users){
+        clicon_hash_free(_nacm_cache_users);
+        _nacm_cache_users = NULL;
+    }
+    _nacm_cache_xnacm = NULL;
+}
+
+/*! Get groups of a user and the rule-lists of those groups
+ *
+ * RFC8341 3.4.4 steps 4-6 and 3.4.5 steps 3-5. Rule-lists are in configuration order.
+ * If xnacm is the cached NACM tree of running, the result is cached per user until the
+ * tree is reset, see nacm_cache_reset.
+ * @param[in]  xnacm     NACM XML tree, root should be "nacm"
+ * @param[in]  nsc       Namespace context with NACM namespace as default
+ * @param[in]  username  User name of requestor
+ * @param[out] gvecp     Groups of user, free after use
+ * @param[out] glenp     Length of gvec
+ * @param[out] rlistvecp Rule-lists with a group of user, free after use
+ * @param[out] rlistlenp Length of rlistvec
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @note Access decisions of data nodes are not cached, eg per YANG statement: rules with
+ *       paths depend on instance data such as list keys. Read rules are instead compiled
+ *       once per request, see nacm_read_compile
+ */
+static int
+nacm_user_rulelists(cxobj    *xnacm,
+                    cvec     *nsc,
+                    char     *username,
+                    cxobj  ***gvecp,
+                    size_t   *glenp,
+                    cxobj  ***rlistvecp,
+                    size_t   *rlistlenp)
+{
+    int                     retval = -1;
+    int                     cached;
+    struct nacm_user_entry *ue;
+    struct nacm_user_entry *uenew = NULL;
+    size_t                  uelen;
+    cxobj                 **gvec = NULL;
+    size_t                  glen = 0;
+    cxobj                 **rlistvec = NULL;
+    size_t                  rlistlen = 0;
+    cxobj                 **vec = NULL;
+    size_t                  veclen;
+    char                   *gname;
+    int                     i;
+    int                     j;
+
+    cached = xnacm != NULL && xnacm == _nacm_cache_xnacm;
+    if (cached && _nacm_cache_users != NULL &&
+        (ue = clicon_hash_value(_nacm_cache_users, username, NULL)) != NULL){
+        glen = ue->ue_glen;
+        rlistlen = ue->ue_rlistlen;
+        if (glen){
+            if ((gvec = malloc(glen*sizeof(cxobj*))) == NULL){
+                clixon_err(OE_UNIX, errno, "malloc");
+                goto done;
+            }
+            memcpy(gvec, ue->ue_vec, glen*sizeof(cxobj*));
+        }
+        if (rlistlen){
+            if ((rlistvec = malloc(rlistlen*sizeof(cxobj*))) == NULL){
+                clixon_err(OE_UNIX, errno, "malloc");
+                goto done;
+            }
+            memcpy(rlistvec, ue->ue_vec+glen, rlistlen*sizeof(cxobj*));
+        }
+        goto ok;
+    }
+    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+        goto done;
+    if (glen){
+        if (xpath_vec(xnacm, nsc, "rule-list", &vec, &veclen) < 0)
+            goto done;
+        if (veclen && (rlistvec = malloc(veclen*sizeof(cxobj*))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        for (i=0; i<veclen; i++){
+            /* Loop through user's group to find match in this rule-list */
+            for (j=0; j<glen; j++){
+                gname = xml_find_body(gvec[j], "name");
+                if (xpath_first(vec[i], nsc, ".[group='%s']", gname)!=NULL)
+                    break; /* found */
+            }
+            if (j<glen)
+                rlistvec[rlistlen++] = vec[i];
+        }
+    }
+    if (cached){
+        if (_nacm_cache_users == NULL &&
+            (_nacm_cache_users = clicon_hash_init()) == NULL)
+            goto done;
+        uelen = sizeof(*uenew) + (glen+rlistlen)*sizeof(cxobj*);
+        if ((uenew = malloc(uelen)) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        uenew->ue_glen = glen;
+        uenew->ue_rlistlen = rlistlen;
+        if (glen)
+            memcpy(uenew->ue_vec, gvec, glen*sizeof(cxobj*));
+        if (rlistlen)
+            memcpy(uenew->ue_vec+glen, rlistvec, rlistlen*sizeof(cxobj*));
+        if (clicon_hash_add(_nacm_cache_users, username, uenew, uelen) == NULL)
+            goto done;
+    }
+ ok:
+    *gvecp = gvec;
+    gvec = NULL;
+    *glenp = glen;
+    *rlistvecp = rlistvec;
+    rlistvec = NULL;
+    *rlistlenp = rlistlen;
+    retval = 0;
+ done:
+    if (uenew)
+        free(uenew);
+    if (vec)
+        free(vec);
+    if (gvec)
+        free(gvec);
+    if (rlistvec)
+        free(rlistvec);
+    return retval;
+}
+
 /*! Match nacm access operations according to RFC8341 3.4.4.  
  *
  * Incoming RPC Message Validation Step 7 (c)
@@ -202,7 +347,6 @@ nacm_rpc(char         *rpc,
     size_t  rlen;
     int     i, j;
     char   *exec_default = NULL;
-    char   *gname;
     char   *action;
     int     match= 0;
     cvec   *nsc = NULL;
@@ -223,28 +367,17 @@ nacm_rpc(char         *rpc,
     if (username == NULL)
         goto step10;
 
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
-        goto done;
-    /* 5. If no groups are found, continue with step 10. */
-    if (glen == 0)
-        goto step10;
-    /* 6. Process all rule-list entries, in the order they appear in the
+    /* User's group and 6. rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
         entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
+    if (nacm_user_rulelists(xnacm, nsc, username, &gvec, &glen, &rlistvec, &rlistlen) < 0)
         goto done;
+    /* 5. If no groups are found, continue with step 10. */
+    if (glen == 0)
+        goto step10;
     for (i=0; i<rlistlen; i++){
         rlist = rlistvec[i];
-        /* Loop through user's group to find match in this rule-list */
-        for (j=0; j<glen; j++){
-            gname = xml_find_body(gvec[j], "name");
-            if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
-                break; /* found */
-        }
-        if (j==glen) /* not found */
-            continue;
         /* 7. For each rule-list entry found, process all rules, in order,
            until a rule that matches the requested access operation is
            found.
@@ -374,8 +507,6 @@ static int
 nacm_datanode_prepare(clixon_handle     h,
                       cxobj            *xt,
                       enum nacm_access  access,
-                      cxobj           **gvec,
-                      size_t            glen,
                       cxobj           **rlistvec,
                       size_t            rlistlen,
                       cvec             *nsc,
@@ -386,7 +517,6 @@ nacm_datanode_prepare(clixon_handle     h,
     int        i;
     int        j;
     int        k;
-    char      *gname;
     cxobj    **rvec = NULL; /* rules */
     size_t     rlen;
     cxobj     *xrule;
@@ -404,14 +534,6 @@ nacm_datanode_prepare(clixon_handle     h,
     yspec = clicon_dbspec_yang(h);
     for (i=0; i<rlistlen; i++){         /* Loop through rule list */
         rlist = rlistvec[i];
-        /* Loop through user's group to find match in this rule-list */
-        for (j=0; j<glen; j++){
-            gname = xml_find_body(gvec[j], "name");
-            if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
-                break; /* found */
-        }
-        if (j==glen) /* not found */
-            continue;
         /* 6. For each rule-list entry found, process all rules, in order,
            until a rule that matches the requested access operation is
            found. (see 6 sub rules in nacm_rule_datanode
@@ -724,21 +846,18 @@ nacm_datanode_write(clixon_handle    h,
        transport layer.)               */
     if (username == NULL)
         goto step9;
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
-        goto done;
-    /* 4. If no groups are found, continue with step 9. */
-    if (glen == 0)
-        goto step9;
-    /* 5. Process all rule-list entries, in the order they appear in the
+    /* User's group and 5. rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
         entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
+    if (nacm_user_rulelists(xnacm, nsc, username, &gvec, &glen, &rlistvec, &rlistlen) < 0)
         goto done;
+    /* 4. If no groups are found, continue with step 9. */
+    if (glen == 0)
+        goto step9;
     /* First run through rules and cache rules as well as lookup objects in xt. 
      */
-    if (nacm_datanode_prepare(h, xt, access, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, access, rlistvec, rlistlen, nsc, &pv_list) < 0)
         goto done;
     /* Then recursivelyy traverse all requested nodes */
     if ((ret = nacm_datanode_write_recurse(h, xreq, pv_list,
@@ -794,152 +913,239 @@ nacm_datanode_write(clixon_handle    h,
  * Datanode read
  */
 
-/*! Perform NACM action: mark if permit, del if deny
- *
- * @param[in] xrule    NACM rule
- * @param[in] xn       XML node (requested node)
- * @retval    0        OK
- * @retval   -1        Error
+/* Compiled NACM read rule, in rule order, see nacm_read_compile */
+struct nacm_read_rule {
+    char *rr_module; /* Rule module-name, NULL if "*" */
+    int   rr_path;   /* Rule has a path, ie only applies to targets and descendants */
+    int   rr_flag;   /* XML_FLAG_DEL if deny, XML_FLAG_MARK if permit, 0 otherwise */
+};
+
+/* Target node of a NACM read rule path */
+struct nacm_read_target {
+    cxobj *rt_x;    /* Node found by instance-id lookup of rule path */
+    int    rt_rule; /* Index of rule in rule table */
+};
+
+/* Compiled NACM read rules and targets for one read access validation */
+struct nacm_read_table {
+    struct nacm_read_rule   *rt_rules;   /* Rules in order */
+    int                      rt_rlen;    /* Length of rules */
+    struct nacm_read_target *rt_targets; /* Path targets sorted on node */
+    int                      rt_tlen;    /* Length of targets */
+    int                     *rt_active;  /* Stack of rules of ancestor targets, size tlen */
+    yang_stmt               *rt_ymod;    /* Cache: last module of pathless rule lookup */
+    int                      rt_ymodrule;/* Cache: first pathless rule matching rt_ymod */
+    yang_stmt               *rt_yspec;   /* YANG spec */
+};
 
+/*! Order NACM read targets on node pointer
  */
 static int
-nacm_data_read_action(cxobj *xrule,
-                      cxobj *xn)
+nacm_read_target_cmp(const void *a,
+                     const void *b)
 {
-    int   retval = -1;
-    char *action;
+    const struct nacm_read_target *ta = a;
+    const struct nacm_read_target *tb = b;
 
-    if ((action = xml_find_body(xrule, "action")) != NULL){
-        if (strcmp(action, "deny")==0)
-            xml_flag_set(xn, XML_FLAG_DEL);
-        else if (strcmp(action, "permit")==0)
-            xml_flag_set(xn, XML_FLAG_MARK);
-    }
-    retval = 0;
-    //done:
-    return retval;
+    if (ta->rt_x < tb->rt_x)
+        return -1;
+    if (ta->rt_x > tb->rt_x)
+        return 1;
+    return ta->rt_rule - tb->rt_rule;
 }
 
-/*! Match specific rule to specific requested node
+/*! Compile prepared NACM read rules into a rule table and a sorted target vector
  *
- * @param[in]  xn       XML node (requested node)
- * @param[in]  xrule    NACM rule
+ * Rules without module-name never match and are skipped.
+ * @param[in]  pv_list  Prepared rules and paths, see nacm_datanode_prepare
  * @param[in]  yspec    YANG spec
- * @retval     1        OK and rule matches
- * @retval     0        OK and rule does not match
+ * @param[out] rt       Rule table, free with nacm_read_table_free
+ * @retval     0        OK
  * @retval    -1        Error
- * Two distinct cases:
- * (1) read_default is permit
- *     mark all deny rules and remove them
- * (2) read_default is deny:
- *     mark all permit rules and ancestors, remove everything else
  */
 static int
-nacm_data_read_xrule_xml(cxobj        *xn,
-                         cxobj        *xrule,
-                         clixon_xvec  *xpathvec,
-                         yang_stmt    *yspec)
+nacm_read_compile(prepvec                *pv_list,
+                  yang_stmt              *yspec,
+                  struct nacm_read_table *rt)
 {
-    int        retval = -1;
-    yang_stmt *ymod;
-    char      *module_pattern; /* rule module name */
-    cxobj     *xp;
-    int        i;
+    int                    retval = -1;
+    prepvec               *pv;
+    int                    n = 0;
+    int                    t = 0;
+    int                    i;
+    char                  *module;
+    char                  *action;
+    struct nacm_read_rule *rr;
 
-    if ((module_pattern = xml_find_body(xrule, "module-name")) == NULL)
-        goto nomatch;
-    /* 6a) The rule's "module-name" leaf is "*" or equals the name of
-     * the YANG module where the requested data node is defined. 
-     */
-    if (strcmp(module_pattern, "*") != 0){
-        if (ys_module_by_xml(yspec, xn, &ymod) < 0)
-            goto done;
-        if (strcmp(yang_argument_get(ymod), module_pattern) != 0)
-            goto nomatch;
+    memset(rt, 0, sizeof(*rt));
+    rt->rt_yspec = yspec;
+    rt->rt_ymodrule = -1;
+    if ((pv = pv_list) != NULL){
+        do {
+            n++;
+            t += clixon_xvec_len(pv->pv_xpathvec);
+            pv = NEXTQ(prepvec *, pv);
+        } while (pv && pv != pv_list);
     }
-    /*  6b) Either (1) the rule does not have a "rule-type" defined or
-        (2) the "rule-type" is "data-node" and the "path" matches the
-        requested data node, action node, or notification node. */    
-    if (xml_find_type(xrule, NULL, "path", CX_ELMNT) == NULL){
-        if (nacm_data_read_action(xrule, xn) < 0)
-            goto done;
-        goto match;
+    if (n == 0)
+        goto ok;
+    if ((rt->rt_rules = calloc(n, sizeof(*rt->rt_rules))) == NULL ||
+        (t && (rt->rt_targets = calloc(t, sizeof(*rt->rt_targets))) == NULL) ||
+        (t && (rt->rt_active = calloc(t, sizeof(*rt->rt_active))) == NULL)){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
     }
-    for (i=0; i<clixon_xvec_len(xpathvec); i++){
-        xp = clixon_xvec_i(xpathvec, i);
-        /* Check if ancestor is xp (for every xpathvec?) */
-        if (xn == xp || xml_isancestor(xn, xp)){
-            if (nacm_data_read_action(xrule, xn) < 0)
-                goto done;
-            goto match;
+    pv = pv_list;
+    do {
+        if ((module = xml_find_body(pv->pv_xrule, "module-name")) != NULL){
+            rr = &rt->rt_rules[rt->rt_rlen];
+            rr->rr_module = strcmp(module, "*")==0 ? NULL : module;
+            rr->rr_path = xml_find_type(pv->pv_xrule, NULL, "path", CX_ELMNT) != NULL;
+            if ((action = xml_find_body(pv->pv_xrule, "action")) != NULL){
+                if (strcmp(action, "deny") == 0)
+                    rr->rr_flag = XML_FLAG_DEL;
+                else if (strcmp(action, "permit") == 0)
+                    rr->rr_flag = XML_FLAG_MARK;
+            }
+            if (rr->rr_path)
+                for (i=0; i<clixon_xvec_len(pv->pv_xpathvec); i++){
+                    rt->rt_targets[rt->rt_tlen].rt_x = clixon_xvec_i(pv->pv_xpathvec, i);
+                    rt->rt_targets[rt->rt_tlen++].rt_rule = rt->rt_rlen;
+                }
+            rt->rt_rlen++;
         }
-    }
- nomatch:
+        pv = NEXTQ(prepvec *, pv);
+    } while (pv && pv != pv_list);
+    if (rt->rt_tlen > 1)
+        qsort(rt->rt_targets, rt->rt_tlen, sizeof(*rt->rt_targets), nacm_read_target_cmp);
+ ok:
     retval = 0;
  done:
     return retval;
- match:
-    retval = 1; /* match */
-    goto done;
 }
 
-/*! Recursive check for NACM read rules among all XML nodes
+/*! Free NACM read rule table contents
+ */
+static void
+nacm_read_table_free(struct nacm_read_table *rt)
+{
+    if (rt->rt_rules)
+        free(rt->rt_rules);
+    if (rt->rt_targets)
+        free(rt->rt_targets);
+    if (rt->rt_active)
+        free(rt->rt_active);
+}
+
+/*! Check if NACM read rule module-name matches module of node
  *
- * @param[in]  h        Clixon handle
+ * @param[in]  rr    Rule
+ * @param[in]  ymod  Module of node (or NULL)
+ * @retval     1     Match
+ * @retval     0     No match
+ */
+static int
+nacm_read_rule_module(struct nacm_read_rule *rr,
+                      yang_stmt             *ymod)
+{
+    /* 6a) The rule's "module-name" leaf is "*" or equals the name of
+     * the YANG module where the requested data node is defined.
+     */
+    if (rr->rr_module == NULL)
+        return 1;
+    return ymod != NULL && strcmp(yang_argument_get(ymod), rr->rr_module) == 0;
+}
+
+/*! Find first target of node in sorted target vector
+ *
+ * @param[in]  rt   Compiled rule table
+ * @param[in]  xn   XML node
+ * @retval     i    Index of first target >= xn, or rt_tlen
+ */
+static int
+nacm_read_target_first(struct nacm_read_table *rt,
+                       cxobj                  *xn)
+{
+    int lo = 0;
+    int hi = rt->rt_tlen;
+    int mid;
+
+    while (lo < hi){
+        mid = (lo + hi) / 2;
+        if (rt->rt_targets[mid].rt_x < xn)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/*! Recursive check for NACM read rules among all XML nodes using compiled rules
+ *
+ * Each node is decided by the first rule, in rule order, that matches:
+ * either a rule without path, or a rule with a path whose target is the node or an
+ * ancestor. Targets of ancestors are inherited on a stack, so that each node is checked
+ * against few rules instead of all rules and targets.
+ * Denied nodes are flagged with XML_FLAG_DEL and purged, permitted with XML_FLAG_MARK.
  * @param[in]  xn       XML node (requested node)
- * @param[in]  pv_list  Precomputed rules + paths that apply to this user group
- * @param[in]  yspec    YANG spec
+ * @param[in]  rt       Compiled rule table
+ * @param[in]  nactive  Number of inherited rules on active stack
  * @retval     0        OK
  * @retval    -1        Error
  */
 static int
-nacm_datanode_read_recurse(clixon_handle h,
-                           cxobj        *xn,
-                           prepvec      *pv_list,
-                           yang_stmt    *yspec)
+nacm_datanode_read_recurse(cxobj                  *xn,
+                           struct nacm_read_table *rt,
+                           int                     nactive)
 {
-    int      retval = -1;
-    cxobj   *x;
-    cxobj   *xprev;
-    int      ret;
-    prepvec *pv;
+    int        retval = -1;
+    cxobj     *x;
+    cxobj     *xprev;
+    yang_stmt *ymod = NULL;
+    int        best = INT_MAX;
+    int        i;
 
+    /* Push rules with paths targeting this node */
+    for (i=nacm_read_target_first(rt, xn); i<rt->rt_tlen && rt->rt_targets[i].rt_x == xn; i++)
+        rt->rt_active[nactive++] = rt->rt_targets[i].rt_rule;
     if (xml_spec(xn)){ /* Check this node */
-        pv = pv_list;
-        if (pv){
-            do {
-                if ((ret = nacm_data_read_xrule_xml(xn,
-                                                    pv->pv_xrule,
-                                                    pv->pv_xpathvec,
-                                                    yspec)) < 0)
-                    goto done;
-                if (ret == 1)
-                    break; /* stop at first match */
-                pv = NEXTQ(prepvec *, pv);
-            } while (pv && pv != pv_list);
+        if (ys_module_by_xml(rt->rt_yspec, xn, &ymod) < 0)
+            goto done;
+        for (i=0; i<nactive; i++)
+            if (rt->rt_active[i] < best &&
+                nacm_read_rule_module(&rt->rt_rules[rt->rt_active[i]], ymod))
+                best = rt->rt_active[i];
+        /* First pathless rule matching module, cached per module */
+        if (rt->rt_ymodrule == -1 || ymod != rt->rt_ymod){
+            rt->rt_ymod = ymod;
+            rt->rt_ymodrule = INT_MAX;
+            for (i=0; i<rt->rt_rlen; i++)
+                if (!rt->rt_rules[i].rr_path &&
+                    nacm_read_rule_module(&rt->rt_rules[i], ymod)){
+                    rt->rt_ymodrule = i;
+                    break;
+                }
         }
-
-#if 0 /* 6(A) in algorithm
-       * If N did not match any rule R, and default rule is deny, remove that subtree */
-        if (strcmp(read_default, "deny") == 0)
-            if (xml_tree_prune_flagged_sub(xt, XML_FLAG_MARK, 1, NULL) < 0)
-                goto done;
-#endif
+        if (rt->rt_ymodrule < best)
+            best = rt->rt_ymodrule;
+        if (best != INT_MAX && rt->rt_rules[best].rr_flag)
+            xml_flag_set(xn, rt->rt_rules[best].rr_flag);
     }
-
     /* If node should be purged, dont recurse and defer removal to caller */
     if (xml_flag(xn, XML_FLAG_DEL) == 0){
         x = NULL;       /* Recursively check XML */
         xprev = NULL;
         while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
-            if (nacm_datanode_read_recurse(h, x, pv_list, yspec) < 0)
+            if (nacm_datanode_read_recurse(x, rt, nactive) < 0)
                 goto done;
             /* check for delayed remove */
             if (xml_flag(x, XML_FLAG_DEL)){
                 if (xml_purge(x) < 0)
                     goto done;
                 x = xprev;
+                continue;
             }
+            xprev = x;
         }
     }
     retval = 0;
@@ -1013,6 +1219,7 @@ nacm_datanode_read(clixon_handle h,
     char           *read_default = NULL;
     cvec           *nsc = NULL;
     prepvec        *pv_list = NULL;
+    struct nacm_read_table rt = {0,};
 
     /* Create namespace context for with nacm namespace as default */
     if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
@@ -1024,17 +1231,14 @@ nacm_datanode_read(clixon_handle h,
        transport layer.)               */
     if (username == NULL)
         goto step9;
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
-        goto done;
-    /* 4. If no groups are found (glen=0), continue and check read-default 
-          in step 11. */
-    /* 5. Process all rule-list entries, in the order they appear in the
+    /* User's group and 5. rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
         entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
+    if (nacm_user_rulelists(xnacm, nsc, username, &gvec, &glen, &rlistvec, &rlistlen) < 0)
         goto done;
+    /* 4. If no groups are found (glen=0), continue and check read-default 
+          in step 11. */
     /* read-default has default permit so should never be NULL */
     if ((read_default = xml_find_body(xnacm, "read-default")) == NULL){
         clixon_err(OE_XML, EINVAL, "No nacm read-default rule");
@@ -1043,10 +1247,13 @@ nacm_datanode_read(clixon_handle h,
     /* First run through rules and cache rules as well as lookup objects in xt. 
      * DANGER: objects could be stale if they are removed?
      */
-    if (nacm_datanode_prepare(h, xt, NACM_READ, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, NACM_READ, rlistvec, rlistlen, nsc, &pv_list) < 0)
+        goto done;
+    /* Compile rules into a table and sort rule targets for lookup during traversal */
+    if (nacm_read_compile(pv_list, clicon_dbspec_yang(h), &rt) < 0)
         goto done;
-    /* Then recursivelyy traverse all nodes */
-    if (nacm_datanode_read_recurse(h, xt, pv_list, clicon_dbspec_yang(h)) < 0)
+    /* Then recursively traverse all nodes */
+    if (nacm_datanode_read_recurse(xt, &rt, 0) < 0)
         goto done;
 #if 1
     /* Step 8(B) above:
@@ -1077,6 +1284,7 @@ nacm_datanode_read(clixon_handle h,
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_NACM, "retval:%d", retval);
+    nacm_read_table_free(&rt);
     if (pv_list)
         prepvec_free(pv_list);
     if (nsc)
@@ -1189,45 +1397,180 @@ nacm_access_check(clixon_handle h,
     goto done;
 }
 
-/*! NACM intial pre- access control enforcements
+/* Statistics of NACM running cache, see nacm_running_get */
+static uint64_t _nacm_cache_hits = 0;
+static uint64_t _nacm_cache_misses = 0;
+
+/*! Get NACM config tree from running, cached until NACM config in running changes
  *
- * Initial NACM steps and common to all NACM access validation.
- * If retval=0 continue with next NACM step, eg rpc, module, 
- * etc. If retval = 1 access is OK and skip next NACM step.
+ * @param[in]  h      Clixon handle
+ * @param[out] xtp    Top of running tree with nacm only (or NULL). Direct pointer, do not free
+ * @param[out] cbret  Error if ret == 0
+ * @retval     1      OK
+ * @retval     0      Failed on reading NACM from running, cbret has error
+ * @retval    -1      Error
+ * @see nacm_cache_reset  Invalidate cache
+ */
+static int
+nacm_running_get(clixon_handle h,
+                 cxobj       **xtp,
+                 cbuf         *cbret)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    cxobj *xerr = NULL;
+    int    ret;
+
+    if (clicon_ptr_get(h, "nacm_running", (void**)&xt) == 0 && xt != NULL){
+        _nacm_cache_hits++;
+        *xtp = xt;
+        goto ok;
+    }
+    _nacm_cache_misses++;
+    if ((ret = xmldb_get0(h, "running", YB_MODULE, NULL, "nacm", 1, 0, &xt, NULL, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        goto fail;
+    }
+    if (xt != NULL && clicon_ptr_set(h, "nacm_running", xt) < 0)
+        goto done;
+    *xtp = xt;
+    xt = NULL;
+ ok:
+    retval = 1;
+ done:
+    if (xt)
+        xml_free(xt);
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Invalidate cached NACM config of running
+ *
+ * Called by the datastore when NACM config in running may have changed.
+ * Also clears the groups and rule-lists cached per user, see nacm_user_rulelists.
+ * The tree may still be in use by the current request, it is kept until the request
+ * is done, see nacm_cache_release.
+ * @param[in]  h      Clixon handle
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see nacm_running_get
+ */
+int
+nacm_cache_reset(clixon_handle h)
+{
+    cxobj *xt = NULL;
+    cxobj *xold = NULL;
+
+    nacm_user_cache_clear();
+    if (clicon_ptr_get(h, "nacm_running", (void**)&xt) == 0 && xt != NULL){
+        clicon_ptr_del(h, "nacm_running");
+        /* Several trees may be invalidated during one request */
+        if (clicon_ptr_get(h, "nacm_running_old", (void**)&xold) < 0 || xold == NULL){
+            if ((xold = xml_new("nacm_running_old", NULL, CX_ELMNT)) == NULL){
+                xml_free(xt);
+                return -1;
+            }
+            if (clicon_ptr_set(h, "nacm_running_old", xold) < 0){
+                xml_free(xold);
+                xml_free(xt);
+                return -1;
+            }
+        }
+        if (xml_addsub(xold, xt) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/*! Free NACM config trees invalidated during a request
+ *
+ * Call at request boundaries, when no NACM tree from nacm_access_pre_cached is in use
+ * @param[in]  h      Clixon handle
+ * @retval     0      OK
+ * @see nacm_cache_reset
+ */
+int
+nacm_cache_release(clixon_handle h)
+{
+    cxobj *xold = NULL;
+
+    if (clicon_ptr_get(h, "nacm_running_old", (void**)&xold) == 0 && xold != NULL){
+        xml_free(xold);
+        clicon_ptr_del(h, "nacm_running_old");
+    }
+    return 0;
+}
+
+/*! Free cached NACM config of running, on exit
+ *
+ * @param[in]  h      Clixon handle
+ * @retval     0      OK
+ */
+int
+nacm_cache_exit(clixon_handle h)
+{
+    cxobj *xt = NULL;
+
+    nacm_cache_release(h);
+    nacm_user_cache_clear();
+    if (clicon_ptr_get(h, "nacm_running", (void**)&xt) == 0 && xt != NULL){
+        xml_free(xt);
+        clicon_ptr_del(h, "nacm_running");
+    }
+    return 0;
+}
+
+/*! Get statistics of the NACM running cache
+ *
+ * @param[out] hits    Number of lookups served from cache
+ * @param[out] misses  Number of lookups read from running
+ * @retval     0       OK
+ */
+int
+nacm_cache_stats(uint64_t *hits,
+                 uint64_t *misses)
+{
+    *hits = _nacm_cache_hits;
+    *misses = _nacm_cache_misses;
+    return 0;
+}
+
+/*! NACM intial pre- access control enforcements, direct pointer to NACM tree
+ *
+ * Same as nacm_access_pre but the NACM tree is not copied.
+ * In internal mode it is kept in a cache until NACM config in running changes, in
+ * external mode it is the external tree.
  * @param[in]  h        Clixon handle
  * @param[in]  peername Peer username if any
  * @param[in]  username User name of requestor
- * @param[out] xnacm    NACM XML tree, set if retval=0. Free after use
+ * @param[out] xnacm    NACM XML tree, set if retval=0. Direct pointer, do not free.
+ *                      Only valid until datastore running or NACM external tree is changed
  * @param[out] cbret    Error if ret == 2
  * @retval     2        Failed on reading NACM from running (internal), cbret has error
  * @retval     1        OK permitted. You do not need to do next NACM step.
  * @retval     0        OK but not validated. Need to do NACM step using xnacm
  * @retval    -1        Error
- * @code
- *   cxobj *xnacm = NULL;
- *   if ((ret = nacm_access_pre(h, peername, username, &xnacm)) < 0)
- *     err;
- *   if (ret == 0){
- *      // Next step NACM processing
- *      xml_free(xnacm);
- *   }
- * @endcode
- * @see RFC8341 3.4 Access Control Enforcement Procedures
+ * @see nacm_access_pre
  */
 int
-nacm_access_pre(clixon_handle  h,
-                char          *peername,
-                char          *username,
-                cxobj        **xnacmp,
-                cbuf          *cbret)
+nacm_access_pre_cached(clixon_handle  h,
+                       char          *peername,
+                       char          *username,
+                       cxobj        **xnacmp,
+                       cbuf          *cbret)
 {
     int    retval = -1;
     char  *mode;
-    cxobj *x;
     cxobj *xnacm0 = NULL;
     cxobj *xnacm = NULL;
     cvec  *nsc = NULL;
-    cxobj *xerr = NULL;
     int    ret;
 
     /* Check clixon option: disabled, external tree or internal */
@@ -1236,19 +1579,13 @@ nacm_access_pre(clixon_handle  h,
         goto permit;
     else if (strcmp(mode, "disabled")==0)
         goto permit;
-    else if (strcmp(mode, "external")==0){
-        if ((x = clicon_nacm_ext(h)))
-            if ((xnacm0 = xml_dup(x)) == NULL)
-                goto done;
-    }
+    else if (strcmp(mode, "external")==0)
+        xnacm0 = clicon_nacm_ext(h);
     else if (strcmp(mode, "internal")==0){
-        if ((ret = xmldb_get0(h, "running", YB_MODULE, nsc, "nacm", 1, 0, &xnacm0, NULL, &xerr)) < 0)
+        if ((ret = nacm_running_get(h, &xnacm0, cbret)) < 0)
             goto done;
-        if (ret == 0){
-            if (clixon_xml2cbuf(cbret, xerr, 0, 0, NULL, -1, 0) < 0)
-                goto done;
+        if (ret == 0)
             goto fail;
-        }
     }
     else{
         clixon_err(OE_XML, 0, "Invalid NACM mode: %s", mode);
@@ -1262,25 +1599,19 @@ nacm_access_pre(clixon_handle  h,
     /* If config does not exist then the operation is permitted(?) */
     if ((xnacm = xpath_first(xnacm0, nsc, "nacm")) == NULL)
         goto permit;
-    if (xml_rootchild_node(xnacm0, xnacm) < 0)
-        goto done;
-    xnacm0 = NULL;
+    /* Groups and rule-lists per user are cached for the cached tree of running */
+    if (strcmp(mode, "internal") == 0 && xnacm != _nacm_cache_xnacm){
+        nacm_user_cache_clear();
+        _nacm_cache_xnacm = xnacm;
+    }
     /* Initial NACM steps and common to all NACM access validation. */
     if ((retval = nacm_access_check(h, xnacm, peername, username)) < 0)
         goto done;
-    if (retval == 0){ /* if retval == 0 then return an xml nacm tree */
+    if (retval == 0) /* if retval == 0 then return an xml nacm tree */
         *xnacmp = xnacm;
-        xnacm = NULL;
-    }
  done:
     if (nsc)
         xml_nsctx_free(nsc);
-    if (xnacm0)
-        xml_free(xnacm0);
-    else if (xnacm)
-        xml_free(xnacm);
-    else if (xerr)
-        xml_free(xerr);
     return retval;
  permit:
     retval = 1;
@@ -1290,6 +1621,49 @@ nacm_access_pre(clixon_handle  h,
     goto done;
 }
 
+/*! NACM intial pre- access control enforcements
+ *
+ * Initial NACM steps and common to all NACM access validation.
+ * If retval=0 continue with next NACM step, eg rpc, module, 
+ * etc. If retval = 1 access is OK and skip next NACM step.
+ * @param[in]  h        Clixon handle
+ * @param[in]  peername Peer username if any
+ * @param[in]  username User name of requestor
+ * @param[out] xnacm    NACM XML tree, set if retval=0. Free after use
+ * @param[out] cbret    Error if ret == 2
+ * @retval     2        Failed on reading NACM from running (internal), cbret has error
+ * @retval     1        OK permitted. You do not need to do next NACM step.
+ * @retval     0        OK but not validated. Need to do NACM step using xnacm
+ * @retval    -1        Error
+ * @code
+ *   cxobj *xnacm = NULL;
+ *   if ((ret = nacm_access_pre(h, peername, username, &xnacm)) < 0)
+ *     err;
+ *   if (ret == 0){
+ *      // Next step NACM processing
+ *      xml_free(xnacm);
+ *   }
+ * @endcode
+ * @see RFC8341 3.4 Access Control Enforcement Procedures
+ * @see nacm_access_pre_cached  Without copy
+ */
+int
+nacm_access_pre(clixon_handle  h,
+                char          *peername,
+                char          *username,
+                cxobj        **xnacmp,
+                cbuf          *cbret)
+{
+    int    retval;
+    cxobj *xnacm = NULL;
+
+    if ((retval = nacm_access_pre_cached(h, peername, username, &xnacm, cbret)) == 0){
+        if ((*xnacmp = xml_dup(xnacm)) == NULL)
+            retval = -1;
+    }
+    return retval;
+}
+
 /*! Verify nacm user with peer uid credentials
  *
  * @param[in]  h         Clixon handle
@@ -166,6 +166,197 @@ netconf_input_read2(int            s,
     return retval;
 }
 
+/*! Append input data to cbuf in bulk, skipping NULL chars
+ *
+ * @param[in]  cb    Buffer to append to
+ * @param[in]  buf   Input data
+ * @param[in]  len   Length of input data
+ * @retval     n     Number of non-NULL chars appended
+ * @retval    -1     Error
+ */
+static ssize_t
+netconf_input_append(cbuf          *cb,
+                     unsigned char *buf,
+                     size_t         len)
+{
+    unsigned char *p;
+    size_t         n;
+    ssize_t        appended = 0;
+
+    while (len > 0){
+        if ((p = memchr(buf, 0, len)) != NULL)
+            n = p - buf;
+        else
+            n = len;
+        if (n > 0){
+            if (cbuf_append_buf(cb, buf, n) < 0){
+                clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+                return -1;
+            }
+            appended += n;
+        }
+        if (p != NULL) /* Skip NULL chars (eg from terminals) */
+            n++;
+        buf += n;
+        len -= n;
+    }
+    return appended;
+}
+
+/*! Look for a text pattern in an input string, one char at a time, with overlapping prefixes
+ *
+ * As detect_endtag but a mismatch falls back to the longest matching prefix of tag instead of
+ * restarting, so that eg "]]]>]]>" is detected
+ * @param[in]  tag    What to look for
+ * @param[in]  ch     New input character
+ * @param[in]  state  Number of chars in tag matched so far
+ * @retval     state  New number of chars matched, strlen(tag) if found
+ */
+static int
+detect_endtag_next(const char *tag,
+                   char        ch,
+                   int         state)
+{
+    int k;
+
+    while (tag[state] != ch){
+        if (state == 0)
+            return 0;
+        /* Longest proper suffix of matched part that is also a prefix of tag */
+        for (k = state-1; k > 0; k--)
+            if (strncmp(tag + state - k, tag, k) == 0)
+                break;
+        state = k;
+    }
+    return state + 1;
+}
+
+/*! Get netconf message using NETCONF EOM framing, scanning input in bulk
+ *
+ * Input data between "]" chars is appended in bulk, only around possible end-of-message
+ * markers is input examined one char at a time.
+ * @param[in]     buf          Input data
+ * @param[in]     len          Data len
+ * @param[in,out] cbmsg        Completed frame (if eom), may contain data on entry
+ * @param[in,out] frame_state  Number of chars of end-of-message marker matched
+ * @param[out]    eom          If frame found in cb?
+ * @retval        n            Number of input chars consumed
+ * @retval       -1            Error
+ */
+static ssize_t
+netconf_input_eom(unsigned char *buf,
+                  size_t         len,
+                  cbuf          *cbmsg,
+                  int           *frame_state,
+                  int           *eom)
+{
+    const char    *tag = "]]>]]>";
+    int            taglen = strlen(tag);
+    size_t         i = 0;
+    unsigned char *p;
+    size_t         n;
+    char           ch;
+
+    *eom = 0;
+    while (i < len){
+        if (*frame_state == 0){
+            /* Bulk append up to next possible start of end-of-message marker */
+            if ((p = memchr(buf+i, tag[0], len-i)) != NULL)
+                n = p - (buf+i);
+            else
+                n = len-i;
+            if (n > 0){
+                if (netconf_input_append(cbmsg, buf+i, n) < 0)
+                    return -1;
+                i += n;
+                continue;
+            }
+        }
+        if ((ch = buf[i++]) == 0)
+            continue; /* Skip NULL chars (eg from terminals) */
+        if (cbuf_append(cbmsg, ch) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append");
+            return -1;
+        }
+        *frame_state = detect_endtag_next(tag, ch, *frame_state);
+        if (*frame_state == taglen){
+            *frame_state = 0;
+            /* OK, we have an xml string from a client */
+            /* Remove trailer */
+            *(((char*)cbuf_get(cbmsg)) + cbuf_len(cbmsg) - taglen) = '\0';
+            *eom = 1;
+            break;
+        }
+    }
+    return i;
+}
+
+/*! Get netconf message using NETCONF chunked framing, copying chunk-data in bulk
+ *
+ * Chunk headers and trailers are parsed one char at a time, chunk-data is appended in bulk
+ * @param[in]     buf          Input data
+ * @param[in]     len          Data len
+ * @param[in,out] cbmsg        Completed frame (if eom), may contain data on entry
+ * @param[in,out] frame_state  Chunked framing state
+ * @param[in,out] frame_size   Remaining chunk-data size
+ * @param[out]    eom          If frame found in cb?
+ * @retval        n            Number of input chars consumed
+ * @retval       -1            Error (framing error)
+ * @see netconf_input_chunked_framing
+ */
+static ssize_t
+netconf_input_chunked(unsigned char *buf,
+                      size_t         len,
+                      cbuf          *cbmsg,
+                      int           *frame_state,
+                      size_t        *frame_size,
+                      int           *eom)
+{
+    size_t         i = 0;
+    size_t         n;
+    unsigned char *p;
+    char           ch;
+    int            ret;
+
+    *eom = 0;
+    while (i < len){
+        if (*frame_state == 4 && *frame_size > 0){
+            /* chunk-data: append in bulk up to end of chunk, NULL chars not counted */
+            n = *frame_size < len-i ? *frame_size : len-i;
+            if ((p = memchr(buf+i, 0, n)) != NULL)
+                n = p - (buf+i);
+            if (n > 0){
+                if (cbuf_append_buf(cbmsg, buf+i, n) < 0){
+                    clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+                    return -1;
+                }
+                *frame_size -= n;
+                i += n;
+                continue;
+            }
+        }
+        if ((ch = buf[i++]) == 0)
+            continue; /* Skip NULL chars (eg from terminals) */
+        /* Track chunked framing defined in RFC6242 */
+        if ((ret = netconf_input_chunked_framing(ch, frame_state, frame_size)) < 0)
+            return -1;
+        switch (ret){
+        case 1: /* chunk-data */
+            cbuf_append(cbmsg, ch);
+            break;
+        case 2: /* end-of-data */
+            /* Somewhat complex error-handling:
+             * Ignore packet errors, UNLESS an explicit termination request (eof)
+             */
+            *eom = 1;
+            return i;
+        default:
+            break;
+        }
+    }
+    return i;
+}
+
 /*! Get netconf message using NETCONF framing
  *
  * @param[in,out] bufp         Input data, incremented as read
@@ -192,54 +383,18 @@ netconf_input_msg2(unsigned char      **bufp,
                    size_t              *frame_size,
                    int                 *eom)
 {
-    int       retval = -1;
-    int       i;
-    int       ret;
-    int       found = 0;
-    size_t    len;
-    char      ch;
+    int     retval = -1;
+    ssize_t n;
 
     clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "");
-    len = *lenp;
-    for (i=0; i<len; i++){
-        if ((ch = (*bufp)[i]) == 0)
-            continue; /* Skip NULL chars (eg from terminals) */
-        if (framing_type == NETCONF_SSH_CHUNKED){
-            /* Track chunked framing defined in RFC6242 */
-            if ((ret = netconf_input_chunked_framing(ch, frame_state, frame_size)) < 0)
-                goto done;
-            switch (ret){
-            case 1: /* chunk-data */
-                cbuf_append(cbmsg, ch);
-                break;
-            case 2: /* end-of-data */
-                /* Somewhat complex error-handling:
-                 * Ignore packet errors, UNLESS an explicit termination request (eof)
-                 */
-                found++;
-                break;
-            default:
-                break;
-            }
-        }
-        else{
-            cbuf_append(cbmsg, ch);
-            if (detect_endtag("]]>]]>", ch, frame_state)){
-                *frame_state = 0;
-                /* OK, we have an xml string from a client */
-                /* Remove trailer */
-                *(((char*)cbuf_get(cbmsg)) + cbuf_len(cbmsg) - strlen("]]>]]>")) = '\0';
-                found++;
-            }
-        }
-        if (found){
-            i++;
-            break;
-        }
-    } /* for */
-    *bufp += i;
-    *lenp -= i;
-    *eom = found;
+    if (framing_type == NETCONF_SSH_CHUNKED)
+        n = netconf_input_chunked(*bufp, *lenp, cbmsg, frame_state, frame_size, eom);
+    else
+        n = netconf_input_eom(*bufp, *lenp, cbmsg, frame_state, eom);
+    if (n < 0)
+        goto done;
+    *bufp += n;
+    *lenp -= n;
     retval = 0;
  done:
     clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "retval:%d", retval);
@@ -138,6 +138,7 @@ static const map_str2int _FORMATS[] = {
     {"netconf",          FORMAT_NETCONF},
     {"default",          FORMAT_DEFAULT},
     {"pipe-xml-default", FORMAT_PIPE_XML_DEFAULT},
+    {"binary",           FORMAT_BINARY},
     {NULL,      -1}
 };
 
@@ -57,6 +57,8 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/param.h>
+#include <sys/uio.h>
+#include <poll.h>
 #include <netinet/in.h>
 #include <sys/un.h>
 #include <arpa/inet.h>
@@ -396,12 +398,15 @@ clixon_msg_rcv10(int         s,
                  cbuf       *cb,
                  int        *eof)
 {
-    int           retval = -1;
-    unsigned char buf[BUFSIZ];
-    int           i;
-    int           len;
-    int           xml_state = 0;
-    int           poll;
+    int            retval = -1;
+    unsigned char  buf[BUFSIZ];
+    unsigned char *p;
+    size_t         plen;
+    ssize_t        len;
+    int            xml_state = 0;
+    size_t         frame_size = 0;
+    int            eom = 0;
+    int            poll;
 
     clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "");
     *eof = 0;
@@ -409,19 +414,13 @@ clixon_msg_rcv10(int         s,
     while (1){
         if ((len = netconf_input_read2(s, buf, sizeof(buf), eof)) < 0)
             goto done;
-        for (i=0; i<len; i++){
-            if (buf[i] == 0)
-                continue; /* Skip NULL chars (eg from terminals) */
-            cprintf(cb, "%c", buf[i]);
-            if (detect_endtag("]]>]]>",
-                              buf[i],
-                              &xml_state)) {
-                /* OK, we have an xml string from a client */
-                /* Remove trailer */
-                *(((char*)cbuf_get(cb)) + cbuf_len(cb) - strlen("]]>]]>")) = '\0';
-                goto ok;
-            }
-        }
+        p = buf;
+        plen = len;
+        if (netconf_input_msg2(&p, &plen, cb, NETCONF_SSH_EOM,
+                               &xml_state, &frame_size, &eom) < 0)
+            goto done;
+        if (eom)
+            goto ok;
         /* poll==1 if more, poll==0 if none */
         if ((poll = clixon_event_poll(s)) < 0)
             goto done;
@@ -710,8 +709,101 @@ clicon_rpc(int                sock,
     return retval;
 }
 
+/*! Write all of an io vector to a socket
+ *
+ * Same as atomicio for write but gathers several buffers in one system call
+ * @param[in]  s       Socket
+ * @param[in]  iov     IO vector, modified
+ * @param[in]  iovcnt  Number of buffers in iov
+ * @retval     0       OK, or peer closed socket
+ * @retval    -1       Error
+ * @see atomicio
+ */
+static int
+atomicio_writev(int           s,
+                struct iovec *iov,
+                int           iovcnt)
+{
+    ssize_t       res;
+    struct pollfd pfd = {s, POLLOUT, 0};
+
+    while (iovcnt > 0){
+        if ((res = writev(s, iov, iovcnt)) < 0){
+            if (errno == EINTR)
+                continue;
+            else if (errno == EAGAIN || errno == EWOULDBLOCK){
+                /* Non-blocking socket is full, wait until writable */
+                if (poll(&pfd, 1, -1) < 0 && errno != EINTR){
+                    clixon_err(OE_CFG, errno, "poll");
+                    return -1;
+                }
+                continue;
+            }
+            else if (errno == ECONNRESET || errno == EPIPE || errno == EBADF)
+                return 0;
+            clixon_err(OE_CFG, errno, "writev");
+            clixon_log(NULL, LOG_WARNING, "%s: writev: %s", __FUNCTION__, strerror(errno));
+            return -1;
+        }
+        while (iovcnt > 0 && res >= (ssize_t)iov->iov_len){
+            res -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0){
+            iov->iov_base = (char*)iov->iov_base + res;
+            iov->iov_len -= res;
+        }
+    }
+    return 0;
+}
+
+/*! Send data as one NETCONF 1.1 chunk, optionally followed by end-of-chunks
+ *
+ * Data is written directly from the caller's buffer without copying
+ * @param[in]  s       Socket to communicate with client
+ * @param[in]  descr   Description of peer for logging
+ * @param[in]  data    Data to send
+ * @param[in]  datalen Length of data, if 0 only end-of-chunks may be sent
+ * @param[in]  eom     If set, end message with end-of-chunks
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+clixon_msg_send_chunk(int         s,
+                      const char *descr,
+                      char       *data,
+                      size_t      datalen,
+                      int         eom)
+{
+    struct iovec iov[3];
+    int          iovcnt = 0;
+    char         hdr[32];
+
+    if (clixon_debug_detail())
+        clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_DETAIL, "Send [%s] %.*s",
+                     descr?descr:"", (int)datalen, data);
+    else
+        clixon_debug(CLIXON_DBG_MSG | CLIXON_DBG_TRUNC, "Send [%s] %.*s",
+                     descr?descr:"", (int)datalen, data);
+    if (datalen){ /* RFC6242: chunk-size is at least 1 */
+        snprintf(hdr, sizeof(hdr), "\n#%zu\n", datalen);
+        iov[iovcnt].iov_base = hdr;
+        iov[iovcnt++].iov_len = strlen(hdr);
+        iov[iovcnt].iov_base = data;
+        iov[iovcnt++].iov_len = datalen;
+    }
+    if (eom){
+        iov[iovcnt].iov_base = "\n##\n";
+        iov[iovcnt++].iov_len = strlen("\n##\n");
+    }
+    return atomicio_writev(s, iov, iovcnt);
+}
+
 /*! Send a clicon_msg message as reply to a clicon rpc request
  *
+ * If parts of the reply have already been sent with send_msg_reply_chunk, this sends the
+ * remainder and ends the message.
  * @param[in]  s       Socket to communicate with client
  * @param[in]  descr   Description of peer for logging
  * @param[in]  data    Returned data as byte-string.
@@ -725,55 +817,48 @@ send_msg_reply(int         s,
                char       *data,
                uint32_t    datalen)
 {
-    int                retval = -1;
-    cbuf          *cb = NULL;
+    return clixon_msg_send_chunk(s, descr, data, strnlen(data, datalen), 1);
+}
 
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
-    if (cbuf_append_buf(cb, data, datalen) < 0){
-        clixon_err(OE_UNIX, errno, "cbuf_append_buf");
-        goto done;
-    }
-    if (clixon_msg_send11(s, descr, cb) < 0)
-        goto done;
-    retval = 0;
- done:
-    if (cb)
-        cbuf_free(cb);
-    return retval;
+/*! Send part of a reply to a clicon rpc request as a NETCONF 1.1 chunk
+ *
+ * Used to stream large replies in bounded pieces. The reply is ended by send_msg_reply.
+ * @param[in]  s       Socket to communicate with client
+ * @param[in]  descr   Description of peer for logging
+ * @param[in]  data    Part of reply data
+ * @param[in]  datalen Length of data
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see send_msg_reply
+ */
+int
+send_msg_reply_chunk(int         s,
+                     const char *descr,
+                     char       *data,
+                     size_t      datalen)
+{
+    return clixon_msg_send_chunk(s, descr, data, datalen, 0);
 }
 
 /*! Send a clicon_msg NOTIFY message asynchronously to client
  *
+ * Data is written directly without copying, so the same serialized event can be sent
+ * to several clients
  * @param[in]  s       Socket to communicate with client
  * @param[in]  descr   Description of peer for logging
- * @param[in]  msg    Data string to send
+ * @param[in]  data    Event serialized as XML
+ * @param[in]  datalen Length of data
  * @retval     0       OK
  * @retval    -1       Error
  * @see send_msg_notify_xml
  */
-static int
-send_msg_notify(int         s,
-                const char *descr,
-                char       *msg)
+int
+send_msg_notify_data(int         s,
+                     const char *descr,
+                     const char *data,
+                     size_t      datalen)
 {
-    int   retval = -1;
-    cbuf *cb = NULL;
-
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
-    cprintf(cb, "%s", msg);
-    if (clixon_msg_send11(s, descr, cb) < 0)
-        goto done;
-    retval = 0;
- done:
-    if (cb)
-        cbuf_free(cb);
-    return retval;
+    return clixon_msg_send_chunk(s, descr, (char*)data, datalen, 1);
 }
 
 /*! Send a clicon_msg NOTIFY message asynchronously to client
@@ -784,7 +869,7 @@ send_msg_notify(int         s,
  * @param[in]  xev   Event as XML
  * @retval     0     OK
  * @retval    -1     Error
- * @see send_msg_notify
+ * @see send_msg_notify_data
  */
 int
 send_msg_notify_xml(clixon_handle h,
@@ -801,7 +886,7 @@ send_msg_notify_xml(clixon_handle h,
     }
     if (clixon_xml2cbuf(cb, xev, 0, 0, NULL, -1, 0) < 0)
         goto done;
-    if (send_msg_notify(s, descr, cbuf_get(cb)) < 0)
+    if (send_msg_notify_data(s, descr, cbuf_get(cb), cbuf_len(cb)) < 0)
         goto done;
     retval = 0;
   done:
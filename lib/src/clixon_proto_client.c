@@ -966,65 +966,37 @@ clicon_rpc_get(clixon_handle   h,
     return clicon_rpc_get2(h, xpath, nsc, content, depth, defaults, 1, xt);
 }
 
-/*! Get database configuration and state data (please use instead of clicon_rpc_get)
+/*! Send a get request to the backend and return the reply
  *
  * @param[in]  h         Clixon handle
  * @param[in]  xpath     XPath in a filter stmt (or NULL/"" for no filter)
- * @param[in]  namespace Namespace associated w xpath
  * @param[in]  nsc       Namespace context for filter
  * @param[in]  content   Clixon extension: all, config, noconfig. -1 means all
  * @param[in]  depth     Nr of XML levels to get, -1 is all, 0 is none
  * @param[in]  defaults  Value of the with-defaults mode, rfc6243, or NULL
- * @param[out] xt        XML tree. Free with xml_free. 
- *                       Either <config> or <rpc-error>. 
+ * @param[in]  json      Clixon extension: ask backend to encode data as JSON
+ * @param[in]  pretty    Clixon extension: pretty-print JSON (if json is set)
+ * @param[out] xret      Reply XML tree, not bound to yang. Free with xml_free
  * @retval     0         OK
- * @retval    -1         Error, fatal or xml
- * @note if xpath is set but namespace is NULL, the default, netconf base 
- *       namespace will be used which is most probably wrong.
- * @code
- *  cxobj *xt = NULL;
- *  cvec *nsc = NULL;
- *
- *  if ((nsc = xml_nsctx_init(NULL, "urn:example:hello")) == NULL)
- *     err;
- *  if (clicon_rpc_get(h, "/hello/world", nsc, CONTENT_ALL, -1, &xt) < 0)
- *     err;
- *  if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
- *     clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration");
- *     err;
- *  }
- *  if (xt)
- *     xml_free(xt);
- *  if (nsc)
- *     xml_nsctx_free(nsc);
- * @endcode
- * @see clicon_rpc_get_config which is almost the same as with content=config, but you can also select dbname
- * @see clixon_err_netconf
- * @note the netconf return message is yang populated, as well as the return data
+ * @retval    -1         Error
  */
-int
-clicon_rpc_get2(clixon_handle   h,
-                char           *xpath,
-                cvec           *nsc, /* namespace context for filter */
-                netconf_content content,
-                int32_t         depth,
-                char           *defaults,
-                int             bind,
-                cxobj         **xt)
+static int
+clicon_rpc_get_send(clixon_handle   h,
+                    char           *xpath,
+                    cvec           *nsc,
+                    netconf_content content,
+                    int32_t         depth,
+                    char           *defaults,
+                    int             json,
+                    int             pretty,
+                    cxobj         **xret)
 {
     int                retval = -1;
     struct clicon_msg *msg = NULL;
     cbuf              *cb = NULL;
-    cxobj             *xret = NULL;
-    cxobj             *xerr = NULL;
-    cxobj             *xd = NULL;
     char              *username;
     uint32_t           session_id;
-    int                ret;
-    yang_stmt         *yspec;
-    cvec              *nscd = NULL;
 
-    clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "");
     if (session_id_check(h, &session_id) < 0)
         goto done;
     if ((cb = cbuf_new()) == NULL){
@@ -1051,6 +1023,14 @@ clicon_rpc_get2(clixon_handle   h,
                 CLIXON_LIB_PREFIX,
                 depth,
                 CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+    /* Clixon extension, format=json and pretty */
+    if (json){
+        cprintf(cb, " %s:format=\"json\" xmlns:%s=\"%s\"",
+                CLIXON_LIB_PREFIX,
+                CLIXON_LIB_PREFIX, CLIXON_LIB_NS);
+        if (pretty)
+            cprintf(cb, " %s:pretty=\"true\"", CLIXON_LIB_PREFIX);
+    }
     cprintf(cb, ">"); /* get */
     /* If xpath, add a filter */
     if (xpath && strlen(xpath)) {
@@ -1071,8 +1051,41 @@ clicon_rpc_get2(clixon_handle   h,
     if ((msg = clicon_msg_encode(session_id,
                                  "%s", cbuf_get(cb))) == NULL)
         goto done;
-    if (clicon_rpc_msg(h, msg, &xret) < 0)
+    if (clicon_rpc_msg(h, msg, xret) < 0)
         goto done;
+    retval = 0;
+  done:
+    if (cb)
+        cbuf_free(cb);
+    if (msg)
+        free(msg);
+    return retval;
+}
+
+/*! Extract data or error from a get reply
+ *
+ * @param[in]  h         Clixon handle
+ * @param[in]  xret      Reply XML tree from backend
+ * @param[in]  bind      Bind data to yang
+ * @param[out] xt        XML tree. Free with xml_free.
+ *                       Either <config> or <rpc-error>.
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @see clicon_rpc_get2
+ */
+static int
+clicon_rpc_get_reply(clixon_handle h,
+                     cxobj        *xret,
+                     int           bind,
+                     cxobj       **xt)
+{
+    int        retval = -1;
+    cxobj     *xerr = NULL;
+    cxobj     *xd = NULL;
+    int        ret;
+    yang_stmt *yspec;
+    cvec      *nscd = NULL;
+
     yspec = clicon_dbspec_yang(h);
     /* Send xml error back: first check error, then ok */
     if ((xd = xpath_first(xret, NULL, "/rpc-reply/rpc-error")) != NULL)
@@ -1113,19 +1126,136 @@ clicon_rpc_get2(clixon_handle   h,
     }
     retval = 0;
   done:
-    clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "retval:%d", retval);
     if (nscd)
         cvec_free(nscd);
-    if (cb)
-        cbuf_free(cb);
     if (xerr)
         xml_free(xerr);
+    if (xd && xml_parent(xd) == NULL)
+        xml_free(xd);
+    return retval;
+}
+
+/*! Get database configuration and state data (please use instead of clicon_rpc_get)
+ *
+ * @param[in]  h         Clixon handle
+ * @param[in]  xpath     XPath in a filter stmt (or NULL/"" for no filter)
+ * @param[in]  namespace Namespace associated w xpath
+ * @param[in]  nsc       Namespace context for filter
+ * @param[in]  content   Clixon extension: all, config, noconfig. -1 means all
+ * @param[in]  depth     Nr of XML levels to get, -1 is all, 0 is none
+ * @param[in]  defaults  Value of the with-defaults mode, rfc6243, or NULL
+ * @param[out] xt        XML tree. Free with xml_free. 
+ *                       Either <config> or <rpc-error>. 
+ * @retval     0         OK
+ * @retval    -1         Error, fatal or xml
+ * @note if xpath is set but namespace is NULL, the default, netconf base 
+ *       namespace will be used which is most probably wrong.
+ * @code
+ *  cxobj *xt = NULL;
+ *  cvec *nsc = NULL;
+ *
+ *  if ((nsc = xml_nsctx_init(NULL, "urn:example:hello")) == NULL)
+ *     err;
+ *  if (clicon_rpc_get(h, "/hello/world", nsc, CONTENT_ALL, -1, &xt) < 0)
+ *     err;
+ *  if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
+ *     clixon_err_netconf(h, OE_NETCONF, 0, xerr, "Get configuration");
+ *     err;
+ *  }
+ *  if (xt)
+ *     xml_free(xt);
+ *  if (nsc)
+ *     xml_nsctx_free(nsc);
+ * @endcode
+ * @see clicon_rpc_get_config which is almost the same as with content=config, but you can also select dbname
+ * @see clixon_err_netconf
+ * @note the netconf return message is yang populated, as well as the return data
+ */
+int
+clicon_rpc_get2(clixon_handle   h,
+                char           *xpath,
+                cvec           *nsc, /* namespace context for filter */
+                netconf_content content,
+                int32_t         depth,
+                char           *defaults,
+                int             bind,
+                cxobj         **xt)
+{
+    int    retval = -1;
+    cxobj *xret = NULL;
+
+    clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "");
+    if (clicon_rpc_get_send(h, xpath, nsc, content, depth, defaults, 0, 0, &xret) < 0)
+        goto done;
+    if (clicon_rpc_get_reply(h, xret, bind, xt) < 0)
+        goto done;
+    retval = 0;
+  done:
+    clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "retval:%d", retval);
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
+
+/*! Get database configuration and state data with data encoded as JSON by the backend
+ *
+ * Same as clicon_rpc_get but the backend encodes the data as JSON, which saves
+ * printing, parsing and binding the data tree in the client.
+ * The backend may return XML anyway, eg with depth or report-all-tagged, and then
+ * xt is set as in clicon_rpc_get.
+ * @param[in]  h         Clixon handle
+ * @param[in]  xpath     XPath in a filter stmt (or NULL/"" for no filter)
+ * @param[in]  nsc       Namespace context for filter
+ * @param[in]  content   Clixon extension: all, config, noconfig. -1 means all
+ * @param[in]  depth     Nr of XML levels to get, -1 is all, 0 is none
+ * @param[in]  defaults  Value of the with-defaults mode, rfc6243, or NULL
+ * @param[in]  pretty    Pretty-print JSON
+ * @param[out] cbjson    JSON data is appended here if encoded by backend
+ * @param[out] xt        XML tree if not encoded by backend. Free with xml_free.
+ *                       Either <config> or <rpc-error>.
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @code
+ *  if (clicon_rpc_get_json(h, xpath, nsc, CONTENT_ALL, -1, NULL, 0, cb, &xt) < 0)
+ *     err;
+ *  if (xt == NULL)
+ *     // JSON data in cb
+ * @endcode
+ * @see clicon_rpc_get
+ */
+int
+clicon_rpc_get_json(clixon_handle   h,
+                    char           *xpath,
+                    cvec           *nsc,
+                    netconf_content content,
+                    int32_t         depth,
+                    char           *defaults,
+                    int             pretty,
+                    cbuf           *cbjson,
+                    cxobj         **xt)
+{
+    int    retval = -1;
+    cxobj *xret = NULL;
+    cxobj *xd;
+    char  *format;
+    char  *body;
+
+    clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "");
+    if (clicon_rpc_get_send(h, xpath, nsc, content, depth, defaults, 1, pretty, &xret) < 0)
+        goto done;
+    if ((xd = xpath_first(xret, NULL, "/rpc-reply/data")) != NULL &&
+        (format = xml_find_value(xd, "format")) != NULL &&
+        strcmp(format, "json") == 0){
+        if ((body = xml_body(xd)) != NULL)
+            cbuf_append_str(cbjson, body);
+    }
+    else if (clicon_rpc_get_reply(h, xret, 1, xt) < 0)
+        goto done;
+    retval = 0;
+  done:
+    clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "retval:%d", retval);
     if (xret)
         xml_free(xret);
-    if (msg)
-        free(msg);
-    if (xd)
-        xml_free(xd);
     return retval;
 }
 
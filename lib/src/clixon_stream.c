@@ -82,15 +82,34 @@
 #include "clixon_event.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_xml_io.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_bind.h"
 #include "clixon_options.h"
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_xpath_eval.h"
 #include "clixon_stream.h"
 
 /* Go through and timeout subscription timers [s] */
 #define STREAM_TIMER_TIMEOUT_S 5
 
+/* Initial number of records in replay ring buffer, doubled when full */
+#define STREAM_REPLAY_INIT 16
+
+/* Compiled subscription filter
+ * Subscriptions of a stream with the same filter share one entry, and each event is
+ * matched once per distinct filter.
+ */
+struct stream_filter{
+    qelem_t     sf_q;      /* queue header */
+    char       *sf_xpath;  /* Filter selector as xpath, key */
+    xpath_tree *sf_xpt;    /* Parsed xpath */
+    int         sf_refcnt; /* Number of subscriptions using filter */
+    uint64_t    sf_event;  /* Event number of sf_match */
+    int         sf_match;  /* Match result of event sf_event */
+};
+
 /*! Find an event notification stream given name
  *
  * @param[in]  h    Clixon handle
@@ -115,6 +134,113 @@ stream_find(clixon_handle h,
     return NULL;
 }
 
+/*! Free compiled subscription filter
+ *
+ * @param[in]  sf   Stream filter
+ */
+static void
+stream_filter_free(struct stream_filter *sf)
+{
+    if (sf->sf_xpath)
+        free(sf->sf_xpath);
+    if (sf->sf_xpt)
+        xpath_tree_free(sf->sf_xpt);
+    free(sf);
+}
+
+/*! Get compiled filter of stream given xpath, parse and add if not found
+ *
+ * @param[in]  es    Event stream
+ * @param[in]  xpath Filter selector as xpath
+ * @retval     sf    Stream filter, release with stream_filter_release
+ * @retval     NULL  Error, eg xpath parse error
+ */
+static struct stream_filter *
+stream_filter_get(event_stream_t *es,
+                  const char     *xpath)
+{
+    struct stream_filter *sf;
+
+    if ((sf = es->es_filters) != NULL)
+        do {
+            if (strcmp(sf->sf_xpath, xpath) == 0){
+                sf->sf_refcnt++;
+                return sf;
+            }
+            sf = NEXTQ(struct stream_filter *, sf);
+        } while (sf && sf != es->es_filters);
+    if ((sf = malloc(sizeof(*sf))) == NULL){
+        clixon_err(OE_CFG, errno, "malloc");
+        return NULL;
+    }
+    memset(sf, 0, sizeof(*sf));
+    if ((sf->sf_xpath = strdup(xpath)) == NULL){
+        clixon_err(OE_CFG, errno, "strdup");
+        goto err;
+    }
+    if (xpath_parse(xpath, &sf->sf_xpt) < 0)
+        goto err;
+    sf->sf_refcnt = 1;
+    ADDQ(sf, es->es_filters);
+    return sf;
+ err:
+    stream_filter_free(sf);
+    return NULL;
+}
+
+/*! Release compiled filter of stream, free if not used by any subscription
+ *
+ * @param[in]  es    Event stream
+ * @param[in]  sf    Stream filter
+ */
+static void
+stream_filter_release(event_stream_t       *es,
+                      struct stream_filter *sf)
+{
+    if (--sf->sf_refcnt > 0)
+        return;
+    DELQ(sf, es->es_filters, struct stream_filter *);
+    stream_filter_free(sf);
+}
+
+/*! Match event against compiled filter, evaluated once per event
+ *
+ * @param[in]  es     Event stream
+ * @param[in]  sf     Stream filter
+ * @param[in]  xevent Event as XML
+ * @retval     1      Match
+ * @retval     0      No match
+ * @retval    -1      Error
+ */
+static int
+stream_filter_match(event_stream_t       *es,
+                    struct stream_filter *sf,
+                    cxobj                *xevent)
+{
+    int     retval = -1;
+    xp_ctx  xc = {0,};
+    xp_ctx *xr = NULL;
+
+    if (sf->sf_event != es->es_event_nr){
+        xc.xc_type = XT_NODESET;
+        xc.xc_node = xevent;
+        xc.xc_initial = xevent;
+        if (cxvec_append(xevent, &xc.xc_nodeset, &xc.xc_size) < 0)
+            goto done;
+        if (xp_eval(&xc, sf->sf_xpt, NULL, 0, &xr) < 0)
+            goto done;
+        sf->sf_match = (xr && xr->xc_type == XT_NODESET && xr->xc_size);
+        sf->sf_event = es->es_event_nr;
+    }
+    retval = sf->sf_match;
+ done:
+    if (xc.xc_nodeset)
+        free(xc.xc_nodeset);
+    if (xr)
+        ctx_free(xr);
+    return retval;
+}
+
 /*! Delete event stream core components 
  *
  * @param[in]     es   Event notification stream structure
@@ -122,6 +248,18 @@ stream_find(clixon_handle h,
 static int
 stream_delete(event_stream_t *es)
 {
+    size_t                i;
+    struct stream_filter *sf;
+
+    while ((sf = es->es_filters) != NULL){
+        DELQ(sf, es->es_filters, struct stream_filter *);
+        stream_filter_free(sf);
+    }
+    if (es->es_replay){
+        for (i = 0; i < es->es_replay_nr; i++)
+            free(es->es_replay[(es->es_replay_head + i) % es->es_replay_max].r_data);
+        free(es->es_replay);
+    }
     if (es->es_name)
         free(es->es_name);
     if (es->es_description)
@@ -139,6 +277,8 @@ stream_delete(event_stream_t *es)
  * @param[in]  retention      For replay buffer how much relative to save
  * @retval     0              OK
  * @retval    -1              Error
+ * Replay buffer size is also limited by CLICON_STREAM_REPLAY_MAX_EVENTS and
+ * CLICON_STREAM_REPLAY_MAX_BYTES
  */
 int
 stream_add(clixon_handle   h,
@@ -168,6 +308,10 @@ stream_add(clixon_handle   h,
     es->es_replay_enabled = replay_enabled;
     if (retention)
         es->es_retention = *retention;
+    if (clicon_option_exists(h, "CLICON_STREAM_REPLAY_MAX_EVENTS"))
+        es->es_replay_maxnr = clicon_option_int(h, "CLICON_STREAM_REPLAY_MAX_EVENTS");
+    if (clicon_option_exists(h, "CLICON_STREAM_REPLAY_MAX_BYTES"))
+        es->es_replay_maxbytes = clicon_option_int(h, "CLICON_STREAM_REPLAY_MAX_BYTES");
     clicon_stream_append(h, es);
     es = NULL;
  ok:
@@ -190,7 +334,6 @@ stream_delete_all(clixon_handle h,
                   int           force)
 {
     int                   retval = -1;
-    struct stream_replay *r;
     struct stream_subscription *ss;
     event_stream_t       *es;
     event_stream_t       *head = clicon_stream(h);
@@ -202,12 +345,6 @@ stream_delete_all(clixon_handle h,
             if (stream_ss_rm(h, es, ss, force) < 0)
                 goto done;
         }
-        while ((r = es->es_replay) != NULL){
-            DELQ(r, es->es_replay, struct stream_replay *);
-            if (r->r_xml)
-                xml_free(r->r_xml);
-            free(r);
-        }
         if (stream_delete(es) < 0)
             goto done;
     }
@@ -259,6 +396,139 @@ stream_get_xml(clixon_handle h,
     return 0;
 }
 
+/*! Get replay record given its order, 0 is oldest
+ *
+ * @param[in]  es   Event stream
+ * @param[in]  i    Order of record, less than es_replay_nr
+ * @retval     r    Replay record
+ */
+static struct stream_replay *
+stream_replay_get(event_stream_t *es,
+                  size_t          i)
+{
+    return &es->es_replay[(es->es_replay_head + i) % es->es_replay_max];
+}
+
+/*! Remove oldest replay record
+ *
+ * @param[in]  es   Event stream, with at least one record
+ */
+static void
+stream_replay_pop(event_stream_t *es)
+{
+    struct stream_replay *r;
+
+    r = stream_replay_get(es, 0);
+    es->es_replay_bytes -= r->r_len;
+    free(r->r_data);
+    memset(r, 0, sizeof(*r));
+    es->es_replay_head = (es->es_replay_head + 1) % es->es_replay_max;
+    es->es_replay_nr--;
+}
+
+/*! Grow replay ring buffer and reorder it so that oldest record is first
+ *
+ * @param[in]  es   Event stream
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+stream_replay_grow(event_stream_t *es)
+{
+    struct stream_replay *vec;
+    size_t                max;
+    size_t                i;
+
+    max = es->es_replay_max ? 2*es->es_replay_max : STREAM_REPLAY_INIT;
+    if (es->es_replay_maxnr && max > es->es_replay_maxnr)
+        max = es->es_replay_maxnr;
+    if ((vec = calloc(max, sizeof(*vec))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        return -1;
+    }
+    for (i = 0; i < es->es_replay_nr; i++)
+        vec[i] = *stream_replay_get(es, i);
+    if (es->es_replay)
+        free(es->es_replay);
+    es->es_replay = vec;
+    es->es_replay_max = max;
+    es->es_replay_head = 0;
+    return 0;
+}
+
+/*! Find first replay record not older than a timestamp using binary search
+ *
+ * @param[in]  es   Event stream
+ * @param[in]  tv   Timestamp
+ * @retval     i    Order of first record with time >= tv, es_replay_nr if none
+ */
+static size_t
+stream_replay_find(event_stream_t *es,
+                   struct timeval *tv)
+{
+    size_t low = 0;
+    size_t high = es->es_replay_nr;
+    size_t mid;
+
+    while (low < high){
+        mid = low + (high - low)/2;
+        if (timercmp(&stream_replay_get(es, mid)->r_tv, tv, <))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+/*! Add serialized replay sample to stream with timestamp
+ *
+ * The event is copied to the replay ring buffer of the stream.
+ * Oldest records are dropped if the buffer exceeds its count or byte limits.
+ * The buffer is kept sorted on time for stream_replay_find. Timestamps are wall clock
+ * time as in eventTime, if the clock is set back the sample gets the time of the
+ * previous sample.
+ * @param[in] es   Stream
+ * @param[in] tv   Timestamp
+ * @param[in] data Event serialized as XML
+ * @param[in] len  Length of data
+ * @retval    0    OK
+ * @retval   -1    Error
+ */
+static int
+stream_replay_add_data(event_stream_t *es,
+                       struct timeval *tv,
+                       const char     *data,
+                       size_t          len)
+{
+    struct stream_replay *r;
+    struct timeval        tv1 = *tv;
+
+    if (es->es_replay_nr){
+        r = stream_replay_get(es, es->es_replay_nr - 1);
+        if (timercmp(tv, &r->r_tv, <))
+            tv1 = r->r_tv;
+    }
+    while (es->es_replay_nr &&
+           ((es->es_replay_maxnr && es->es_replay_nr >= es->es_replay_maxnr) ||
+            (es->es_replay_maxbytes && es->es_replay_bytes + len > es->es_replay_maxbytes)))
+        stream_replay_pop(es);
+    if (es->es_replay_nr == es->es_replay_max &&
+        stream_replay_grow(es) < 0)
+        return -1;
+    r = &es->es_replay[(es->es_replay_head + es->es_replay_nr) % es->es_replay_max];
+    if ((r->r_data = malloc(len + 1)) == NULL){
+        clixon_err(OE_UNIX, errno, "malloc");
+        return -1;
+    }
+    memcpy(r->r_data, data, len);
+    r->r_data[len] = '\0';
+    r->r_len = len;
+    r->r_tv = tv1;
+    es->es_replay_nr++;
+    es->es_replay_bytes += len;
+    return 0;
+}
+
 /*! Check all stream subscription stop timers, set up new timer
  *
  * @param[in] fd   No-op
@@ -280,8 +550,6 @@ stream_timer_setup(int   fd,
     event_stream_t              *es;
     struct stream_subscription  *ss;
     struct stream_subscription  *ss1;
-    struct stream_replay        *r;
-    struct stream_replay        *r1;
 
     clixon_debug(CLIXON_DBG_STREAM|CLIXON_DBG_DETAIL, "");
     /* Go thru callbacks and see if any have timed out, if so remove them 
@@ -309,21 +577,12 @@ stream_timer_setup(int   fd,
                         ss = NEXTQ(struct stream_subscription *, ss);
                 } while (ss && ss != es->es_subscription);
   /* 2) Go throughreplay buffer and remove entries with passed retention time */
-            if (timerisset(&es->es_retention) &&
-                (r = es->es_replay) != NULL){
+            if (timerisset(&es->es_retention)){
                 timersub(&now, &es->es_retention, &tret);
-                do {
-                    if (timercmp(&r->r_tv, &tret, <)){
-                        r1 = NEXTQ(struct stream_replay *, r);
-                        DELQ(r, es->es_replay, struct stream_replay *);
-                        if (r->r_xml)
-                            xml_free(r->r_xml);
-                        free(r);
-                        r = r1;
-                    }
-                    else
-                        r = NEXTQ(struct stream_replay *, r);
-                } while (r && r!=es->es_replay);
+                /* Records are ordered by time, oldest first */
+                while (es->es_replay_nr &&
+                       timercmp(&stream_replay_get(es, 0)->r_tv, &tret, <))
+                    stream_replay_pop(es);
             }
             es = NEXTQ(struct event_stream *, es);
         } while (es && es != clicon_stream(h));
@@ -386,13 +645,22 @@ stream_ss_add(clixon_handle     h,
         clixon_err(OE_CFG, errno, "strdup");
         goto done;
     }
+    /* Compile filter once, shared with other subscriptions of stream */
+    if (xpath && strlen(xpath) &&
+        (ss->ss_filter = stream_filter_get(es, xpath)) == NULL)
+        goto done;
     ss->ss_fn     = fn;
     ss->ss_arg    = arg;
     ADDQ(ss, es->es_subscription);
     return ss;
   done:
-    if (ss)
+    if (ss){
+        if (ss->ss_stream)
+            free(ss->ss_stream);
+        if (ss->ss_xpath)
+            free(ss->ss_xpath);
         free(ss);
+    }
     return NULL;
 }
 
@@ -413,6 +681,10 @@ stream_ss_rm(clixon_handle               h,
 {
     clixon_debug(CLIXON_DBG_STREAM, "");
     DELQ(ss, es->es_subscription, struct stream_subscription *);
+    if (ss->ss_filter){
+        stream_filter_release(es, ss->ss_filter);
+        ss->ss_filter = NULL;
+    }
     /* Remove from upper layers - close socket etc. */
     (*ss->ss_fn)(h, 1, NULL, ss->ss_arg);
     if (force){
@@ -515,32 +787,209 @@ stream_ss_delete(clixon_handle     h,
     return retval;
 }
 
+/*! Set callback with serialized event of a stream subscription
+ *
+ * If set, events are serialized once and the same data is given to all such
+ * subscriptions, instead of calling the subscription callback with an XML tree.
+ * The subscription callback is still called on close.
+ * @param[in]  ss      Stream subscription
+ * @param[in]  datafn  Callback with serialized event
+ * @retval     0       OK
+ */
+int
+stream_ss_datafn_set(struct stream_subscription *ss,
+                     stream_data_fn_t            datafn)
+{
+    ss->ss_datafn = datafn;
+    return 0;
+}
+
+/* Notification event being published, built on demand both as XML tree and as
+ * serialized data, each at most once for all subscriptions
+ */
+struct stream_event{
+    struct timeval se_tv;       /* Timestamp */
+    char           se_timestr[28]; /* Timestamp as eventTime */
+    const char    *se_body;     /* Event as serialized XML, or NULL */
+    cxobj         *se_body_xml; /* Event as XML, or NULL. Not freed */
+    cbuf          *se_cb;       /* Serialized notification, or NULL if not yet built */
+    cxobj         *se_xml;      /* Notification XML tree, or NULL if not yet built */
+    int            se_bound;    /* se_xml is bound to yang, see stream_event_xml */
+};
+
+/*! Get serialized notification of event, serialize if first time
+ *
+ * @param[in]  se    Stream event
+ * @param[out] data  Notification serialized as XML
+ * @param[out] len   Length of data
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+stream_event_data(struct stream_event *se,
+                  char               **data,
+                  size_t              *len)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if (se->se_cb == NULL){
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        /* From RFC5277 */
+        cprintf(cb, "<notification xmlns=\"%s\"><eventTime>%s</eventTime>",
+                NETCONF_NOTIFICATION_NAMESPACE, se->se_timestr);
+        if (se->se_body)
+            cbuf_append_str(cb, (char*)se->se_body);
+        else if (se->se_body_xml &&
+                 clixon_xml2cbuf(cb, se->se_body_xml, 0, 0, NULL, -1, 0) < 0)
+            goto done;
+        cprintf(cb, "</notification>");
+        se->se_cb = cb;
+        cb = NULL;
+    }
+    *data = cbuf_get(se->se_cb);
+    *len = cbuf_len(se->se_cb);
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Parse notification of event given as string, without binding yang
+ *
+ * Checks that the event is well-formed, yang is bound when first needed, see stream_event_xml
+ * @param[in]  h     Clixon handle
+ * @param[in]  se    Stream event with se_body set
+ * @retval     0     OK
+ * @retval    -1     Error, eg malformed event
+ */
+static int
+stream_event_parse(clixon_handle        h,
+                   struct stream_event *se)
+{
+    int     retval = -1;
+    cxobj  *xev = NULL;
+    char   *data;
+    size_t  len;
+
+    if (stream_event_data(se, &data, &len) < 0)
+        goto done;
+    if (clixon_xml_parse_string(data, YB_NONE, NULL, &xev, NULL) < 0)
+        goto done;
+    if (xml_rootchild(xev, 0, &xev) < 0)
+        goto done;
+    se->se_xml = xev;
+    se->se_bound = 0;
+    xev = NULL;
+    retval = 0;
+ done:
+    if (xev)
+        xml_free(xev);
+    return retval;
+}
+
+/*! Get notification XML tree of event, parse or copy and bind yang if first time
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  se    Stream event
+ * @param[out] xp    Notification XML tree
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+stream_event_xml(clixon_handle        h,
+                 struct stream_event *se,
+                 cxobj              **xp)
+{
+    int        retval = -1;
+    yang_stmt *yspec;
+    cxobj     *xev = NULL;
+    cxobj     *x;
+    cbuf      *cb = NULL;
+    int        ret;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clixon_err(OE_YANG, 0, "No yang spec");
+        goto done;
+    }
+    if (se->se_xml == NULL){
+        if (se->se_body_xml){ /* Envelope only, and copy of event */
+            if ((cb = cbuf_new()) == NULL){
+                clixon_err(OE_UNIX, errno, "cbuf_new");
+                goto done;
+            }
+            cprintf(cb, "<notification xmlns=\"%s\"><eventTime>%s</eventTime></notification>",
+                    NETCONF_NOTIFICATION_NAMESPACE, se->se_timestr);
+            if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, yspec, &xev, NULL) < 0)
+                goto done;
+            if (xml_rootchild(xev, 0, &xev) < 0)
+                goto done;
+            if ((x = xml_dup(se->se_body_xml)) == NULL)
+                goto done;
+            if (xml_addsub(xev, x) < 0)
+                goto done;
+            se->se_xml = xev;
+            se->se_bound = 1;
+            xev = NULL;
+        }
+        else if (stream_event_parse(h, se) < 0)
+            goto done;
+    }
+    /* Bind as if parsed with YB_MODULE, a failed binding is not an error */
+    if (se->se_bound == 0){
+        if ((ret = xml_bind_yang0(h, se->se_xml, YB_MODULE, yspec, NULL)) < 0)
+            goto done;
+        if (ret == 1 && xml_sort_recurse(se->se_xml) < 0)
+            goto done;
+        se->se_bound = 1;
+    }
+    *xp = se->se_xml;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (xev)
+        xml_free(xev);
+    return retval;
+}
+
 /*! Stream notify event and distribute to all registered callbacks
  *
+ * The event is parsed at most once, and only serialized if a subscription has a
+ * data callback.
+ * Each distinct filter is evaluated once.
  * @param[in]  h       Clixon handle
- * @param[in]  stream  Name of event stream. CLICON is predefined as LOG stream
- * @param[in]  tv      Timestamp. Dont notify if subscription has stoptime<tv
- * @param[in]  event   Notification as xml tree
+ * @param[in]  es      Event stream
+ * @param[in]  se      Event. Dont notify if subscription has stoptime<tv
  * @retval     0       OK
  * @retval    -1       Error
  * @see stream_notify
  * @see stream_ss_timeout where subscriptions are removed if stoptime<now
  */
 static int
-stream_notify1(clixon_handle   h,
-               event_stream_t *es,
-               struct timeval *tv,
-               cxobj          *xevent)
+stream_notify1(clixon_handle        h,
+               event_stream_t      *es,
+               struct stream_event *se)
 {
     int                         retval = -1;
     struct stream_subscription *ss;
+    cxobj                      *xevent;
+    char                       *data;
+    size_t                      len;
+    int                         ret;
 
     clixon_debug(CLIXON_DBG_STREAM, "");
+    /* New event, filter match results of previous event are not valid */
+    es->es_event_nr++;
     /* Go thru all subscriptions and find matches */
     if ((ss = es->es_subscription) != NULL)
         do {
             if (timerisset(&ss->ss_stoptime) && /* stoptime has passed */
-                timercmp(&ss->ss_stoptime, tv, <)){
+                timercmp(&ss->ss_stoptime, &se->se_tv, <)){
                 struct stream_subscription *ss1;
                 ss1 = NEXTQ(struct stream_subscription *, ss);
                 /* Signal to remove stream for upper levels */
@@ -549,11 +998,28 @@ stream_notify1(clixon_handle   h,
                 ss = ss1;
             }
             else{  /* xpath match */
-                if (ss->ss_xpath == NULL ||
-                    strlen(ss->ss_xpath)==0 ||
-                    xpath_first(xevent, NULL, "%s", ss->ss_xpath) != NULL)
+                if (ss->ss_filter){
+                    if (stream_event_xml(h, se, &xevent) < 0)
+                        goto done;
+                    if ((ret = stream_filter_match(es, ss->ss_filter, xevent)) < 0)
+                        goto done;
+                    if (ret == 0){
+                        ss = NEXTQ(struct stream_subscription *, ss);
+                        continue;
+                    }
+                }
+                if (ss->ss_datafn){
+                    if (stream_event_data(se, &data, &len) < 0)
+                        goto done;
+                    if ((*ss->ss_datafn)(h, data, len, ss->ss_arg) < 0)
+                        goto done;
+                }
+                else {
+                    if (stream_event_xml(h, se, &xevent) < 0)
+                        goto done;
                     if ((*ss->ss_fn)(h, 0, xevent, ss->ss_arg) < 0)
                         goto done;
+                }
                 ss = NEXTQ(struct stream_subscription *, ss);
             }
         } while (es->es_subscription && ss != es->es_subscription);
@@ -562,6 +1028,51 @@ stream_notify1(clixon_handle   h,
     return retval;
 }
 
+/*! Publish event on stream: notify subscriptions and add to replay buffer
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  es      Event stream
+ * @param[in]  se      Event, freed on exit
+ * @retval     0       OK
+ * @retval    -1       Error, eg malformed event
+ */
+static int
+stream_event_publish(clixon_handle        h,
+                     event_stream_t      *es,
+                     struct stream_event *se)
+{
+    int     retval = -1;
+    char   *data;
+    size_t  len;
+
+    gettimeofday(&se->se_tv, NULL);
+    if (time2str(&se->se_tv, se->se_timestr, sizeof(se->se_timestr)) < 0){
+        clixon_err(OE_UNIX, errno, "time2str");
+        goto done;
+    }
+    /* Event given as string, eg from a plugin: check it is well-formed before fan-out, so
+     * that malformed XML is not sent to subscribers or stored for replay.
+     * Yang is bound only if a subscription needs the tree */
+    if (se->se_body != NULL &&
+        stream_event_parse(h, se) < 0)
+        goto done;
+    if (stream_notify1(h, es, se) < 0)
+        goto done;
+    if (es->es_replay_enabled){
+        if (stream_event_data(se, &data, &len) < 0)
+            goto done;
+        if (stream_replay_add_data(es, &se->se_tv, data, len) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    if (se->se_cb)
+        cbuf_free(se->se_cb);
+    if (se->se_xml)
+        xml_free(se->se_xml);
+    return retval;
+}
+
 /*! Stream notify event and distribute to all registered callbacks
  *
  * @param[in]  h       Clixon handle
@@ -573,23 +1084,20 @@ stream_notify1(clixon_handle   h,
  *  if (stream_notify(h, "NETCONF", "<event><event-class>fault</event-class><reportingEntity><card>Ethernet0</card></reportingEntity><severity>major</severity></event>") < 0)
  *    err;
  * @endcode
- * @see  stream_notify_xml  Similar but with XML data
+ * @see  stream_notify_xml   Similar but with XML data
+ * @see  stream_notify_data  Without format string
  */
 int
 stream_notify(clixon_handle h,
               char         *stream,
               const char   *event, ...)
 {
-    int             retval = -1;
-    va_list         args;
-    int             len;
-    cxobj          *xev = NULL;
-    yang_stmt      *yspec = NULL;
-    char           *str = NULL;
-    cbuf           *cb = NULL;
-    char            timestr[28];
-    struct timeval  tv;
-    event_stream_t *es;
+    int                 retval = -1;
+    va_list             args;
+    int                 len;
+    char               *str = NULL;
+    event_stream_t     *es;
+    struct stream_event se = {0,};
 
     clixon_debug(CLIXON_DBG_STREAM, "");
     if ((es = stream_find(h, stream)) == NULL)
@@ -605,113 +1113,66 @@ stream_notify(clixon_handle h,
     va_start(args, event);
     len = vsnprintf(str, len, event, args) + 1;
     va_end(args);
-    if ((yspec = clicon_dbspec_yang(h)) == NULL){
-        clixon_err(OE_YANG, 0, "No yang spec");
-        goto done;
-    }
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
+    se.se_body = str;
+    if (stream_event_publish(h, es, &se) < 0)
         goto done;
-    }
-    gettimeofday(&tv, NULL);
-    if (time2str(&tv, timestr, sizeof(timestr)) < 0){
-        clixon_err(OE_UNIX, errno, "time2str");
-        goto done;
-    }
-    /* From RFC5277 */
-    cprintf(cb, "<notification xmlns=\"%s\"><eventTime>%s</eventTime>%s</notification>",
-            NETCONF_NOTIFICATION_NAMESPACE, timestr, str);
-    if (clixon_xml_parse_string(cbuf_get(cb), YB_MODULE, yspec, &xev, NULL) < 0)
-        goto done;
-    if (xml_rootchild(xev, 0, &xev) < 0)
-        goto done;
-    if (stream_notify1(h, es, &tv, xev) < 0)
-        goto done;
-    if (es->es_replay_enabled){
-        if (stream_replay_add(es, &tv, xev) < 0)
-            goto done;
-        xev = NULL; /* xml stored in replay_add and should not be freed */
-    }
  ok:
     retval = 0;
   done:
-    if (cb)
-        cbuf_free(cb);
-    if (xev)
-        xml_free(xev);
     if (str)
         free(str);
     return retval;
 }
 
-/*! Backward compatible function
+/*! Stream notify event given as serialized XML
+ *
+ * The event is wrapped in a notification and sent as is to subscriptions with a data
+ * callback. It is parsed once to validate it before it is sent.
+ * @param[in]  h       Clixon handle
+ * @param[in]  stream  Name of event stream
+ * @param[in]  event   Event serialized as XML
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see  stream_notify  With format string
+ */
+int
+stream_notify_data(clixon_handle h,
+                   char         *stream,
+                   const char   *event)
+{
+    event_stream_t     *es;
+    struct stream_event se = {0,};
+
+    clixon_debug(CLIXON_DBG_STREAM, "");
+    if ((es = stream_find(h, stream)) == NULL)
+        return 0;
+    se.se_body = event;
+    return stream_event_publish(h, es, &se);
+}
+
+/*! Stream notify event given as XML tree
  *
  * @param[in]  h       Clixon handle
  * @param[in]  stream  Name of event stream. CLICON is predefined as LOG stream
- * @param[in]  xml     Notification as XML stream. Is copied.
+ * @param[in]  xml     Notification as XML stream. Is copied if a subscription needs an
+ *                     XML tree, otherwise only serialized.
  * @retval     0       OK
  * @retval    -1       Error
- * @see  stream_notify  Should be merged with this
+ * @see  stream_notify
  */
 int
 stream_notify_xml(clixon_handle h,
                   char         *stream,
                   cxobj        *xml)
 {
-    int        retval = -1;
-    cxobj     *xev = NULL;
-    cxobj     *xml2; /* copy */
-    yang_stmt *yspec = NULL;
-    char      *str = NULL; /* XXX: never set */
-    cbuf      *cb = NULL;
-    char       timestr[28];
-    struct timeval tv;
-    event_stream_t *es;
+    event_stream_t     *es;
+    struct stream_event se = {0,};
 
     clixon_debug(CLIXON_DBG_STREAM, "");
     if ((es = stream_find(h, stream)) == NULL)
-        goto ok;
-    if ((yspec = clicon_dbspec_yang(h)) == NULL){
-        clixon_err(OE_YANG, 0, "No yang spec");
-        goto done;
-    }
-    if ((cb = cbuf_new()) == NULL){
-        clixon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
-    }
-    gettimeofday(&tv, NULL);
-    if (time2str(&tv, timestr, sizeof(timestr)) < 0){
-        clixon_err(OE_UNIX, errno, "time2str");
-        goto done;
-    }
-    cprintf(cb, "<notification xmlns=\"%s\"><eventTime>%s</eventTime>NULL</notification>",
-            NETCONF_NOTIFICATION_NAMESPACE,
-            timestr); /* XXX str is always NULL */
-    if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, yspec, &xev, NULL) < 0)
-        goto done;
-    if (xml_rootchild(xev, 0, &xev) < 0)
-        goto done;
-    if ((xml2 = xml_dup(xml)) == NULL)
-        goto done;
-    if (xml_addsub(xev, xml2) < 0)
-        goto done;
-    if (stream_notify1(h, es, &tv, xev) < 0)
-        goto done;
-    if (es->es_replay_enabled){
-        if (stream_replay_add(es, &tv, xev) < 0)
-            goto done;
-        xev = NULL; /* xml stored in replay_add and should not be freed */
-    }
- ok:
-    retval = 0;
-  done:
-    if (cb)
-        cbuf_free(cb);
-    if (xev)
-        xml_free(xev);
-    if (str)
-        free(str);
-    return retval;
+        return 0;
+    se.se_body_xml = xml;
+    return stream_event_publish(h, es, &se);
 }
 
 /*! Replay a stream by sending notification messages
@@ -747,35 +1208,39 @@ stream_replay_notify(clixon_handle               h,
 {
     int                   retval = -1;
     struct stream_replay *r;
+    size_t                i;
+    cxobj                *xt = NULL;
+    cxobj                *xev;
 
     /* If <startTime> is not present, this is not a replay */
     if (!timerisset(&ss->ss_starttime))
         goto ok;
     if (!es->es_replay_enabled)
         goto ok;
-    /* Get replay linked list */
-    if ((r = es->es_replay) == NULL)
-        goto ok;
-    /* First loop to skip until start */
-    do {
-        if (timercmp(&r->r_tv, &ss->ss_starttime, >=))
-            break;
-        r = NEXTQ(struct stream_replay *, r);
-    } while (r && r!=es->es_replay);
-    if (r == NULL)
-        goto ok; /* No samples to replay */
-    /* Then notify until stop */
-    do {
+    /* Skip until start using time index, then notify until stop */
+    for (i = stream_replay_find(es, &ss->ss_starttime); i < es->es_replay_nr; i++){
+        r = stream_replay_get(es, i);
         if (timerisset(&ss->ss_stoptime) &&
             timercmp(&r->r_tv, &ss->ss_stoptime, >))
             break;
-        if ((*ss->ss_fn)(h, 0, r->r_xml, ss->ss_arg) < 0)
+        if (ss->ss_datafn){
+            if ((*ss->ss_datafn)(h, r->r_data, r->r_len, ss->ss_arg) < 0)
+                goto done;
+            continue;
+        }
+        if (clixon_xml_parse_string(r->r_data, YB_NONE, NULL, &xt, NULL) < 0)
             goto done;
-        r = NEXTQ(struct stream_replay *, r);
-    } while (r && r!=es->es_replay);
+        if ((xev = xml_child_i_type(xt, 0, CX_ELMNT)) != NULL)
+            if ((*ss->ss_fn)(h, 0, xev, ss->ss_arg) < 0)
+                goto done;
+        xml_free(xt);
+        xt = NULL;
+    }
  ok:
     retval = 0;
  done:
+    if (xt)
+        xml_free(xt);
     return retval;
 }
 
@@ -783,28 +1248,31 @@ stream_replay_notify(clixon_handle               h,
  *
  * @param[in] es   Stream
  * @param[in] tv   Timestamp
- * @param[in] xv   XML
+ * @param[in] xv   XML, not consumed
  * @retval    0    OK
  * @retval   -1    Error
+ * @see stream_replay_add_data
  */
 int
 stream_replay_add(event_stream_t *es,
                   struct timeval *tv,
                   cxobj          *xv)
 {
-    int                   retval = -1;
-    struct stream_replay *new;
+    int   retval = -1;
+    cbuf *cb = NULL;
 
-    if ((new = malloc(sizeof *new)) == NULL){
-        clixon_err(OE_UNIX, errno, "malloc");
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
     }
-    memset(new, 0, (sizeof *new));
-    new->r_tv = *tv;
-    new->r_xml = xv;
-    ADDQ(new, es->es_replay);
+    if (clixon_xml2cbuf(cb, xv, 0, 0, NULL, -1, 0) < 0)
+        goto done;
+    if (stream_replay_add_data(es, tv, cbuf_get(cb), cbuf_len(cb)) < 0)
+        goto done;
     retval = 0;
  done:
+    if (cb)
+        cbuf_free(cb);
     return retval;
 }
 
@@ -1207,7 +1207,7 @@ clixon_text_syntax_parse_file(FILE      *fp,
     retval = 1;
  done:
     if (retval < 0 && *xt){
-        free(*xt);
+        xml_free(*xt);
         *xt = NULL;
     }
     if (textbuf)
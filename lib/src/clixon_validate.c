@@ -48,7 +48,10 @@
 #include <string.h>
 #include <syslog.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <arpa/inet.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 #include <sys/param.h>
 #include <netinet/in.h>
 
@@ -82,6 +85,160 @@
 #include "clixon_validate_minmax.h"
 #include "clixon_validate.h"
 
+/*! Per-validation index of leafref target values
+ *
+ * Maps "<anchor> <module> <path>" to a hash of the body values of the path's target
+ * nodes, or to NULL if the anchor has only been seen once. Only active during
+ * xml_yang_validate_all_top1, the tree is not modified during that time.
+ * @see validate_leafref_index
+ */
+static clicon_hash_t *_leafref_index = NULL;
+
+/*! Free the per-validation leafref index
+ */
+static int
+validate_leafref_index_free(void)
+{
+    char          **keys = NULL;
+    size_t          nkeys = 0;
+    size_t          i;
+    clicon_hash_t **ph;
+
+    if (_leafref_index == NULL)
+        return 0;
+    if (clicon_hash_keys(_leafref_index, &keys, &nkeys) < 0)
+        return -1;
+    for (i = 0; i < nkeys; i++){
+        if ((ph = clicon_hash_value(_leafref_index, keys[i], NULL)) != NULL &&
+            *ph != NULL)
+            clicon_hash_free(*ph);
+    }
+    if (keys)
+        free(keys);
+    clicon_hash_free(_leafref_index);
+    _leafref_index = NULL;
+    return 0;
+}
+
+/*! Get anchor node of a leafref path if the path result only depends on the anchor
+ *
+ * For an absolute path the anchor is the top of the tree. For a relative path of
+ * the form "../../a/b" the anchor is the ancestor reached by the leading "../" steps.
+ * Paths with predicates or functions, eg current(), or inner ".." steps are not
+ * indexed.
+ * @param[in]  xt     XML leaf node of type leafref (context node)
+ * @param[in]  path   Leafref path argument
+ * @param[out] xa     Anchor node
+ * @retval     1      OK, anchor found
+ * @retval     0      Path not indexable
+ */
+static int
+leafref_path_anchor(cxobj  *xt,
+                    char   *path,
+                    cxobj **xa)
+{
+    cxobj *x = xt;
+    char  *p = path;
+
+    if (strchr(path, '[') != NULL || strchr(path, '(') != NULL)
+        return 0;
+    if (*p == '/'){
+        while (xml_parent(x) != NULL)
+            x = xml_parent(x);
+    }
+    else {
+        while (strncmp(p, "../", 3) == 0){
+            if ((x = xml_parent(x)) == NULL)
+                return 0;
+            p += 3;
+        }
+        if (p == path || strstr(p, "..") != NULL)
+            return 0;
+    }
+    *xa = x;
+    return 1;
+}
+
+/*! Get or build value index of a leafref path given the current validation
+ *
+ * The target nodes of the path are evaluated once for each anchor, and the body
+ * values are stored in a hash, so that each leafref check is a hash lookup.
+ * The index is built on the second lookup of an anchor. A relative path, such as
+ * "../config/name", has a separate anchor for each list entry, and indexing those
+ * would cost more than the single linear lookup it replaces.
+ * @param[in]  xt     XML leaf node of type leafref (context node)
+ * @param[in]  ys     Yang spec of leaf
+ * @param[in]  path   Leafref path argument
+ * @param[out] hp     Value hash, or NULL if the path is not indexed
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+validate_leafref_index(cxobj          *xt,
+                       yang_stmt      *ys,
+                       char           *path,
+                       clicon_hash_t **hp)
+{
+    int            retval = -1;
+    cxobj         *xa = NULL;
+    cbuf          *cb = NULL;
+    clicon_hash_t *h = NULL;
+    clicon_hash_t **ph;
+    cvec          *nsc = NULL;
+    cxobj        **xvec = NULL;
+    size_t         xlen = 0;
+    size_t         i;
+    char          *body;
+
+    *hp = NULL;
+    if (_leafref_index == NULL ||
+        leafref_path_anchor(xt, path, &xa) == 0)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%p %p %s", xa, ys_module(ys), path);
+    if ((ph = clicon_hash_value(_leafref_index, cbuf_get(cb), NULL)) == NULL){
+        /* First lookup of anchor: mark as seen, but do not index */
+        if (clicon_hash_add(_leafref_index, cbuf_get(cb), &h, sizeof(h)) == NULL)
+            goto done;
+        goto ok;
+    }
+    if (*ph != NULL){
+        *hp = *ph;
+        goto ok;
+    }
+    if (xml_nsctx_yang(ys, &nsc) < 0)
+        goto done;
+    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, path) < 0)
+        goto done;
+    if ((h = clicon_hash_init()) == NULL)
+        goto done;
+    for (i = 0; i < xlen; i++) {
+        if ((body = xml_body(xvec[i])) == NULL)
+            continue;
+        if (clicon_hash_add(h, body, NULL, 0) == NULL)
+            goto done;
+    }
+    if (clicon_hash_add(_leafref_index, cbuf_get(cb), &h, sizeof(h)) == NULL)
+        goto done;
+    *hp = h;
+    h = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (h)
+        clicon_hash_free(h);
+    if (xvec)
+        free(xvec);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 /*! Validate xml node of type leafref, ensure the value is one of that path's reference
  *
  * @param[in]  xt    XML leaf node of type leafref
@@ -135,6 +292,8 @@ validate_leafref(cxobj     *xt,
     char        *path_arg;
     cg_var      *cv;
     int          require_instance = 1;
+    clicon_hash_t *hidx = NULL;
+    int          found;
 
     /* require instance */
     if ((yreqi = yang_find(ytype, Y_REQUIRE_INSTANCE, NULL)) != NULL){
@@ -162,18 +321,25 @@ validate_leafref(cxobj     *xt,
     }
     if ((leafrefbody = xml_body(xt)) == NULL)
         goto ok;
-    if (xml_nsctx_yang(ys, &nsc) < 0)
+    if (validate_leafref_index(xt, ys, path_arg, &hidx) < 0)
         goto done;
-    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, path_arg) < 0)
-        goto done;
-    for (i = 0; i < xlen; i++) {
-        x = xvec[i];
-        if ((leafbody = xml_body(x)) == NULL)
-            continue;
-        if (strcmp(leafbody, leafrefbody) == 0)
-            break;
+    if (hidx != NULL)
+        found = clicon_hash_lookup(hidx, leafrefbody) != NULL;
+    else {
+        if (xml_nsctx_yang(ys, &nsc) < 0)
+            goto done;
+        if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, path_arg) < 0)
+            goto done;
+        for (i = 0; i < xlen; i++) {
+            x = xvec[i];
+            if ((leafbody = xml_body(x)) == NULL)
+                continue;
+            if (strcmp(leafbody, leafrefbody) == 0)
+                break;
+        }
+        found = i < xlen;
     }
-    if (i==xlen){
+    if (!found){
         if ((cberr = cbuf_new()) == NULL){
             clixon_err(OE_UNIX, errno, "cbuf_new");
             goto done;
@@ -1422,6 +1588,278 @@ xml_yang_validate_all(clixon_handle h,
     goto done;
 }
 
+/*! Write a buffer to a file descriptor, handling partial writes
+ *
+ * @param[in]  s     File descriptor
+ * @param[in]  buf   Buffer
+ * @param[in]  len   Length of buffer
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+validate_worker_write(int    s,
+                      char  *buf,
+                      size_t len)
+{
+    ssize_t n;
+
+    while (len > 0){
+        if ((n = write(s, buf, len)) < 0){
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/*! Validate a range of top-level XML nodes in a worker process and write result on socket
+ *
+ * The result is written as a line with the return value followed by:
+ * - if 0: the error XML tree
+ * - if -1: error category, sub-errno and reason
+ * @param[in]  h     Clixon handle
+ * @param[in]  vec   Vector of top-level XML nodes
+ * @param[in]  i0    First node in range
+ * @param[in]  i1    End of range (exclusive)
+ * @param[in]  s     File descriptor to write result on
+ * @note Does not return
+ */
+static void
+validate_worker(clixon_handle h,
+                cxobj       **vec,
+                int           i0,
+                int           i1,
+                int           s)
+{
+    cxobj *xerr = NULL;
+    cbuf  *cb;
+    int    ret = 1;
+    int    i;
+
+    for (i=i0; i<i1; i++)
+        if ((ret = xml_yang_validate_all(h, vec[i], &xerr)) < 1)
+            break;
+    if ((cb = cbuf_new()) == NULL)
+        _exit(1);
+    cprintf(cb, "%d\n", ret);
+    if (ret == 0){
+        if (clixon_xml2cbuf(cb, xerr, 0, 0, NULL, -1, 0) < 0)
+            _exit(1);
+    }
+    else if (ret < 0)
+        cprintf(cb, "%d %d %s", clixon_err_category(), clixon_err_subnr(), clixon_err_reason());
+    if (validate_worker_write(s, cbuf_get(cb), cbuf_len(cb)) < 0)
+        _exit(1);
+    _exit(0);
+}
+
+/*! Read and merge result from validation worker
+ *
+ * @param[in]  s     File descriptor to read result from
+ * @param[out] xret  Error XML tree (if retval == 0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (xret set)
+ * @retval    -1     Error
+ * @see validate_worker
+ */
+static int
+validate_worker_result(int     s,
+                       cxobj **xret)
+{
+    int     retval = -1;
+    cbuf   *cb = NULL;
+    char    buf[BUFSIZ];
+    ssize_t n;
+    char   *str;
+    char   *p;
+    cxobj  *xt = NULL;
+    cxobj  *xr;
+    cxobj  *xc;
+    int     ret;
+    int     cat;
+    int     suberr;
+
+    if ((cb = cbuf_new()) == NULL){
+        clixon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    while ((n = read(s, buf, sizeof(buf))) != 0){
+        if (n < 0){
+            if (errno == EINTR)
+                continue;
+            clixon_err(OE_UNIX, errno, "read");
+            goto done;
+        }
+        if (cbuf_append_buf(cb, buf, n) < 0){
+            clixon_err(OE_UNIX, errno, "cbuf_append_buf");
+            goto done;
+        }
+    }
+    str = cbuf_get(cb);
+    if ((p = strchr(str, '\n')) == NULL){
+        clixon_err(OE_CFG, 0, "Validation worker terminated without result");
+        goto done;
+    }
+    *p++ = '\0';
+    ret = atoi(str);
+    if (ret < 0){
+        cat = strtol(p, &p, 10);
+        suberr = strtol(p, &p, 10);
+        if (*p == ' ')
+            p++;
+        clixon_err(cat, suberr, "%s", p);
+        goto done;
+    }
+    if (ret == 0){
+        if (clixon_xml_parse_string(p, YB_NONE, NULL, &xt, NULL) < 0)
+            goto done;
+        if ((xr = xml_child_i_type(xt, 0, CX_ELMNT)) == NULL){
+            clixon_err(OE_XML, 0, "Validation worker returned no error");
+            goto done;
+        }
+        if (*xret == NULL){
+            xml_rm(xr);
+            *xret = xr;
+        }
+        else {
+            while ((xc = xml_child_i_type(xr, 0, CX_ELMNT)) != NULL)
+                if (xml_addsub(*xret, xc) < 0)
+                    goto done;
+        }
+        goto fail;
+    }
+    retval = 1;
+ done:
+    if (xt)
+        xml_free(xt);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Validate top-level XML nodes in parallel in forked worker processes
+ *
+ * Top-level nodes are partitioned into contiguous ranges of roughly equal size, one range
+ * per worker. Workers run on a copy-on-write copy of the tree and return the result on a
+ * pipe. Results are merged in tree order, so that the error returned is the same as if
+ * validation was made sequentially.
+ * @param[in]  h       Clixon handle
+ * @param[in]  vec     Vector of top-level XML nodes
+ * @param[in]  veclen  Length of vec
+ * @param[in]  workers Number of workers
+ * @param[out] xret    Error XML tree (if retval == 0). Free with xml_free after use
+ * @retval     1       Validation OK
+ * @retval     0       Validation failed (xret set)
+ * @retval    -1       Error
+ * @note Processes are used instead of threads since validation is not thread-safe
+ * @note Side effects in the workers are lost, eg XPath and leafref caches filled during
+ *       validation are not available in the parent
+ * @note Workers do not run the event loop, and thereby do not re-create its epoll
+ *       instance, see event_epoll_init. The fork itself copies the page tables of the
+ *       parent.
+ */
+static int
+xml_yang_validate_all_workers(clixon_handle h,
+                              cxobj       **vec,
+                              int           veclen,
+                              int           workers,
+                              cxobj       **xret)
+{
+    int       retval = -1;
+    uint64_t *nrvec = NULL;
+    uint64_t  total = 0;
+    uint64_t  acc;
+    pid_t    *pids = NULL;
+    int      *fds = NULL;
+    int       sp[2];
+    int       i;
+    int       i0;
+    int       w;
+    int       status;
+    int       ret;
+
+    if ((nrvec = calloc(veclen, sizeof(*nrvec))) == NULL ||
+        (pids = calloc(workers, sizeof(*pids))) == NULL ||
+        (fds = calloc(workers, sizeof(*fds))) == NULL){
+        clixon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i=0; i<veclen; i++){
+        if (xml_stats(vec[i], &nrvec[i], NULL) < 0)
+            goto done;
+        total += nrvec[i];
+    }
+    for (w=0; w<workers; w++)
+        fds[w] = -1;
+    /* Fork workers, each takes nodes until its share of the tree is reached */
+    i = 0;
+    acc = 0;
+    for (w=0; w<workers && i<veclen; w++){
+        i0 = i;
+        do {
+            acc += nrvec[i++];
+        } while (i < veclen && acc < total*(w+1)/workers && veclen-i > workers-w-1);
+        if (w == workers-1)
+            i = veclen;
+        if (pipe(sp) < 0){
+            clixon_err(OE_UNIX, errno, "pipe");
+            goto done;
+        }
+        if ((pids[w] = fork()) < 0){
+            clixon_err(OE_UNIX, errno, "fork");
+            close(sp[0]);
+            close(sp[1]);
+            goto done;
+        }
+        if (pids[w] == 0){ /* Worker */
+            close(sp[0]);
+            validate_worker(h, vec, i0, i, sp[1]);
+        }
+        close(sp[1]);
+        fds[w] = sp[0];
+        clixon_debug(CLIXON_DBG_DEFAULT | CLIXON_DBG_DETAIL, "worker %d pid %d nodes %d-%d",
+                     w, pids[w], i0, i);
+    }
+    /* Merge results in order, first failure wins */
+    retval = 1;
+    for (w=0; w<workers && fds[w] != -1; w++){
+        ret = validate_worker_result(fds[w], xret);
+        close(fds[w]);
+        fds[w] = -1;
+        if (ret < 1){
+            retval = ret;
+            break;
+        }
+    }
+ done:
+    if (pids){
+        /* Remaining workers are not needed, kill them before waiting */
+        for (w=0; w<workers && pids[w] > 0; w++){
+            if (fds[w] != -1){
+                close(fds[w]);
+                fds[w] = -1;
+                kill(pids[w], SIGKILL);
+            }
+        }
+        for (w=0; w<workers && pids[w] > 0; w++){
+            while (waitpid(pids[w], &status, 0) < 0 && errno == EINTR)
+                ;
+        }
+        free(pids);
+    }
+    if (fds)
+        free(fds);
+    if (nrvec)
+        free(nrvec);
+    return retval;
+}
+
 /*! Validate a single XML node with yang specification
  *
  * @param[in]  h     Clixon handle
@@ -1429,23 +1867,81 @@ xml_yang_validate_all(clixon_handle h,
  * @retval     1      Validation OK
  * @retval     0      Validation failed (xret set)
  * @retval    -1      Error
+ * @see xml_yang_validate_all_top1  for parallel validation
  */
 int
 xml_yang_validate_all_top(clixon_handle h,
                           cxobj        *xt,
                           cxobj       **xret)
 {
-    int    ret;
-    cxobj *x;
+    return xml_yang_validate_all_top1(h, xt, 0, xret);
+}
+
+/*! Validate a single XML node with yang specification, optionally in parallel
+ *
+ * If workers > 1, top-level subtrees are validated in parallel worker processes
+ * @param[in]  h       Clixon handle
+ * @param[in]  workers Number of validation workers, 0 or 1 means sequential
+ * @param[out] xret    Error XML tree (if ret == 0). Free with xml_free after use
+ * @retval     1       Validation OK
+ * @retval     0       Validation failed (xret set)
+ * @retval    -1       Error
+ * @see CLICON_VALIDATE_WORKERS
+ */
+int
+xml_yang_validate_all_top1(clixon_handle h,
+                           cxobj        *xt,
+                           int           workers,
+                           cxobj       **xret)
+{
+    int     retval = -1;
+    int     ret;
+    cxobj  *x;
+    cxobj **vec = NULL;
+    int     veclen = 0;
+    int     leafrefidx = 0;
 
-    x = NULL;
-    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
-        if ((ret = xml_yang_validate_all(h, x, xret)) < 1)
-            return ret;
+    /* Leafref target values are indexed once per validation */
+    if (_leafref_index == NULL){
+        if ((_leafref_index = clicon_hash_init()) == NULL)
+            goto done;
+        leafrefidx++;
     }
-    if ((ret = xml_yang_validate_minmax(xt, 0, xret)) < 1)
-        return ret;
-    return 1;
+    if (workers > 1 && xml_child_nr_type(xt, CX_ELMNT) > 1){
+        if ((vec = calloc(xml_child_nr_type(xt, CX_ELMNT), sizeof(cxobj *))) == NULL){
+            clixon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        x = NULL;
+        while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
+            vec[veclen++] = x;
+        if (workers > veclen)
+            workers = veclen;
+        if ((ret = xml_yang_validate_all_workers(h, vec, veclen, workers, xret)) < 1){
+            retval = ret;
+            goto done;
+        }
+    }
+    else {
+        x = NULL;
+        while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+            if ((ret = xml_yang_validate_all(h, x, xret)) < 1){
+                retval = ret;
+                goto done;
+            }
+        }
+    }
+    if ((ret = xml_yang_validate_minmax(xt, 0, xret)) < 1){
+        retval = ret;
+        goto done;
+    }
+    retval = 1;
+ done:
+    if (leafrefidx)
+        validate_leafref_index_free();
+    if (vec)
+        free(vec);
+    return retval;
 }
 
 /*! Check validity of outgoing RPC
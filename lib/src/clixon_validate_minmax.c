@@ -95,29 +95,92 @@ struct vec_order {
     size_t        vo_slen;   /* Length of vo_strvec (is actually global to vector) */
 };
 
-/*! New element last in list, check if already exists if so return -1
+/*
+ * Local variables
+ */
+
+/*! If set, unique constraints are only checked in lists with added or changed entries
  *
- * @param[in]  vec   Vector of existing entries (new is last)
- * @param[in]  i1    The new entry is placed at vec[i1]
- * @param[in]  vlen  Length of entry
- * @param[in]  sorted Sorted by system, ie sorted by key, otherwise no assumption
+ * Requires XML_FLAG_ADD/XML_FLAG_CHANGE to be set by a diff with a valid source tree
+ * @see xml_yang_validate_unique_incremental
+ */
+static int _unique_incremental = 0;
+
+/*! Only check unique constraints of lists with added or changed entries
+ *
+ * Lists where no entry is flagged with XML_FLAG_ADD or XML_FLAG_CHANGE are assumed to
+ * be unchanged since a previous successful validation, and their unique and key
+ * checks are skipped.
+ * @param[in]  enable  0: check all lists, 1: only check changed lists
+ * @retval     prev    Previous value
+ * @note Only enable when the XML tree is marked by a transaction diff with a valid source
+ */
+int
+xml_yang_validate_unique_incremental(int enable)
+{
+    int prev = _unique_incremental;
+
+    _unique_incremental = enable;
+    return prev;
+}
+
+/*! Check if any entry of a list segment is added or changed
+ *
+ * @param[in]  x     The first element in the list
+ * @param[in]  xt    The parent of x
+ * @param[in]  y     Yang spec of the list
+ * @retval     1     Some entry is added or changed, or incremental check is not enabled
+ * @retval     0     No entry is added or changed
+ */
+static int
+unique_list_changed(cxobj     *x,
+                    cxobj     *xt,
+                    yang_stmt *y)
+{
+    if (_unique_incremental == 0)
+        return 1;
+    do {
+        if (xml_flag(x, XML_FLAG_ADD|XML_FLAG_CHANGE))
+            return 1;
+        x = xml_child_each(xt, x, CX_ELMNT);
+    } while (x && y == xml_spec(x));
+    return 0;
+}
+
+/*! Append a value to a composite unique key
+ *
+ * Each value is prefixed with its length so that tuples of different values
+ * never encode to the same string
+ * @param[in]  cb    Key buffer
+ * @param[in]  val   Value
+ */
+static void
+unique_key_append(cbuf *cb,
+                  char *val)
+{
+    cprintf(cb, "%zu:%s", strlen(val), val);
+}
+
+/*! Search values of a descendant schema node, check if already exists
+ *
+ * @param[in]  x     List entry
+ * @param[in]  xpath Descendant schema node id as canonical xpath
+ * @param[in]  nsc   Namespace context of xpath
+ * @param[in]  hset  Hash set of values found so far, new values are added
  * @retval     1     Validation OK
- * @retval     0     Validation failed (cbret set)
+ * @retval     0     Validation failed, duplicate found
  * @retval    -1     Error
- * @note This is currently quadratic complexity. It could be improved by inserting new element sorted and binary search.
  */
 static int
-unique_search_xpath(cxobj  *x,
-                    char   *xpath,
-                    cvec   *nsc,
-                    char ***svec,
-                    size_t *slen)
+unique_search_xpath(cxobj         *x,
+                    char          *xpath,
+                    cvec          *nsc,
+                    clicon_hash_t *hset)
 {
     int     retval = -1;
     cxobj **xvec = NULL;
     size_t  xveclen;
     int     i;
-    int     s;
     cxobj  *xi;
     char   *bi;
 
@@ -128,20 +191,10 @@ unique_search_xpath(cxobj  *x,
         xi = xvec[i];
         if ((bi = xml_body(xi)) == NULL)
             break;
-        /* Check if bi is duplicate?
-         * XXX: sort svec?
-         */
-        for (s=0; s<(*slen); s++){
-            if (strcmp(bi, (*svec)[s]) == 0){
-                goto fail;
-            }
-        }
-        (*slen) ++;
-        if (((*svec) = realloc((*svec), (*slen)*sizeof(char*))) == NULL){
-            clixon_err(OE_UNIX, errno, "realloc");
+        if (clicon_hash_lookup(hset, bi) != NULL)
+            goto fail;
+        if (clicon_hash_add(hset, bi, NULL, 0) == NULL)
             goto done;
-        }
-        (*svec)[(*slen)-1] = bi;
     } /* i search results */
     retval = 1;
  done:
@@ -157,57 +210,49 @@ unique_search_xpath(cxobj  *x,
  *
  * @param[in]  vec    Vector of existing entries (new is last)
  * @param[in]  i1     The new entry is placed at vec[i1]
- * @param[in]  vlen   Length of vec
+ * @param[in]  vlen   Length of entry
  * @param[in]  sorted Sorted by system, ie sorted by key, otherwise no assumption
- * @param[out] dupl   Index of duplicated element (if retval = -1)
- * @retval     0      OK, entry is unique
- * @retval    -1      Duplicate detected
- * @note This is currently quadratic complexity. It could be improved by inserting new element sorted and binary search.
+ * @param[in]  hset   Hash set of composite keys of previous entries (if not sorted)
+ * @param[in]  cb     Key buffer (if not sorted)
+ * @retval     1      OK, entry is unique
+ * @retval     0      Duplicate detected
+ * @retval    -1      Error
+ * If sorted, only the previous element is compared, otherwise the composite key of
+ * the new element is looked up in, and then added to, a hash set of all previous keys.
  */
 static int
-check_insert_duplicate(char **vec,
-                       int    i1,
-                       int    vlen,
-                       int    sorted,
-                       int   *dupl)
+check_insert_duplicate(char         **vec,
+                       int            i1,
+                       int            vlen,
+                       int            sorted,
+                       clicon_hash_t *hset,
+                       cbuf          *cb)
 {
-    int i;
-    int v;
+    int   i;
+    int   v;
     char *b;
 
     if (sorted){
         /* Just go look at previous element to see if it is duplicate (sorted by system) */
         if (i1 == 0)
-            return 0;
+            return 1;
         i = i1-1;
         for (v=0; v<vlen; v++){
             b = vec[i*vlen+v];
             if (b == NULL || strcmp(b, vec[i1*vlen+v]))
-                return 0;
+                return 1;
         }
         /* here we have passed thru all keys of previous element and they are all equal */
-        if (dupl)
-            *dupl = i;
-        return -1;
-    }
-    else{
-        for (i=0; i<i1; i++){
-            for (v=0; v<vlen; v++){
-                b = vec[i*vlen+v];
-                if (b == NULL || strcmp(b, vec[i1*vlen+v]))
-                    break;
-            }
-            if (v==vlen) /* duplicate */
-                break;
-        }
-        if (i<i1){
-            if (dupl)
-                *dupl = i;
-            return -1;
-        }
-        else
-            return 0;
+        return 0;
     }
+    cbuf_reset(cb);
+    for (v=0; v<vlen; v++)
+        unique_key_append(cb, vec[i1*vlen+v]);
+    if (clicon_hash_lookup(hset, cbuf_get(cb)) != NULL)
+        return 0;
+    if (clicon_hash_add(hset, cbuf_get(cb), NULL, 0) == NULL)
+        return -1;
+    return 1;
 }
 
 /*! Given a list with unique constraint, detect duplicates
@@ -254,11 +299,13 @@ check_unique_list_direct(cxobj     *x,
     int       sorted;
     char     *str;
     cvec     *cvk;
-    int       dupl;
+    int       ret;
+    clicon_hash_t *hset = NULL;
+    cbuf     *cb = NULL;
 
     /* If list and is sorted by system, then it is assumed elements are in key-order which is optimized
-     * Other cases are "unique" constraint or list sorted by user which is quadratic in complexity
-     * This second case COULD be optimized if binary insert is made on the vec vector.
+     * Other cases are "unique" constraint or list sorted by user which use a hash set of
+     * composite keys
      */
     sorted = (yang_keyword_get(yu) == Y_LIST &&
               yang_find(y, Y_ORDERED_BY, "user") == NULL);
@@ -268,6 +315,14 @@ check_unique_list_direct(cxobj     *x,
         /* No keys: no checks necessary */
         goto ok;
     }
+    if (!sorted){
+        if ((hset = clicon_hash_init()) == NULL)
+            goto done;
+        if ((cb = cbuf_new()) == NULL){
+            clixon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+    }
     /* Vector of key values, k00,k01,..,k0n,k10,k11,..
      * Ie, if nr of keys is n, and nr of children is m, then length is n*m
      * x need not be child 0, which could make the vector larger than necessary */
@@ -286,7 +341,6 @@ check_unique_list_direct(cxobj     *x,
         xvec[i] = x;
         cvi = NULL;
         v = 0; /* index in each tuple */
-        /* XXX Quadratic if clen > 1 */
         while ((cvi = cvec_each(cvk, cvi)) != NULL){
             /* RFC7950: Sec 7.8.3.1: entries that do not have value for all
              * referenced leafs are not taken into account */
@@ -303,7 +357,9 @@ check_unique_list_direct(cxobj     *x,
         }
         if (cvi==NULL){
             /* Last element (i) is newly inserted, see if it is already there */
-            if (check_insert_duplicate(vec, i, clen, sorted, &dupl) < 0){
+            if ((ret = check_insert_duplicate(vec, i, clen, sorted, hset, cb)) < 0)
+                goto done;
+            if (ret == 0){
                 if (xret && netconf_data_not_unique_xml(xret, x, cvk) < 0)
                     goto done;
                 goto fail;
@@ -313,9 +369,12 @@ check_unique_list_direct(cxobj     *x,
         i++;
     } while (x && y == xml_spec(x));  /* stop if list ends, others may follow */
  ok:
-    /* It would be possible to cache vec here as an optimization */
     retval = 1;
  done:
+    if (cb)
+        cbuf_free(cb);
+    if (hset)
+        clicon_hash_free(hset);
     if (xvec)
         free(xvec);
     if (vec)
@@ -359,8 +418,7 @@ check_unique_list(cxobj     *x,
 {
     int     retval = -1;
     cg_var *cvi; /* unique node name */
-    char  **svec = NULL; /* vector of search results */
-    size_t  slen = 0;
+    clicon_hash_t *hset = NULL; /* set of search results */
     char   *xpath0 = NULL;
     char   *xpath1 = NULL;
     int     ret;
@@ -392,9 +450,11 @@ check_unique_list(cxobj     *x,
         goto done;
     if (ret == 0)
         goto fail; // XXX set xret
+    if ((hset = clicon_hash_init()) == NULL)
+        goto done;
     do {
         /* Collect search results from one */
-        if ((ret = unique_search_xpath(x, xpath1, nsc1, &svec, &slen)) < 0)
+        if ((ret = unique_search_xpath(x, xpath1, nsc1, hset)) < 0)
             goto done;
         if (ret == 0){
             if (xret && netconf_data_not_unique_xml(xret, x, cvk) < 0)
@@ -404,7 +464,6 @@ check_unique_list(cxobj     *x,
         x = xml_child_each(xt, x, CX_ELMNT);
     } while (x && y == xml_spec(x));  /* stop if list ends, others may follow */
     // ok:
-    /* It would be possible to cache vec here as an optimization */
     retval = 1;
  done:
     if (nsc0)
@@ -413,8 +472,8 @@ check_unique_list(cxobj     *x,
         cvec_free(nsc1);
     if (xpath1)
         free(xpath1);
-    if (svec)
-        free(svec);
+    if (hset)
+        clicon_hash_free(hset);
     return retval;
  fail:
     retval = 0;
@@ -727,7 +786,7 @@ xml_yang_validate_minmax(cxobj  *xt,
             }
             nr=1;
             /* new list check */
-            if (ret){
+            if (ret && unique_list_changed(x, xt, y)){
                 if (keyw == Y_LIST){
                     if ((ret = check_unique_list_direct(x, xt, y, y, xret)) < 0)
                         goto done;
@@ -1128,11 +1187,13 @@ xml_duplicate_detect1(cxobj  *xt,
                 slen0 = clen;
                 vlen++;
             }
-            /* Special case of YANG unique statement */
-            if ((ret = xml_unique_detect(x, xt, y, xret)) < 0)
-                goto done;
-            if (ret == 0)
-                goto fail;
+            /* Special case of YANG unique statement, checked once for whole list */
+            if (y != y0){
+                if ((ret = xml_unique_detect(x, xt, y, xret)) < 0)
+                    goto done;
+                if (ret == 0)
+                    goto fail;
+            }
             break;
         case Y_LEAF_LIST:
             if (vlen > 0 && slen0 != 1){ /* Sanity check */
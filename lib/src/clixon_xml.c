@@ -46,6 +46,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <inttypes.h>
 #include <unistd.h>
@@ -165,9 +166,9 @@ struct search_index{
  */
 struct xml{
     enum cxobj_type   x_type;       /* type of node: element, attribute, body */
+    uint16_t          x_flags;      /* Flags according to XML_FLAG_* */
     char             *x_name;       /* name of node */
     char             *x_prefix;     /* namespace localname N, called prefix */
-    uint16_t          x_flags;      /* Flags according to XML_FLAG_* */
     struct xml       *x_up;         /* parent node in hierarchy if any */
 #ifdef XML_PARENT_CANDIDATE
     struct xml       *x_up_candidate; /* Candidate parent node for special cases (when+xpath) */
@@ -175,9 +176,6 @@ struct xml{
     int              _x_vector_i;   /* internal use: xml_child_each */
     int              _x_i;          /* internal use for stable sorting:
                                        see xml_enumerate_children and xml_cmp */
-    /*----- next is body/attribute only */
-    cbuf             *x_value_cb;  /* attribute and body nodes have values (XXX: this consumes 
-                                       memory) cv? */
     /*----- up to here is common to all next is element only */
     struct xml      **x_childvec;   /* vector of children nodes (XXX: use clixon_vec ) */
     int               x_childvec_len;/* Number of children */
@@ -193,13 +191,16 @@ struct xml{
 };
 
 /* Variant of struct xml for use by non-elements to save space
+ *
+ * The value is stored inline as a malloced string with explicit length and allocated size
+ * instead of as a cbuf, which saves one allocation and the cbuf header per body node.
  * @see struct xml  For XML elements
  */
 struct xmlbody{
     enum cxobj_type   xb_type;       /* type of node: element, attribute, body */
+    uint16_t          xb_flags;      /* Flags according to XML_FLAG_* */
     char             *xb_name;       /* name of node */
     char             *xb_prefix;     /* namespace localname N, called prefix */
-    uint16_t          xb_flags;      /* Flags according to XML_FLAG_* */
     struct xml       *xb_up;         /* parent node in hierarchy if any */
 #ifdef XML_PARENT_CANDIDATE
     struct xml       *xb_up_candidate; /* Candidate parent node for special cases (when+xpath) */
@@ -207,9 +208,15 @@ struct xmlbody{
     int              _xb_vector_i;   /* internal use: xml_child_each */
     int              _xb_i;          /* internal use for sorting: 
                                        see xml_enumerate and xml_cmp */
-    cbuf             *xb_value_cb;  /* attribute and body nodes have values */
+    /*----- up to here is common to all next is body/attribute only */
+    char             *xb_value;      /* attribute and body nodes have values */
+    uint32_t          xb_value_len;  /* Length of value (excluding null-termination) */
+    uint32_t          xb_value_max;  /* Allocated size of value */
 };
 
+/* Access body/attribute-only fields, x must be checked with is_bodyattr() */
+#define xml2body(x) ((struct xmlbody *)(x))
+
 /*
  * Variables
  */
@@ -234,6 +241,286 @@ xml_type2str(enum cxobj_type type)
     return clicon_int2str(xsmap, type);
 }
 
+#ifdef XML_SLAB_ALLOC
+/* Size of a slab chunk. Must be a power of two since chunks are aligned to their size and the
+ * chunk of an object is found by masking its address
+ */
+#define XML_SLAB_CHUNK_SIZE (64*1024)
+
+/*! Slab chunk header, placed first in each aligned chunk and followed by fixed-size objects
+ */
+struct xml_slab_chunk{
+    qelem_t          sc_q;     /* Queue header, in list of chunks with free objects */
+    struct xml_slab *sc_slab;  /* Back pointer to the slab this chunk belongs to */
+    void            *sc_free;  /* Free-list of objects in this chunk */
+    uint32_t         sc_used;  /* Number of allocated objects in this chunk */
+    int              sc_inq;   /* Chunk is in partial list of slab */
+};
+
+/* Chunk header size rounded up so that objects are aligned */
+#define XML_SLAB_HDR_SIZE ((sizeof(struct xml_slab_chunk)+15) & ~(size_t)15)
+
+/*! Slab of fixed-size XML objects, one for elements and one for body/attributes
+ */
+struct xml_slab{
+    size_t                 sl_size;    /* Object size */
+    struct xml_slab_chunk *sl_partial; /* Chunks with at least one free object */
+    uint64_t               sl_chunks;  /* Number of allocated chunks */
+};
+
+static struct xml_slab _xml_slab_elmnt = {sizeof(struct xml), NULL, 0};
+static struct xml_slab _xml_slab_body = {sizeof(struct xmlbody), NULL, 0};
+static int             _xml_slab_atexit = 0;
+
+/*! Free all remaining unused chunks of a slab
+ *
+ * @param[in]  sl   Slab
+ */
+static void
+xml_slab_free_unused(struct xml_slab *sl)
+{
+    struct xml_slab_chunk *sc;
+    struct xml_slab_chunk *scnext;
+    int                    nr;
+    int                    i;
+
+    if ((sc = sl->sl_partial) == NULL)
+        return;
+    nr = 1;
+    while ((sc = NEXTQ(struct xml_slab_chunk *, sc)) != sl->sl_partial)
+        nr++;
+    sc = sl->sl_partial;
+    for (i=0; i<nr; i++){
+        scnext = NEXTQ(struct xml_slab_chunk *, sc);
+        if (sc->sc_used == 0){
+            DELQ(sc, sl->sl_partial, struct xml_slab_chunk *);
+            free(sc);
+            sl->sl_chunks--;
+        }
+        sc = scnext;
+    }
+}
+
+/*! Release spare slab chunks on exit, so that memory checkers see no reachable memory
+ */
+static void
+xml_slab_exit(void)
+{
+    xml_slab_free_unused(&_xml_slab_elmnt);
+    xml_slab_free_unused(&_xml_slab_body);
+}
+
+/*! Allocate a zeroed XML object from a slab
+ *
+ * @param[in]  sl   Slab
+ * @retval     obj  Allocated object
+ * @retval     NULL Error
+ */
+static void *
+xml_slab_alloc(struct xml_slab *sl)
+{
+    struct xml_slab_chunk *sc;
+    char                  *p;
+    void                  *obj;
+    int                    ret;
+    size_t                 nr;
+    size_t                 i;
+
+    if ((sc = sl->sl_partial) == NULL){
+        if ((ret = posix_memalign((void**)&sc, XML_SLAB_CHUNK_SIZE, XML_SLAB_CHUNK_SIZE)) != 0){
+            clixon_err(OE_XML, ret, "posix_memalign");
+            return NULL;
+        }
+        memset(sc, 0, sizeof(*sc));
+        sc->sc_slab = sl;
+        /* Thread objects in ascending address order */
+        p = (char*)sc + XML_SLAB_HDR_SIZE;
+        nr = (XML_SLAB_CHUNK_SIZE - XML_SLAB_HDR_SIZE)/sl->sl_size;
+        for (i=nr; i>0; i--){
+            obj = p + (i-1)*sl->sl_size;
+            *(void**)obj = sc->sc_free;
+            sc->sc_free = obj;
+        }
+        ADDQ(sc, sl->sl_partial);
+        sc->sc_inq = 1;
+        sl->sl_chunks++;
+        if (_xml_slab_atexit == 0){
+            atexit(xml_slab_exit);
+            _xml_slab_atexit++;
+        }
+    }
+    obj = sc->sc_free;
+    sc->sc_free = *(void**)obj;
+    sc->sc_used++;
+    if (sc->sc_free == NULL){
+        DELQ(sc, sl->sl_partial, struct xml_slab_chunk *);
+        sc->sc_inq = 0;
+    }
+    memset(obj, 0, sl->sl_size);
+    return obj;
+}
+
+/*! Return an XML object to its slab
+ *
+ * An empty chunk is released unless it is the only chunk with free objects, to avoid
+ * allocating and releasing a chunk repeatedly on a boundary.
+ * @param[in]  obj  Object allocated with xml_slab_alloc
+ */
+static void
+xml_slab_free(void *obj)
+{
+    struct xml_slab_chunk *sc;
+    struct xml_slab       *sl;
+
+    sc = (struct xml_slab_chunk *)((uintptr_t)obj & ~(uintptr_t)(XML_SLAB_CHUNK_SIZE-1));
+    sl = sc->sc_slab;
+    *(void**)obj = sc->sc_free;
+    sc->sc_free = obj;
+    sc->sc_used--;
+    if (!sc->sc_inq){
+        ADDQ(sc, sl->sl_partial);
+        sc->sc_inq = 1;
+    }
+    if (sc->sc_used == 0 && NEXTQ(struct xml_slab_chunk *, sc) != sc){
+        DELQ(sc, sl->sl_partial, struct xml_slab_chunk *);
+        free(sc);
+        sl->sl_chunks--;
+    }
+}
+#endif /* XML_SLAB_ALLOC */
+
+/* Initial number of buckets in the XML name intern table, must be a power of two */
+#define XML_INTERN_SIZE_START 256
+
+/*! Interned string shared by all XML objects with the same name or prefix
+ *
+ * The string is placed last so that the header can be found from the string pointer.
+ */
+struct xml_istr{
+    struct xml_istr *is_next;   /* Next in hash bucket */
+    uint32_t         is_hash;   /* Hash of string */
+    uint32_t         is_refcnt; /* Number of XML objects referencing this string */
+    char             is_str[];  /* Null-terminated string */
+};
+
+/* Global intern table of XML names and prefixes (too low-level to hang it on handle) */
+static struct xml_istr **_xml_intern_vec = NULL;
+static uint32_t          _xml_intern_size = 0; /* Number of buckets */
+static uint32_t          _xml_intern_nr = 0;   /* Number of interned strings */
+
+/*! Double the number of buckets of the intern table
+ *
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_intern_grow(void)
+{
+    struct xml_istr **vec;
+    struct xml_istr  *is;
+    uint32_t          size;
+    uint32_t          i;
+
+    size = _xml_intern_size ? 2*_xml_intern_size : XML_INTERN_SIZE_START;
+    if ((vec = calloc(size, sizeof(struct xml_istr *))) == NULL){
+        clixon_err(OE_XML, errno, "calloc");
+        return -1;
+    }
+    for (i=0; i<_xml_intern_size; i++){
+        while ((is = _xml_intern_vec[i]) != NULL){
+            _xml_intern_vec[i] = is->is_next;
+            is->is_next = vec[is->is_hash & (size-1)];
+            vec[is->is_hash & (size-1)] = is;
+        }
+    }
+    if (_xml_intern_vec)
+        free(_xml_intern_vec);
+    _xml_intern_vec = vec;
+    _xml_intern_size = size;
+    return 0;
+}
+
+/*! Get a shared immutable copy of a string, increment its reference count
+ *
+ * @param[in]  str   Null-terminated string
+ * @retval     istr  Interned string, release with xml_intern_release
+ * @retval     NULL  Error
+ */
+static char *
+xml_intern(const char *str)
+{
+    struct xml_istr *is;
+    uint32_t         h;
+    size_t           len;
+
+    h = clicon_hash_fnv1a(str);
+    if (_xml_intern_size){
+        for (is = _xml_intern_vec[h & (_xml_intern_size-1)]; is; is = is->is_next)
+            if (is->is_hash == h && strcmp(is->is_str, str) == 0){
+                is->is_refcnt++;
+                return is->is_str;
+            }
+    }
+    if (_xml_intern_nr >= _xml_intern_size &&
+        xml_intern_grow() < 0)
+        return NULL;
+    len = strlen(str);
+    if ((is = malloc(sizeof(*is) + len + 1)) == NULL){
+        clixon_err(OE_XML, errno, "malloc");
+        return NULL;
+    }
+    memcpy(is->is_str, str, len+1);
+    is->is_hash = h;
+    is->is_refcnt = 1;
+    is->is_next = _xml_intern_vec[h & (_xml_intern_size-1)];
+    _xml_intern_vec[h & (_xml_intern_size-1)] = is;
+    _xml_intern_nr++;
+    return is->is_str;
+}
+
+/*! Add a reference to an already interned string
+ *
+ * Faster than xml_intern since no lookup is necessary, used when copying
+ * @param[in]  str   String returned by xml_intern
+ * @retval     str   Same string
+ */
+static char *
+xml_intern_ref(char *str)
+{
+    struct xml_istr *is;
+
+    is = (struct xml_istr *)(str - offsetof(struct xml_istr, is_str));
+    is->is_refcnt++;
+    return str;
+}
+
+/*! Release an interned string, free it when the last reference is gone
+ *
+ * The bucket vector is freed when the table becomes empty
+ * @param[in]  str   String returned by xml_intern
+ */
+static void
+xml_intern_release(char *str)
+{
+    struct xml_istr  *is;
+    struct xml_istr **isp;
+
+    is = (struct xml_istr *)(str - offsetof(struct xml_istr, is_str));
+    if (--is->is_refcnt > 0)
+        return;
+    for (isp = &_xml_intern_vec[is->is_hash & (_xml_intern_size-1)]; *isp; isp = &(*isp)->is_next)
+        if (*isp == is){
+            *isp = is->is_next;
+            break;
+        }
+    free(is);
+    if (--_xml_intern_nr == 0){
+        free(_xml_intern_vec);
+        _xml_intern_vec = NULL;
+        _xml_intern_size = 0;
+    }
+}
+
 /* Stats (too low-level to hang it on handle) */
 static uint64_t _stats_xml_nr = 0;
 
@@ -254,7 +541,7 @@ xml_stats_global(uint64_t *nr)
  * @param[in]   x    XML object
  * @param[out]  szp  Size of this XML obj
  * @retval      0    OK
- * (baseline: 96 bytes per object on x86-64)
+ * (element: 96 bytes and body: 64 bytes per object on x86-64)
  */
 static int
 xml_stats_one(cxobj    *x,
@@ -262,10 +549,7 @@ xml_stats_one(cxobj    *x,
 {
     size_t sz = 0;
 
-    if (x->x_name)
-        sz += strlen(x->x_name) + 1;
-    if (x->x_prefix)
-        sz += strlen(x->x_prefix) + 1;
+    /* Name and prefix are interned and shared, not counted per object */
     switch (xml_type(x)){
     case CX_ELMNT:
         sz += sizeof(struct xml);
@@ -288,8 +572,7 @@ xml_stats_one(cxobj    *x,
     case CX_BODY:
     case CX_ATTR:
         sz += sizeof(struct xmlbody);
-        if (x->x_value_cb)
-            sz += cbuf_buflen(x->x_value_cb);
+        sz += xml2body(x)->xb_value_max;
         break;
     default:
         break;
@@ -343,6 +626,8 @@ xml_stats(cxobj    *xt,
  *
  * @param[in]  xn    xml node
  * @retval     name of xml node
+ * @note The name is interned and shared by all XML objects with the same name: do not modify
+ *       or free it, use xml_name_set. Not const for compatibility with existing callers
  */
 char*
 xml_name(cxobj *xn)
@@ -355,6 +640,7 @@ xml_name(cxobj *xn)
 
 /*! Set name of xnode, name is copied
  *
+ * Names are interned: all XML objects with the same name share one immutable string
  * @param[in]  xn    xml node
  * @param[in]  name  new name, null-terminated string, copied by function
  * @retval     0     OK
@@ -364,16 +650,13 @@ int
 xml_name_set(cxobj *xn,
              const char  *name)
 {
-    if (xn->x_name){
-        free(xn->x_name);
-        xn->x_name = NULL;
-    }
-    if (name){
-        if ((xn->x_name = strdup(name)) == NULL){
-            clixon_err(OE_XML, errno, "strdup");
-            return -1;
-        }
-    }
+    char *str = NULL;
+
+    if (name && (str = xml_intern(name)) == NULL)
+        return -1;
+    if (xn->x_name)
+        xml_intern_release(xn->x_name);
+    xn->x_name = str;
     return 0;
 }
 
@@ -381,6 +664,7 @@ xml_name_set(cxobj *xn,
  *
  * @param[in]  xn     xml node
  * @retval     prefix of xml node
+ * @note The prefix is interned and shared, do not modify or free it, see xml_name
  */
 char*
 xml_prefix(cxobj *xn)
@@ -390,6 +674,7 @@ xml_prefix(cxobj *xn)
 
 /*! Set prefix of xnode, prefix is copied
  *
+ * Prefixes are interned in the same way as names
  * @param[in]  xn      XML node
  * @param[in]  prefix  New prefix, null-terminated string, copied by function
  * @retval     0       OK
@@ -399,16 +684,13 @@ int
 xml_prefix_set(cxobj *xn,
                const char  *prefix)
 {
-    if (xn->x_prefix){
-        free(xn->x_prefix);
-        xn->x_prefix = NULL;
-    }
-    if (prefix){
-        if ((xn->x_prefix = strdup(prefix)) == NULL){
-            clixon_err(OE_XML, errno, "strdup");
-            return -1;
-        }
-    }
+    char *str = NULL;
+
+    if (prefix && (str = xml_intern(prefix)) == NULL)
+        return -1;
+    if (xn->x_prefix)
+        xml_intern_release(xn->x_prefix);
+    xn->x_prefix = str;
     return 0;
 }
 
@@ -649,7 +931,43 @@ xml_value(cxobj *xn)
 {
     if (!is_bodyattr(xn))
         return NULL;
-    return xn->x_value_cb?cbuf_get(xn->x_value_cb):NULL;
+    return xml2body(xn)->xb_value;
+}
+
+/*! Ensure allocated size of body/attribute value
+ *
+ * Grow geometrically if appending to existing value so that repeated appends by the parser
+ * are amortized, but allocate exact size on first set.
+ * @param[in]  xb    xml body or attribute node
+ * @param[in]  sz    Total size needed, including null-termination
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_value_alloc(struct xmlbody *xb,
+                size_t          sz)
+{
+    size_t newmax;
+    char  *v;
+
+    if (sz > UINT32_MAX){
+        clixon_err(OE_XML, EINVAL, "Value too large: %zu", sz);
+        return -1;
+    }
+    if (sz <= xb->xb_value_max)
+        return 0;
+    newmax = sz;
+    if (xb->xb_value_len && newmax < 2*(size_t)xb->xb_value_max)
+        newmax = 2*(size_t)xb->xb_value_max;
+    if (newmax > UINT32_MAX)
+        newmax = UINT32_MAX;
+    if ((v = realloc(xb->xb_value, newmax)) == NULL){
+        clixon_err(OE_XML, errno, "realloc");
+        return -1;
+    }
+    xb->xb_value = v;
+    xb->xb_value_max = newmax;
+    return 0;
 }
 
 /*! Set value of xml node, value is copied
@@ -663,8 +981,9 @@ int
 xml_value_set(cxobj *xn,
               const char  *val)
 {
-    int    retval = -1;
-    size_t sz;
+    int             retval = -1;
+    struct xmlbody *xb;
+    size_t          len;
 
     if (!is_bodyattr(xn))
         return 0;
@@ -672,16 +991,13 @@ xml_value_set(cxobj *xn,
         clixon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-        if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-            clixon_err(OE_XML, errno, "cbuf_new");
-            goto done;
-        }
-    }
-    else
-        cbuf_reset(xn->x_value_cb);
-    cbuf_append_str(xn->x_value_cb, val);
+    xb = xml2body(xn);
+    len = strlen(val);
+    xb->xb_value_len = 0;
+    if (xml_value_alloc(xb, len+1) < 0)
+        goto done;
+    memcpy(xb->xb_value, val, len+1);
+    xb->xb_value_len = len;
     retval = 0;
  done:
     return retval;
@@ -698,8 +1014,9 @@ int
 xml_value_append(cxobj *xn,
                  const char  *val)
 {
-    int    retval = -1;
-    size_t sz;
+    int             retval = -1;
+    struct xmlbody *xb;
+    size_t          len;
 
     if (!is_bodyattr(xn))
         return 0;
@@ -707,17 +1024,12 @@ xml_value_append(cxobj *xn,
         clixon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-        if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-            clixon_err(OE_XML, errno, "cbuf_new");
-            goto done;
-        }
-    }
-    if (cbuf_append_str(xn->x_value_cb, val) < 0){
-        clixon_err(OE_XML, errno, "cprintf");
+    xb = xml2body(xn);
+    len = strlen(val);
+    if (xml_value_alloc(xb, xb->xb_value_len+len+1) < 0)
         goto done;
-    }
+    memcpy(xb->xb_value+xb->xb_value_len, val, len+1);
+    xb->xb_value_len += len;
     retval = 0;
  done:
     return retval;
@@ -1190,11 +1502,16 @@ xml_new(const char           *name,
         return NULL;
         break;
     }
+#ifdef XML_SLAB_ALLOC
+    if ((x = xml_slab_alloc(sz==sizeof(struct xml)?&_xml_slab_elmnt:&_xml_slab_body)) == NULL)
+        return NULL;
+#else
     if ((x = malloc(sz)) == NULL){
         clixon_err(OE_XML, errno, "malloc");
         return NULL;
     }
     memset(x, 0, sz);
+#endif
     xml_type_set(x, type);
     if (name && (xml_name_set(x, name)) < 0)
         return NULL;
@@ -1334,7 +1651,7 @@ xml_find(cxobj *xp,
     if (!is_element(xp))
         return NULL;
     while ((x = xml_child_each(xp, x, -1)) != NULL)
-        if (strcmp(name, xml_name(x)) == 0)
+        if (name == xml_name(x) || strcmp(name, xml_name(x)) == 0)
             break; /* x is set */
     return x;
 }
@@ -1846,11 +2163,12 @@ xml_find_type(cxobj          *xt,
     while ((x = xml_child_each(xt, x, type)) != NULL) {
         if (prefix){
             xprefix = xml_prefix(x);
-            pmatch = xprefix ? strcmp(prefix,xprefix)==0 : 0;
+            pmatch = xprefix ? (prefix == xprefix || strcmp(prefix,xprefix)==0) : 0;
         }
         else
             pmatch = 1;
-        if (pmatch && (name==NULL || strcmp(name, xml_name(x)) == 0))
+        /* Pointer compare first: name is often the (interned) name of another XML object */
+        if (pmatch && (name==NULL || name == xml_name(x) || strcmp(name, xml_name(x)) == 0))
             return x;
     }
     return NULL;
@@ -1962,9 +2280,9 @@ xml_free0(cxobj *x)
     if (x == NULL)
         return 0;
     if (x->x_name)
-        free(x->x_name);
+        xml_intern_release(x->x_name);
     if (x->x_prefix)
-        free(x->x_prefix);
+        xml_intern_release(x->x_prefix);
     switch (xml_type(x)){
     case CX_ELMNT:
         sz = sizeof(struct xml);
@@ -1987,8 +2305,8 @@ xml_free0(cxobj *x)
     case CX_BODY:
     case CX_ATTR:
         sz = sizeof(struct xmlbody);
-        if (x->x_value_cb)
-            cbuf_free(x->x_value_cb);
+        if (xml2body(x)->xb_value)
+            free(xml2body(x)->xb_value);
         break;
     default:
         break;
@@ -2009,7 +2327,11 @@ xml_free(cxobj *x)
     if (x == NULL)
         return 0;
     xml_free0(x);
+#ifdef XML_SLAB_ALLOC
+    xml_slab_free(x);
+#else
     free(x);
+#endif
     _stats_xml_nr--;
     return 0;
 }
@@ -2033,12 +2355,17 @@ xml_copy_one(cxobj *x0,
         goto done;
     }
     xml_type_set(x1, xml_type(x0));
-    if ((s = xml_name(x0))) /* malloced string */
-        if ((xml_name_set(x1, s)) < 0)
-            goto done;
-    if ((s = xml_prefix(x0))) /* malloced string */
-        if ((xml_prefix_set(x1, s)) < 0)
-            goto done;
+    /* Names and prefixes are interned: share them without lookup */
+    if (x1->x_name != x0->x_name){
+        if (x1->x_name)
+            xml_intern_release(x1->x_name);
+        x1->x_name = x0->x_name ? xml_intern_ref(x0->x_name) : NULL;
+    }
+    if (x1->x_prefix != x0->x_prefix){
+        if (x1->x_prefix)
+            xml_intern_release(x1->x_prefix);
+        x1->x_prefix = x0->x_prefix ? xml_intern_ref(x0->x_prefix) : NULL;
+    }
     switch (xml_type(x0)){
     case CX_ELMNT:
         xml_spec_set(x1, xml_spec(x0));
@@ -2054,7 +2381,7 @@ xml_copy_one(cxobj *x0,
     default:
         break;
     }
-    xml_flag_set(x1, xml_flag(x0, XML_FLAG_DEFAULT | XML_FLAG_TOP | XML_FLAG_ANYDATA | XML_FLAG_CACHE_DIRTY)); /* Maybe more flags */
+    xml_flag_set(x1, xml_flag(x0, XML_FLAG_DEFAULT | XML_FLAG_TOP | XML_FLAG_ANYDATA | XML_FLAG_CACHE_DIRTY | XML_FLAG_DIFF)); /* Maybe more flags */
     retval = 0;
  done:
     return retval;
@@ -2085,9 +2412,19 @@ xml_copy(cxobj *x0,
 
     if (xml_copy_one(x0, x1) <0)
         goto done;
+    /* Allocate exact child vector up-front if destination is empty */
+    if (is_element(x1) && x1->x_childvec_len == 0 &&
+        xml_child_nr(x0) > x1->x_childvec_max){
+        if ((x1->x_childvec = realloc(x1->x_childvec, xml_child_nr(x0)*sizeof(cxobj*))) == NULL){
+            clixon_err(OE_XML, errno, "realloc");
+            goto done;
+        }
+        x1->x_childvec_max = xml_child_nr(x0);
+    }
     x = NULL;
     while ((x = xml_child_each(x0, x, -1)) != NULL) {
-        if ((xcopy = xml_new(xml_name(x), x1, xml_type(x))) == NULL)
+        /* Name is set by xml_copy_one */
+        if ((xcopy = xml_new(NULL, x1, xml_type(x))) == NULL)
             goto done;
         if (xml_copy(x, xcopy) < 0) /* recursion */
             goto done;
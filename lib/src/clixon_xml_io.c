@@ -55,6 +55,7 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -92,6 +93,50 @@
 /* Size of xml read buffer */
 #define BUFLEN 1024
 
+/* Binary snapshot format, see clixon_xml2binary_file */
+#define XML_BINARY_MAGIC   "CLXB"
+#define XML_BINARY_VERSION 1          /* Also detects other byte order */
+#define XML_BINARY_NONE    0xffffffff /* No string, eg no prefix */
+
+/*
+ * Types
+ */
+/* Binary snapshot file header */
+struct xml_binary_hdr{
+    char     xb_magic[4];  /* XML_BINARY_MAGIC */
+    uint32_t xb_version;   /* XML_BINARY_VERSION */
+    uint32_t xb_strlen;    /* Length of string table in bytes */
+    uint32_t xb_nodes;     /* Number of node records */
+};
+
+/* Binary snapshot node record, strings are offsets into string table */
+struct xml_binary_node{
+    uint32_t xn_type;      /* enum cxobj_type */
+    uint32_t xn_name;
+    uint32_t xn_prefix;    /* or XML_BINARY_NONE */
+    uint32_t xn_value;     /* Body and attribute value or XML_BINARY_NONE */
+    uint32_t xn_nchildren; /* Number of child records following, incl attributes */
+};
+
+/* Binary snapshot write argument */
+struct xml_binary_arg{
+    cbuf             *xa_strtab;      /* String table */
+    cbuf             *xa_nodes;       /* Node records */
+    clicon_hash_t    *xa_strhash;     /* String -> offset in string table */
+    uint32_t          xa_nr;          /* Number of node records */
+    withdefaults_type xa_wdef;
+    int               xa_system_only;
+};
+
+/* Binary snapshot read argument, pointers into mapped file */
+struct xml_binary_read{
+    char     *xr_strtab;
+    uint32_t  xr_strlen;
+    char     *xr_nodes;
+    uint32_t  xr_nr;       /* Number of node records */
+    uint32_t  xr_i;        /* Next node record */
+};
+
 /* Forward */
 static int xml_diff2cbuf(cbuf *cb, cxobj *x0, cxobj *x1, int level, int skiptop);
 
@@ -192,6 +237,52 @@ xml2output_wdef(cxobj            *x,
     return retval;
 }
 
+/*! Remove nodes from an XML tree that would not be printed with a with-defaults mode
+ *
+ * Same as when printing with clixon_xml2cbuf1 with wdef, but applied on the tree, eg
+ * before printing as JSON
+ * @param[in]   xt   Clixon xml tree
+ * @param[in]   wdef With-defaults parameter, WITHDEFAULTS_REPORT_ALL_TAGGED not supported
+ * @retval      0    OK
+ * @retval     -1    Error
+ * @see xml2output_wdef
+ */
+int
+xml_tree_prune_wdef(cxobj            *xt,
+                    withdefaults_type wdef)
+{
+    int    retval = -1;
+    cxobj *xc;
+    cxobj *xprev;
+    int    ret;
+
+    if (wdef == WITHDEFAULTS_REPORT_ALL_TAGGED){
+        clixon_err(OE_XML, EINVAL, "with-defaults report-all-tagged not supported");
+        goto done;
+    }
+    if (wdef == WITHDEFAULTS_REPORT_ALL)
+        goto ok;
+    xprev = NULL;
+    xc = NULL;
+    while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL) {
+        if ((ret = xml2output_wdef(xc, wdef, NULL)) < 0)
+            goto done;
+        if (ret == 0){
+            if (xml_purge(xc) < 0)
+                goto done;
+            xc = xprev;
+            continue;
+        }
+        if (xml_tree_prune_wdef(xc, wdef) < 0)
+            goto done;
+        xprev = xc;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Print an XML tree structure to an output stream and encode chars "<>&"
  *
  * @param[in]   f          UNIX output stream
@@ -546,6 +637,14 @@ xml_dump(FILE  *f,
     return xml_dump1(f, x, 0);
 }
 
+/* Flush state of xml2cbuf_recurse, see clixon_xml2cbuf_flush
+ */
+struct xml2cbuf_flush {
+    size_t                xf_chunk; /* Flush when buffer exceeds this size */
+    clixon_cbuf_flush_cb *xf_fn;    /* Flush callback, consumes buffer */
+    void                 *xf_arg;   /* Flush callback argument */
+};
+
 /*! Internal: print XML tree structure to a cligen buffer and encode chars "<>&"
  *
  * @param[in,out] cb       Cligen buffer to write to
@@ -555,6 +654,7 @@ xml_dump(FILE  *f,
  * @param[in]     prefix   Add string to beginning of each line (if pretty)
  * @param[in]     depth    Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
  * @param[in]     wdef     With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @param[in]     xf       Flush buffer when it exceeds chunk size (or NULL)
  * @retval        0        OK
  * @retval       -1        Error
  * wdef changes the output as follows:
@@ -571,7 +671,8 @@ xml2cbuf_recurse(cbuf             *cb,
                  int               pretty,
                  char             *prefix,
                  int32_t           depth,
-                 withdefaults_type wdef)
+                 withdefaults_type wdef,
+                 struct xml2cbuf_flush *xf)
 {
     int        retval = -1;
     cxobj     *xc;
@@ -636,7 +737,7 @@ xml2cbuf_recurse(cbuf             *cb,
         while ((xc = xml_child_each(x, xc, -1)) != NULL)
             switch (xml_type(xc)){
             case CX_ATTR:
-                if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, -1, wdef) < 0)
+                if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, -1, wdef, NULL) < 0)
                     goto done;
                 break;
             case CX_BODY:
@@ -673,12 +774,16 @@ xml2cbuf_recurse(cbuf             *cb,
                             xa = xml_find_type(xc, IETF_NETCONF_WITH_DEFAULTS_ATTR_PREFIX, IETF_NETCONF_WITH_DEFAULTS_ATTR_NAMESPACE, CX_ATTR);
                         }
                     }
-                    if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, depth-1, wdef) < 0)
+                    if (xml2cbuf_recurse(cb, xc, level+1, pretty, prefix, depth-1, wdef, xf) < 0)
                         goto done;
                     if (xa){
                         if (xml_purge(xa) < 0)
                             goto done;
                     }
+                    if (xf && cbuf_len(cb) >= xf->xf_chunk){
+                        if (xf->xf_fn(cb, xf->xf_arg) < 0)
+                            goto done;
+                    }
                 }
             if (pretty && hasbody == 0){
                 if (prefix)
@@ -744,11 +849,65 @@ clixon_xml2cbuf1(cbuf             *cb,
     if (skiptop){
         xc = NULL;
         while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
-            if (xml2cbuf_recurse(cb, xc, level, pretty, prefix, depth, wdef) < 0)
+            if (xml2cbuf_recurse(cb, xc, level, pretty, prefix, depth, wdef, NULL) < 0)
                 goto done;
     }
     else {
-        if (xml2cbuf_recurse(cb, xn, level, pretty, prefix, depth, wdef) < 0)
+        if (xml2cbuf_recurse(cb, xn, level, pretty, prefix, depth, wdef, NULL) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Print an XML tree structure to a cligen buffer in chunks
+ *
+ * Same as clixon_xml2cbuf1 but the buffer is handed to a flush callback whenever it
+ * exceeds a chunk size. The callback is expected to consume, ie write and reset, the
+ * buffer. This bounds the buffer to approximately the chunk size plus the size of a
+ * single element instead of the size of the whole tree.
+ * The remainder is left in the buffer on return.
+ * @param[in,out] cb      Cligen buffer to write to
+ * @param[in]     xn      Top-level xml object
+ * @param[in]     level   Indentation level for pretty
+ * @param[in]     pretty  Insert \n and spaces to make the xml more readable.
+ * @param[in]     prefix  Add string to beginning of each line (or NULL) (if pretty)
+ * @param[in]     depth   Limit levels of child resources: -1: all, 0: none, 1: node itself
+ * @param[in]     skiptop 0: Include top object 1: Skip top-object, only children,
+ * @param[in]     wdef    With-defaults parameter, default is WITHDEFAULTS_REPORT_ALL
+ * @param[in]     chunk   Flush buffer when its length exceeds this
+ * @param[in]     fn      Flush callback
+ * @param[in]     arg     Flush callback argument
+ * @retval        0       OK
+ * @retval       -1       Error
+ * @see clixon_xml2cbuf1
+ */
+int
+clixon_xml2cbuf_flush(cbuf                 *cb,
+                      cxobj                *xn,
+                      int                   level,
+                      int                   pretty,
+                      char                 *prefix,
+                      int32_t               depth,
+                      int                   skiptop,
+                      withdefaults_type     wdef,
+                      size_t                chunk,
+                      clixon_cbuf_flush_cb *fn,
+                      void                 *arg)
+{
+    int                   retval = -1;
+    cxobj                *xc;
+    struct xml2cbuf_flush xf = {chunk, fn, arg};
+
+    if (skiptop){
+        xc = NULL;
+        while ((xc = xml_child_each(xn, xc, CX_ELMNT)) != NULL)
+            if (xml2cbuf_recurse(cb, xc, level, pretty, prefix, depth, wdef, &xf) < 0)
+                goto done;
+    }
+    else {
+        if (xml2cbuf_recurse(cb, xn, level, pretty, prefix, depth, wdef, &xf) < 0)
             goto done;
     }
     retval = 0;
@@ -835,8 +994,9 @@ xmltree2cbuf(cbuf  *cb,
  *--------------------------------------------------------------------*/
 /*! Common internal xml parsing function string to parse-tree
  *
- * Given a string containing XML, parse into existing XML tree and return
- * @param[in]     str   Pointer to string containing XML definition.
+ * Given a string or file containing XML, parse into existing XML tree and return
+ * @param[in]     str   Pointer to string containing XML definition, or NULL if fp is set
+ * @param[in]     fp    File to parse from if str is NULL, read by the scanner in blocks
  * @param[in]     yb    How to bind yang to XML top-level when parsing
  * @param[in]     yspec Yang specification (only if bind is TOP or CONFIG)
  * @param[in,out] xtop  Top of XML parse tree. Assume created. Holds new tree.
@@ -861,6 +1021,7 @@ xmltree2cbuf(cbuf  *cb,
  */
 static int
 _xml_parse(const char *str,
+           FILE       *fp,
            yang_bind   yb,
            yang_stmt  *yspec,
            cxobj      *xt,
@@ -872,21 +1033,39 @@ _xml_parse(const char *str,
     int             ret;
     int             failed = 0; /* yang assignment */
     int             i;
+    size_t          len;
 
-    if (clixon_debug_get() & CLIXON_DBG_DETAIL)
-        clixon_debug(CLIXON_DBG_PARSE | CLIXON_DBG_DETAIL, "%s", str);
-    else
-        clixon_debug(CLIXON_DBG_PARSE & CLIXON_DBG_TRUNC, "%s", str);
-    if (strlen(str) == 0){
-        return 1; /* OK */
+    if (str == NULL){
+        clixon_debug(CLIXON_DBG_PARSE | CLIXON_DBG_DETAIL, "file");
+        if ((i = fgetc(fp)) == EOF)
+            return 1; /* OK, empty */
+        ungetc(i, fp);
+    }
+    else {
+        if (clixon_debug_get() & CLIXON_DBG_DETAIL)
+            clixon_debug(CLIXON_DBG_PARSE | CLIXON_DBG_DETAIL, "%s", str);
+        else
+            clixon_debug(CLIXON_DBG_PARSE & CLIXON_DBG_TRUNC, "%s", str);
+        if ((len = strlen(str)) == 0){
+            return 1; /* OK */
+        }
     }
     if (xt == NULL){
         clixon_err(OE_XML, errno, "Unexpected NULL XML");
         return -1;
     }
-    if ((xy.xy_parse_string = strdup(str)) == NULL){
-        clixon_err(OE_XML, errno, "strdup");
-        return -1;
+    if (str == NULL)
+        xy.xy_parse_file = fp;
+    else {
+        /* Scanner works in place on a writable copy terminated by two NULL chars */
+        if ((xy.xy_parse_string = malloc(len + 2)) == NULL){
+            clixon_err(OE_XML, errno, "malloc");
+            return -1;
+        }
+        memcpy(xy.xy_parse_string, str, len);
+        xy.xy_parse_string[len] = '\0';
+        xy.xy_parse_string[len+1] = '\0';
+        xy.xy_parse_len = len;
     }
     xy.xy_xtop = xt;
     xy.xy_xparent = xt;
@@ -1000,13 +1179,6 @@ clixon_xml_parse_file(FILE      *fp,
 {
     int   retval = -1;
     int   ret;
-    int   len = 0;
-    char  ch;
-    char *xmlbuf = NULL;
-    char *ptr;
-    int   xmlbuflen = BUFLEN; /* start size */
-    int   oldxmlbuflen;
-    int   failed = 0;
     int   xtempty; /* empty on entry */
 
     if (xt == NULL || fp == NULL){
@@ -1018,49 +1190,18 @@ clixon_xml_parse_file(FILE      *fp,
         clixon_err(OE_XML, EINVAL, "yspec is required if yb == YB_MODULE");
         return -1;
     }
-    if ((xmlbuf = malloc(xmlbuflen)) == NULL){
-        clixon_err(OE_XML, errno, "malloc");
+    if (*xt == NULL)
+        if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    /* Parse directly from file, the XML text is not buffered in memory */
+    if ((ret = _xml_parse(NULL, fp, yb, yspec, *xt, xerr)) < 0)
         goto done;
-    }
-    memset(xmlbuf, 0, xmlbuflen);
-    ptr = xmlbuf;
-    while (1){
-        if ((ret = fread(&ch, 1, 1, fp)) < 0){
-            clixon_err(OE_XML, errno, "read");
-            break;
-        }
-        if (ret != 0){
-            xmlbuf[len++] = ch;
-        }
-        if (ret == 0) {
-            if (*xt == NULL)
-                if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-                    goto done;
-            if ((ret = _xml_parse(ptr, yb, yspec, *xt, xerr)) < 0)
-                goto done;
-            if (ret == 0)
-                failed++;
-            break;
-        }
-        if (len >= xmlbuflen-1){ /* Space: one for the null character */
-            oldxmlbuflen = xmlbuflen;
-            xmlbuflen *= 2;
-            if ((xmlbuf = realloc(xmlbuf, xmlbuflen)) == NULL){
-                clixon_err(OE_XML, errno, "realloc");
-                goto done;
-            }
-            memset(xmlbuf+oldxmlbuflen, 0, xmlbuflen-oldxmlbuflen);
-            ptr = xmlbuf;
-        }
-    } /* while */
-    retval = (failed==0) ? 1 : 0;
+    retval = ret;
  done:
     if (retval < 0 && *xt && xtempty){
-        free(*xt);
+        xml_free(*xt);
         *xt = NULL;
     }
-    if (xmlbuf)
-        free(xmlbuf);
     return retval;
 }
 
@@ -1109,7 +1250,7 @@ clixon_xml_parse_string(const char *str,
         if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
             return -1;
     }
-    return _xml_parse(str, yb, yspec, *xt, xerr);
+    return _xml_parse(str, NULL, yb, yspec, *xt, xerr);
 }
 
 /*! Read XML from var-arg list and parse it into xml tree
@@ -1165,6 +1306,336 @@ clixon_xml_parse_va(yang_bind   yb,
     return retval;
 }
 
+/*------------------------------------------------------------------------
+ * Binary snapshot format, used for datastores, see FORMAT_BINARY
+ * File layout, in host byte order:
+ *   header   struct xml_binary_hdr
+ *   strings  xb_strlen bytes of unique null-terminated strings
+ *   nodes    xb_nodes records of struct xml_binary_node in pre-order
+ * Names, prefixes and values are offsets into the string table, ie each unique
+ * string is stored once.
+ * Children are stored in tree order, ie already sorted if written from the cache
+ *------------------------------------------------------------------------*/
+
+/*! Get offset of string in binary string table, add it if not present
+ *
+ * @param[in]  xa    Binary write argument
+ * @param[in]  str   String, or NULL
+ * @param[out] offp  Offset in string table, or XML_BINARY_NONE if str is NULL
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml2binary_str(struct xml_binary_arg *xa,
+               char                  *str,
+               uint32_t              *offp)
+{
+    int       retval = -1;
+    uint32_t *valp;
+    uint32_t  off;
+
+    if (str == NULL){
+        *offp = XML_BINARY_NONE;
+        goto ok;
+    }
+    if ((valp = clicon_hash_value(xa->xa_strhash, str, NULL)) != NULL){
+        *offp = *valp;
+        goto ok;
+    }
+    off = cbuf_len(xa->xa_strtab);
+    if (cbuf_append_buf(xa->xa_strtab, str, strlen(str)+1) < 0){
+        clixon_err(OE_XML, errno, "cbuf_append_buf");
+        goto done;
+    }
+    if (clicon_hash_add(xa->xa_strhash, str, &off, sizeof(off)) == NULL)
+        goto done;
+    *offp = off;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Add XML node and its children as binary node records
+ *
+ * @param[in]  x     XML node
+ * @param[in]  xa    Binary write argument
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xml2file_recurse  for with-defaults and system-only-config handling
+ */
+static int
+xml2binary_recurse(cxobj                 *x,
+                   struct xml_binary_arg *xa)
+{
+    int                    retval = -1;
+    struct xml_binary_node xn = {0,};
+    yang_stmt             *y;
+    cxobj                 *xc;
+    size_t                 pos;
+    uint32_t               nr;
+    int                    exist;
+    int                    ret;
+
+    if ((y = xml_spec(x)) != NULL){
+        if (xa->xa_system_only){
+            exist = 0;
+            if (yang_extension_value(y, "system-only-config", CLIXON_LIB_NS, &exist, NULL) < 0)
+                goto done;
+            if (exist)
+                goto ok;
+        }
+        if ((ret = xml2output_wdef(x, xa->xa_wdef, NULL)) < 0)
+            goto done;
+        if (ret == 0)
+            goto ok;
+    }
+    xn.xn_type = xml_type(x);
+    if (xml2binary_str(xa, xml_name(x), &xn.xn_name) < 0)
+        goto done;
+    if (xml2binary_str(xa, xml_prefix(x), &xn.xn_prefix) < 0)
+        goto done;
+    if (xml2binary_str(xa, xml_type(x)==CX_ELMNT?NULL:xml_value(x), &xn.xn_value) < 0)
+        goto done;
+    pos = cbuf_len(xa->xa_nodes);
+    if (cbuf_append_buf(xa->xa_nodes, &xn, sizeof(xn)) < 0){
+        clixon_err(OE_XML, errno, "cbuf_append_buf");
+        goto done;
+    }
+    xa->xa_nr++;
+    if (xml_type(x) != CX_ELMNT)
+        goto ok;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, -1)) != NULL) {
+        nr = xa->xa_nr;
+        if (xml2binary_recurse(xc, xa) < 0)
+            goto done;
+        if (xa->xa_nr > nr)
+            xn.xn_nchildren++;
+    }
+    /* Patch number of written children, buffer may have been reallocated */
+    memcpy(cbuf_get(xa->xa_nodes) + pos, &xn, sizeof(xn));
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Write an XML tree to a file in binary snapshot format
+ *
+ * Assume xn being in REPORT_ALL state, skip default values according to wdef
+ * @param[in]  f           Output file
+ * @param[in]  xn          XML tree, top object is included
+ * @param[in]  wdef        With-defaults parameter, tagged is not supported
+ * @param[in]  system_only Enable checks for system-only-config extension
+ * @retval     0           OK
+ * @retval    -1           Error
+ * @see clixon_xml_parse_binary_file  for reading
+ * @see clixon_xml2file1  XML text version
+ */
+int
+clixon_xml2binary_file(FILE             *f,
+                       cxobj            *xn,
+                       withdefaults_type wdef,
+                       int               system_only)
+{
+    int                   retval = -1;
+    struct xml_binary_hdr xh = {0,};
+    struct xml_binary_arg xa = {0,};
+
+    if ((xa.xa_strtab = cbuf_new()) == NULL ||
+        (xa.xa_nodes = cbuf_new()) == NULL){
+        clixon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if ((xa.xa_strhash = clicon_hash_init()) == NULL)
+        goto done;
+    xa.xa_wdef = wdef;
+    xa.xa_system_only = system_only;
+    if (xml2binary_recurse(xn, &xa) < 0)
+        goto done;
+    memcpy(xh.xb_magic, XML_BINARY_MAGIC, sizeof(xh.xb_magic));
+    xh.xb_version = XML_BINARY_VERSION;
+    xh.xb_strlen = cbuf_len(xa.xa_strtab);
+    xh.xb_nodes = xa.xa_nr;
+    if (fwrite(&xh, sizeof(xh), 1, f) != 1 ||
+        (xh.xb_strlen && fwrite(cbuf_get(xa.xa_strtab), xh.xb_strlen, 1, f) != 1) ||
+        (xh.xb_nodes && fwrite(cbuf_get(xa.xa_nodes), cbuf_len(xa.xa_nodes), 1, f) != 1)){
+        clixon_err(OE_XML, errno, "fwrite");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (xa.xa_strhash)
+        clicon_hash_free(xa.xa_strhash);
+    if (xa.xa_strtab)
+        cbuf_free(xa.xa_strtab);
+    if (xa.xa_nodes)
+        cbuf_free(xa.xa_nodes);
+    return retval;
+}
+
+/*! Get string from binary string table given offset
+ *
+ * @param[in]  xr    Binary read argument
+ * @param[in]  off   Offset in string table, or XML_BINARY_NONE
+ * @param[out] strp  String pointing into mapped file, or NULL
+ * @retval     0     OK
+ * @retval    -1     Error, offset out of range
+ */
+static int
+binary2xml_str(struct xml_binary_read *xr,
+               uint32_t                off,
+               char                  **strp)
+{
+    if (off == XML_BINARY_NONE)
+        *strp = NULL;
+    else if (off < xr->xr_strlen)
+        *strp = xr->xr_strtab + off;
+    else {
+        clixon_err(OE_XML, EFAULT, "Binary string offset %u out of range", off);
+        return -1;
+    }
+    return 0;
+}
+
+/*! Create XML node and its children from next binary node record
+ *
+ * @param[in]  xp    XML parent
+ * @param[in]  xr    Binary read argument, next record index is incremented
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+binary2xml_recurse(cxobj                  *xp,
+                   struct xml_binary_read *xr)
+{
+    int                    retval = -1;
+    struct xml_binary_node xn;
+    cxobj                 *x;
+    char                  *name;
+    char                  *prefix;
+    char                  *value;
+    uint32_t               i;
+
+    if (xr->xr_i >= xr->xr_nr){
+        clixon_err(OE_XML, EFAULT, "Binary node %u out of range", xr->xr_i);
+        goto done;
+    }
+    /* Records may be unaligned in the mapped file */
+    memcpy(&xn, xr->xr_nodes + xr->xr_i*sizeof(xn), sizeof(xn));
+    xr->xr_i++;
+    if (binary2xml_str(xr, xn.xn_name, &name) < 0 ||
+        binary2xml_str(xr, xn.xn_prefix, &prefix) < 0 ||
+        binary2xml_str(xr, xn.xn_value, &value) < 0)
+        goto done;
+    if (name == NULL ||
+        (xn.xn_type != CX_ELMNT && xn.xn_type != CX_ATTR && xn.xn_type != CX_BODY) ||
+        (xn.xn_type != CX_ELMNT && xn.xn_nchildren != 0) ||
+        xn.xn_nchildren > xr->xr_nr - xr->xr_i){
+        clixon_err(OE_XML, EFAULT, "Binary node %u malformed", xr->xr_i-1);
+        goto done;
+    }
+    if ((x = xml_new(name, xp, xn.xn_type)) == NULL)
+        goto done;
+    if (prefix && xml_prefix_set(x, prefix) < 0)
+        goto done;
+    if (value && xml_value_set(x, value) < 0)
+        goto done;
+    for (i=0; i<xn.xn_nchildren; i++)
+        if (binary2xml_recurse(x, xr) < 0)
+            goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Read an XML tree from a file in binary snapshot format
+ *
+ * The file is memory-mapped and nodes are created directly from the records,
+ * no text parsing is made. Yang binding is not made.
+ * @param[in]     fp    File descriptor to the binary file
+ * @param[in,out] xt    Pointer to XML parse tree. If empty, create.
+ * @retval        1     OK
+ * @retval        0     Not a binary snapshot (no magic), file position is unchanged
+ * @retval       -1     Error
+ * @code
+ *  cxobj *xt = NULL;
+ *  if ((ret = clixon_xml_parse_binary_file(fp, &xt)) < 0)
+ *    err;
+ *  if (ret == 0)
+ *    // parse as XML instead
+ *  xml_free(xt);
+ * @endcode
+ * @see clixon_xml2binary_file  for writing
+ * @note An empty file gives an empty top-level, as clixon_xml_parse_file
+ */
+int
+clixon_xml_parse_binary_file(FILE   *fp,
+                             cxobj **xt)
+{
+    int                    retval = -1;
+    struct stat            st;
+    struct xml_binary_hdr  xh;
+    struct xml_binary_read xr = {0,};
+    char                  *buf = MAP_FAILED;
+    int                    xtempty; /* empty on entry */
+
+    if (xt == NULL || fp == NULL){
+        clixon_err(OE_XML, EINVAL, "arg is NULL");
+        return -1;
+    }
+    xtempty = (*xt == NULL);
+    if (fstat(fileno(fp), &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat");
+        goto done;
+    }
+    if (st.st_size != 0){
+        if ((size_t)st.st_size < sizeof(xh))
+            goto fail;
+        if ((buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0)) == MAP_FAILED){
+            clixon_err(OE_UNIX, errno, "mmap");
+            goto done;
+        }
+        memcpy(&xh, buf, sizeof(xh));
+        if (memcmp(xh.xb_magic, XML_BINARY_MAGIC, sizeof(xh.xb_magic)) != 0)
+            goto fail;
+        if (xh.xb_version != XML_BINARY_VERSION){
+            clixon_err(OE_XML, EFAULT, "Binary version %u not supported (or other byte order)",
+                       xh.xb_version);
+            goto done;
+        }
+        if (sizeof(xh) + (uint64_t)xh.xb_strlen +
+            (uint64_t)xh.xb_nodes*sizeof(struct xml_binary_node) != (uint64_t)st.st_size ||
+            (xh.xb_strlen && buf[sizeof(xh) + xh.xb_strlen - 1] != '\0')){
+            clixon_err(OE_XML, EFAULT, "Binary file truncated or malformed");
+            goto done;
+        }
+        xr.xr_strtab = buf + sizeof(xh);
+        xr.xr_strlen = xh.xb_strlen;
+        xr.xr_nodes = xr.xr_strtab + xh.xb_strlen;
+        xr.xr_nr = xh.xb_nodes;
+    }
+    if (*xt == NULL)
+        if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    while (xr.xr_i < xr.xr_nr)
+        if (binary2xml_recurse(*xt, &xr) < 0)
+            goto done;
+    retval = 1;
+ done:
+    if (retval < 0 && *xt && xtempty){
+        xml_free(*xt);
+        *xt = NULL;
+    }
+    if (buf != MAP_FAILED)
+        munmap(buf, st.st_size);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Copy an attribute value(eg message-id) from one xml (eg rpc input) to another xml (eg rpc outgoing)
  *
  * @param[in]  xin   Get attr value from this XML
@@ -96,7 +96,8 @@ typedef struct  {
 /* Forward declaration */
 static int xml_diff1(cxobj *x0, cxobj *x1, cxobj ***x0vec, int *x0veclen,
                      cxobj ***x1vec, int *x1veclen,
-                     cxobj ***changed_x0, cxobj ***changed_x1, int *changedlen);
+                     cxobj ***changed_x0, cxobj ***changed_x1, int *changedlen,
+                     uint16_t flag);
 
 /*! Is attribute and is either of form xmlns="", or xmlns:x="" */
 int
@@ -331,6 +332,7 @@ xml_diff_ordered_by_user(cxobj     *x0,
  * @param[out] changed_x0 Pointervector to XML nodes changed orig value
  * @param[out] changed_x1 Pointervector to XML nodes changed wanted value
  * @param[out] changedlen Length of changed vector
+ * @param[in]  flag       If set, do not descend into equal nodes where neither has flag set
  * @retval     0          Ok
  * @retval    -1          Error
  * Algorithm to compare two sorted lists A, B:
@@ -362,7 +364,8 @@ xml_diff1(cxobj     *x0,
           int       *x1veclen,
           cxobj   ***changed_x0,
           cxobj   ***changed_x1,
-          int       *changedlen)
+          int       *changedlen,
+          uint16_t   flag)
 {
     int        retval = -1;
     cxobj     *x0c = NULL; /* x0 child */
@@ -482,6 +485,8 @@ xml_diff1(cxobj     *x0,
                 if (cxvec_append(x1c, x1vec, x1veclen) < 0)
                     goto done;
             }
+            else if (flag && xml_flag(x0c, flag) == 0 && xml_flag(x1c, flag) == 0)
+                ; /* Not marked: unchanged */
             else if (y0c && yang_keyword_get(y0c) == Y_LEAF){
                 /* if x0c and x1c are leafs w bodies, then they may be changed */
                 b0 = xml_body(x0c);
@@ -501,7 +506,7 @@ xml_diff1(cxobj     *x0,
             else if (xml_diff1(x0c, x1c,
                                x0vec, x0veclen,
                                x1vec, x1veclen,
-                               changed_x0, changed_x1, changedlen)< 0)
+                               changed_x0, changed_x1, changedlen, flag)< 0)
                 goto done;
         }
         x0c = xml_child_each(x0, x0c, CX_ELMNT);
@@ -529,6 +534,7 @@ xml_diff1(cxobj     *x0,
  * All xml vectors should be freed after use.
  * @see xml_tree_equal  same algorithm but do not bother with what has changed
  * @see clixon_xml_diff_print  same algorithm but print in +/- diff format
+ * @see xml_diff_flag  only descend into flagged nodes
  */
 int
 xml_diff(cxobj     *x0,
@@ -540,6 +546,40 @@ xml_diff(cxobj     *x0,
          cxobj   ***changed_x0,
          cxobj   ***changed_x1,
          int       *changedlen)
+{
+    return xml_diff_flag(x0, x1, first, firstlen, second, secondlen,
+                         changed_x0, changed_x1, changedlen, 0x0);
+}
+
+/*! Compute differences between two xml trees, only descend into flagged nodes
+ *
+ * Same as xml_diff but equal nodes where none of x0 or x1 has flag set are assumed
+ * to be unchanged. Siblings of flagged nodes are still compared.
+ * @param[in]  x0         First XML tree
+ * @param[in]  x1         Second XML tree
+ * @param[out] first      Pointervector to XML nodes existing in only first tree
+ * @param[out] firstlen   Length of first vector
+ * @param[out] second     Pointervector to XML nodes existing in only second tree
+ * @param[out] secondlen  Length of second vector
+ * @param[out] changed_x0 Pointervector to XML nodes changed orig value
+ * @param[out] changed_x1 Pointervector to XML nodes changed wanted value
+ * @param[out] changedlen Length of changed vector
+ * @param[in]  flag       Only descend into nodes with this flag, if 0 same as xml_diff
+ * @retval     0          OK
+ * @retval    -1          Error
+ * @see xmldb_diff_marked  XML_FLAG_DIFF marks changes in a datastore relative to running
+ */
+int
+xml_diff_flag(cxobj     *x0,
+              cxobj     *x1,
+              cxobj   ***first,
+              int       *firstlen,
+              cxobj   ***second,
+              int       *secondlen,
+              cxobj   ***changed_x0,
+              cxobj   ***changed_x1,
+              int       *changedlen,
+              uint16_t   flag)
 {
     int retval = -1;
 
@@ -561,7 +601,7 @@ xml_diff(cxobj     *x0,
     if (xml_diff1(x0, x1,
                   first, firstlen,
                   second, secondlen,
-                  changed_x0, changed_x1, changedlen) < 0)
+                  changed_x0, changed_x1, changedlen, flag) < 0)
         goto done;
  ok:
     retval = 0;
@@ -45,7 +45,9 @@
  */
 /*! XML parser yacc handler struct */
 struct clixon_xml_parse_yacc {
-    char       *xy_parse_string; /* original (copy of) parse string */
+    char       *xy_parse_string; /* original (copy of) parse string, ends with two NULLs */
+    size_t      xy_parse_len;    /* Length of parse string (excluding NULLs) */
+    FILE       *xy_parse_file;   /* Or parse from file if set */
     int         xy_linenum;      /* Number of \n in parsed buffer */
     void       *xy_lexbuf;       /* internal parse buffer from lex */
     cxobj      *xy_xtop;         /* cxobj top element (fixed) */
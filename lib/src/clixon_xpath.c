@@ -607,6 +607,156 @@ xpath_parse(const char  *xpath,
     return retval;
 }
 
+#ifdef XPATH_PARSE_CACHE
+/*! Entry in XPath parse cache
+ *
+ * Entries are kept in LRU order, most recently used first
+ */
+struct xpath_cache_entry{
+    qelem_t     xe_qelem;  /* LRU list */
+    char       *xe_xpath;  /* XPath string, key in hash */
+    xpath_tree *xe_xpt;    /* Parsed XPath tree */
+    int         xe_busy;   /* In use by ongoing evaluation, do not evict */
+};
+typedef struct xpath_cache_entry xpath_cache_entry;
+
+static clicon_hash_t     *_xpath_cache = NULL;
+static xpath_cache_entry *_xpath_cache_lru = NULL;
+static int                _xpath_cache_nr = 0;
+static uint64_t           _xpath_cache_hits = 0;
+static uint64_t           _xpath_cache_misses = 0;
+
+/*! Remove and free an entry from the XPath parse cache
+ */
+static int
+xpath_cache_entry_free(xpath_cache_entry *xe)
+{
+    DELQ(xe, _xpath_cache_lru, xpath_cache_entry *);
+    if (_xpath_cache)
+        clicon_hash_del(_xpath_cache, xe->xe_xpath);
+    if (xe->xe_xpt)
+        xpath_tree_free(xe->xe_xpt);
+    if (xe->xe_xpath)
+        free(xe->xe_xpath);
+    free(xe);
+    _xpath_cache_nr--;
+    return 0;
+}
+
+/*! Get parsed XPath tree from cache, parse and add to cache if not found
+ *
+ * The entry is marked busy and must be released with xpath_cache_release
+ * @param[in]  xpath  String with XPath 1.0 syntax
+ * @param[out] xep    Cache entry, the parsed tree is in xe_xpt
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xpath_cache_get(const char         *xpath,
+                xpath_cache_entry **xep)
+{
+    int                retval = -1;
+    xpath_cache_entry *xe = NULL;
+    xpath_cache_entry *xl;
+    void              *p;
+
+    if (_xpath_cache == NULL &&
+        (_xpath_cache = clicon_hash_init()) == NULL)
+        goto done;
+    if ((p = clicon_hash_value(_xpath_cache, xpath, NULL)) != NULL){
+        xe = *(xpath_cache_entry **)p;
+        _xpath_cache_hits++;
+        if (xe != _xpath_cache_lru){ /* Move first */
+            DELQ(xe, _xpath_cache_lru, xpath_cache_entry *);
+            INSQ(xe, _xpath_cache_lru);
+        }
+    }
+    else {
+        _xpath_cache_misses++;
+        /* Evict least recently used entry not in use */
+        if (_xpath_cache_nr >= XPATH_PARSE_CACHE &&
+            (xl = PREVQ(xpath_cache_entry *, _xpath_cache_lru)) != NULL){
+            while (xl->xe_busy && xl != _xpath_cache_lru)
+                xl = PREVQ(xpath_cache_entry *, xl);
+            if (xl->xe_busy == 0)
+                xpath_cache_entry_free(xl);
+        }
+        if ((xe = malloc(sizeof(*xe))) == NULL){
+            clixon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        memset(xe, 0, sizeof(*xe));
+        if (xpath_parse(xpath, &xe->xe_xpt) < 0){
+            free(xe);
+            goto done;
+        }
+        if ((xe->xe_xpath = strdup(xpath)) == NULL){
+            clixon_err(OE_UNIX, errno, "strdup");
+            xpath_tree_free(xe->xe_xpt);
+            free(xe);
+            goto done;
+        }
+        if (clicon_hash_add(_xpath_cache, xpath, &xe, sizeof(xe)) == NULL){
+            free(xe->xe_xpath);
+            xpath_tree_free(xe->xe_xpt);
+            free(xe);
+            goto done;
+        }
+        INSQ(xe, _xpath_cache_lru);
+        _xpath_cache_nr++;
+    }
+    xe->xe_busy++;
+    *xep = xe;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Release XPath parse cache entry after evaluation
+ */
+static void
+xpath_cache_release(xpath_cache_entry *xe)
+{
+    xe->xe_busy--;
+}
+#endif /* XPATH_PARSE_CACHE */
+
+/*! Return XPath parse cache statistics
+ *
+ * @param[out] hits    Number of XPaths found in cache
+ * @param[out] misses  Number of XPaths parsed and added to cache
+ * @retval     0       OK
+ * @see XPATH_PARSE_CACHE
+ */
+int
+xpath_parse_cache_stats(uint64_t *hits,
+                        uint64_t *misses)
+{
+#ifdef XPATH_PARSE_CACHE
+    *hits = _xpath_cache_hits;
+    *misses = _xpath_cache_misses;
+#else
+    *hits = 0;
+    *misses = 0;
+#endif
+    return 0;
+}
+
+/*! Free XPath parse cache
+ */
+void
+xpath_parse_cache_exit(void)
+{
+#ifdef XPATH_PARSE_CACHE
+    while (_xpath_cache_lru)
+        xpath_cache_entry_free(_xpath_cache_lru);
+    if (_xpath_cache){
+        clicon_hash_free(_xpath_cache);
+        _xpath_cache = NULL;
+    }
+#endif
+}
+
 /*! Given XML tree and XPath, parse XPath, eval it and return XPath context,
  *
  * This is a raw form of XPath where you can do type conversion of the return
@@ -633,13 +783,26 @@ xpath_vec_ctx(cxobj      *xcur,
               int         localonly,
               xp_ctx    **xrp)
 {
-    int         retval = -1;
-    xpath_tree *xptree = NULL;
-    xp_ctx      xc = {0,};
+    int                retval = -1;
+    xpath_tree        *xptree = NULL;
+    xp_ctx             xc = {0,};
+#ifdef XPATH_PARSE_CACHE
+    xpath_cache_entry *xe = NULL;
+#endif
 
     clixon_debug(CLIXON_DBG_XPATH | CLIXON_DBG_DETAIL, "%s", xpath);
+#ifdef XPATH_PARSE_CACHE
+    if (xpath == NULL){
+        clixon_err(OE_XML, EINVAL, "XPath is NULL");
+        goto done;
+    }
+    if (xpath_cache_get(xpath, &xe) < 0)
+        goto done;
+    xptree = xe->xe_xpt;
+#else
     if (xpath_parse(xpath, &xptree) < 0)
         goto done;
+#endif
     xc.xc_type = XT_NODESET;
     xc.xc_node = xcur;
     xc.xc_initial = xcur;
@@ -653,8 +816,13 @@ xpath_vec_ctx(cxobj      *xcur,
         free(xc.xc_nodeset);
         xc.xc_nodeset = NULL;
     }
+#ifdef XPATH_PARSE_CACHE
+    if (xe)
+        xpath_cache_release(xe);
+#else
     if (xptree)
         xpath_tree_free(xptree);
+#endif
     return retval;
 }
 
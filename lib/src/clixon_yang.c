@@ -253,6 +253,7 @@ yang_argument_set(yang_stmt *ys,
                   char      *arg)
 {
     ys->ys_argument = arg; /* not strdup/copied */
+    yang_index_reset(ys->ys_parent);
     return 0;
 }
 
@@ -274,6 +275,7 @@ yang_argument_dup(yang_stmt *ys,
         return -1;
     }
     ys->ys_argument = dup; /* not strdup/copied */
+    yang_index_reset(ys->ys_parent);
     return 0;
 }
 
@@ -1068,6 +1070,7 @@ ys_free1(yang_stmt *ys,
     }
     if (ys->ys_stmt)
         free(ys->ys_stmt);
+    yang_index_reset(ys);
     switch (ys->ys_keyword) {     /* type-specifi union fields */
     case Y_ACTION:
         while((rc = ys->ys_action_cb) != NULL) {
@@ -1140,6 +1143,7 @@ ys_prune(yang_stmt *yp,
     }
     yp->ys_len--;
     yp->ys_stmt[yp->ys_len] = NULL;
+    yang_index_reset(yp);
  done:
     return yc;
 }
@@ -1197,6 +1201,7 @@ ys_freechildren(yang_stmt *ys)
         free(ys->ys_stmt);
         ys->ys_stmt = NULL;
     }
+    yang_index_reset(ys);
     return 0;
 }
 
@@ -1232,6 +1237,7 @@ yn_realloc(yang_stmt *yn)
         return -1;
     }
     yn->ys_stmt[yn->ys_len - 1] = NULL; /* init field */
+    yang_index_reset(yn);
 #ifdef OPTIMIZE_YSPEC_NAMESPACE
     if (yn->ys_keyword == Y_SPEC && yn->ys_nscache){         /* Clear cache */
         yspec_nscache_clear(yn);
@@ -1322,6 +1328,9 @@ ys_cp_one(yang_stmt *ynew,
     memcpy(ynew, yold, sz);
     yang_flag_reset(ynew, YANG_FLAG_WHEN); /* Dont inherit WHENs */
     ynew->ys_parent = NULL;
+#ifdef YANG_FIND_INDEX
+    ynew->ys_index = NULL;
+#endif
     if (yold->ys_stmt)
         if ((ynew->ys_stmt = calloc(yold->ys_len, sizeof(yang_stmt *))) == NULL){
             clixon_err(OE_YANG, errno, "calloc");
@@ -1540,12 +1549,177 @@ yn_iter(yang_stmt *yparent,
     return yc;
 }
 
+#ifdef YANG_FIND_INDEX
+/*! Lazy hash index of the children of a yang statement
+ *
+ * Built by yang_find when a statement has more than YANG_FIND_INDEX children, and
+ * reset when children are added, removed or replaced.
+ */
+struct yang_index {
+    clicon_hash_t *yi_hash;     /* Argument -> vector of children with that argument */
+    uint32_t       yi_len;      /* Number of children when index was built */
+    yang_stmt    **yi_include;  /* Vector of include statements, in order */
+    int            yi_nrinclude;
+    int            yi_choice;   /* Has choice, input or output children */
+};
+
+#endif /* YANG_FIND_INDEX */
+
+/*! Free and reset child index of yang statement
+ *
+ * Must be called when children of ys are added, removed or replaced, or when the
+ * keyword or argument of a child is changed.
+ * @param[in]  ys   Yang statement
+ * @retval     0    OK
+ * @see YANG_FIND_INDEX
+ */
+int
+yang_index_reset(yang_stmt *ys)
+{
+#ifdef YANG_FIND_INDEX
+    struct yang_index *yi;
+
+    if (ys != NULL && (yi = ys->ys_index) != NULL){
+        ys->ys_index = NULL;
+        if (yi->yi_hash)
+            clicon_hash_free(yi->yi_hash);
+        if (yi->yi_include)
+            free(yi->yi_include);
+        free(yi);
+    }
+#endif
+    return 0;
+}
+
+#ifdef YANG_FIND_INDEX
+/*! Get child index of yang statement, build it if it does not exist
+ *
+ * @param[in]  yn   Yang statement
+ * @retval     yi   Child index
+ * @retval     NULL Statement has too few children or error, use linear search
+ */
+static struct yang_index *
+yang_index_get(yang_stmt *yn)
+{
+    struct yang_index *yi;
+    yang_stmt        **vec;
+    yang_stmt        **vec0;
+    yang_stmt         *ys;
+    size_t             vlen;
+    char              *arg;
+    enum rfc_6020      keyw;
+    int                i;
+
+    if ((yi = yn->ys_index) != NULL){
+        if (yi->yi_len == yn->ys_len)
+            return yi;
+        yang_index_reset(yn);
+    }
+    if (yn->ys_len <= YANG_FIND_INDEX)
+        return NULL;
+    if ((yi = calloc(1, sizeof(*yi))) == NULL){
+        clixon_err(OE_YANG, errno, "calloc");
+        return NULL;
+    }
+    yn->ys_index = yi;
+    yi->yi_len = yn->ys_len;
+    if ((yi->yi_hash = clicon_hash_init()) == NULL)
+        goto err;
+    for (i=0; i<yn->ys_len; i++){
+        if ((ys = yn->ys_stmt[i]) == NULL)
+            continue;
+        keyw = ys->ys_keyword;
+        if (keyw == Y_CHOICE || keyw == Y_INPUT || keyw == Y_OUTPUT)
+            yi->yi_choice++;
+        if (keyw == Y_INCLUDE){
+            if ((yi->yi_include = realloc(yi->yi_include,
+                                          (yi->yi_nrinclude+1)*sizeof(yang_stmt *))) == NULL){
+                clixon_err(OE_YANG, errno, "realloc");
+                goto err;
+            }
+            yi->yi_include[yi->yi_nrinclude++] = ys;
+        }
+        if ((arg = ys->ys_argument) == NULL)
+            continue;
+        /* Append to vector of children with same argument, keeping order */
+        vlen = 0;
+        vec0 = clicon_hash_value(yi->yi_hash, arg, &vlen);
+        if ((vec = malloc(vlen + sizeof(ys))) == NULL){
+            clixon_err(OE_YANG, errno, "malloc");
+            goto err;
+        }
+        if (vec0)
+            memcpy(vec, vec0, vlen);
+        vec[vlen/sizeof(ys)] = ys;
+        if (clicon_hash_add(yi->yi_hash, arg, vec, vlen + sizeof(ys)) == NULL){
+            free(vec);
+            goto err;
+        }
+        free(vec);
+    }
+    return yi;
+ err:
+    yang_index_reset(yn);
+    return NULL;
+}
+
+/*! Find first data node child with argument using child index
+ *
+ * @param[in]  yi       Child index
+ * @param[in]  argument Argument, not NULL
+ * @param[in]  schema   0: match data nodes, 1: match schema nodes
+ * @retval     ys       Matching child
+ * @retval     NULL     No match
+ */
+static yang_stmt *
+yang_index_find_node(struct yang_index *yi,
+                     const char        *argument,
+                     int                schema)
+{
+    yang_stmt **vec;
+    size_t      vlen = 0;
+    int         i;
+
+    if ((vec = clicon_hash_value(yi->yi_hash, argument, &vlen)) == NULL)
+        return NULL;
+    for (i=0; i<vlen/sizeof(yang_stmt *); i++)
+        if (schema ? yang_schemanode(vec[i]) : yang_datanode(vec[i]))
+            return vec[i];
+    return NULL;
+}
+
+/*! Find first child with keyword and argument using child index
+ *
+ * @param[in]  yi       Child index
+ * @param[in]  keyword  If 0 match any keyword
+ * @param[in]  argument Argument, not NULL
+ * @retval     ys       Matching child
+ * @retval     NULL     No match
+ */
+static yang_stmt *
+yang_index_find(struct yang_index *yi,
+                int                keyword,
+                const char        *argument)
+{
+    yang_stmt **vec;
+    size_t      vlen = 0;
+    int         i;
+
+    if ((vec = clicon_hash_value(yi->yi_hash, argument, &vlen)) == NULL)
+        return NULL;
+    for (i=0; i<vlen/sizeof(yang_stmt *); i++)
+        if (keyword == 0 || vec[i]->ys_keyword == keyword)
+            return vec[i];
+    return NULL;
+}
+#endif /* YANG_FIND_INDEX */
+
 /*! Find first child yang_stmt with matching keyword and argument
  *
  * Find child given keyword and argument.
  * Special case: look in imported INPUTs as well (for (sub)modules.
- * This could need an optimized lookup, especially the INPUT case.
  * Most common use for the special case, ie in openconfig, is grouping and identity
+ * If the node has many children, a hash index is used, see YANG_FIND_INDEX
  * @param[in]  yn         Yang node, current context node.
  * @param[in]  keyword    if 0 match any keyword. Actual type: enum rfc_6020
  * @param[in]  argument   String compare w argument. if NULL, match any.
@@ -1565,12 +1739,33 @@ yang_find(yang_stmt  *yn,
     yang_stmt *yspec;
     yang_stmt *ym;
     yang_stmt *yorig;
+#ifdef YANG_FIND_INDEX
+    struct yang_index *yi;
+#endif
 
     if (_yang_use_orig &&
         (yorig = yang_orig_get(yn)) != NULL &&
         uses_orig_ptr(keyword)){
         return yang_find(yorig, keyword, argument);
     }
+#ifdef YANG_FIND_INDEX
+    if (argument != NULL && (yi = yang_index_get(yn)) != NULL){
+        if ((yret = yang_index_find(yi, keyword, argument)) != NULL)
+            return yret;
+        if (keyword != Y_NAMESPACE &&
+            (yang_keyword_get(yn) == Y_MODULE ||
+             yang_keyword_get(yn) == Y_SUBMODULE)){
+            yspec = ys_spec(yn);
+            for (i=0; i<yi->yi_nrinclude; i++){
+                name = yang_argument_get(yi->yi_include[i]);
+                if ((ym = yang_find_module_by_name(yspec, name)) != NULL &&
+                    (yretsub = yang_find(ym, keyword, argument)) != NULL)
+                    break;
+            }
+        }
+        return yretsub;
+    }
+#endif
     for (i=0; i<yn->ys_len; i++){
         ys = yn->ys_stmt[i];
         if (keyword == 0 || ys->ys_keyword == keyword){
@@ -1620,7 +1815,28 @@ yang_find_datanode(yang_stmt *yn,
     char      *name;
     int        inext;
     int        inext2;
+#ifdef YANG_FIND_INDEX
+    struct yang_index *yi;
+    int        i;
 
+    /* Use index if there are no choice/input/output children to descend into */
+    if (argument != NULL &&
+        (yi = yang_index_get(yn)) != NULL &&
+        yi->yi_choice == 0){
+        if ((ysmatch = yang_index_find_node(yi, argument, 0)) == NULL &&
+            (yang_keyword_get(yn) == Y_MODULE ||
+             yang_keyword_get(yn) == Y_SUBMODULE)){
+            yspec = ys_spec(yn);
+            for (i=0; i<yi->yi_nrinclude; i++){
+                name = yang_argument_get(yi->yi_include[i]);
+                yc = yang_find_module_by_name(yspec, name);
+                if ((ysmatch = yang_find_datanode(yc, argument)) != NULL)
+                    break;
+            }
+        }
+        goto done;
+    }
+#endif
     inext = 0;
     while ((ys = yn_iter(yn, &inext)) != NULL){
         if (yang_keyword_get(ys) == Y_CHOICE){ /* Look for its children */
@@ -1690,7 +1906,27 @@ yang_find_schemanode(yang_stmt *yn,
     yang_stmt *ysmatch = NULL;
     char      *name;
     int        i, j;
-
+#ifdef YANG_FIND_INDEX
+    struct yang_index *yi;
+
+    /* Use index if there are no choice/input/output children to descend into */
+    if (argument != NULL &&
+        (yi = yang_index_get(yn)) != NULL &&
+        yi->yi_choice == 0){
+        if ((ysmatch = yang_index_find_node(yi, argument, 1)) == NULL &&
+            (yang_keyword_get(yn) == Y_MODULE ||
+             yang_keyword_get(yn) == Y_SUBMODULE)){
+            yspec = ys_spec(yn);
+            for (i=0; i<yi->yi_nrinclude; i++){
+                name = yang_argument_get(yi->yi_include[i]);
+                yc = yang_find_module_by_name(yspec, name);
+                if ((ysmatch = yang_find_schemanode(yc, argument)) != NULL)
+                    break;
+            }
+        }
+        goto match;
+    }
+#endif
     for (i=0; i<yn->ys_len; i++){
         ys = yn->ys_stmt[i];
         if (yang_keyword_get(ys) == Y_CHOICE){
@@ -3683,6 +3919,7 @@ yang_features(clixon_handle h,
                      */
                     if (yang_datanode(ys) && yang_config_ancestor(ys)){
                         ys->ys_keyword = Y_ANYDATA;
+                        yang_index_reset(yt);
                         ys_freechildren(ys);
                         ys->ys_len = 0;
                         yang_flag_set(ys, YANG_FLAG_DISABLED);
@@ -3692,6 +3929,7 @@ yang_features(clixon_handle h,
                         yt->ys_stmt[j-1] = yt->ys_stmt[j];
                     yt->ys_len--;
                     yt->ys_stmt[yt->ys_len] = NULL;
+                    yang_index_reset(yt);
                     ys_free(ys);
                     continue; /* Don't increment i */
                     break;
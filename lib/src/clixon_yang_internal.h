@@ -109,6 +109,9 @@ struct yang_stmt {
                                         Y_UNKNOWN: app-dep: yang-mount-points
                                      */
     yang_stmt         *ys_orig;      /* Pointer to original (for uses/augment copies) */
+#ifdef YANG_FIND_INDEX
+    struct yang_index *ys_index;     /* Lazy child index, see yang_find */
+#endif
     union {                          /* Depends on ys_keyword */
         rpc_callback_t  *ysu_action_cb; /* Y_ACTION: Action callback list*/
         char            *ysu_filename;  /* Y_MODULE/Y_SUBMODULE: For debug/errors: filename */
@@ -70,6 +70,8 @@
 #include <sys/param.h>
 #include <netinet/in.h>
 #include <libgen.h>
+#include <inttypes.h>
+#include <sys/mman.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -102,9 +104,58 @@
 #include "clixon_yang_sub_parse.h"
 #include "clixon_yang_parse_lib.h"
 
+/* Generated in build.c, see clixon.h */
+extern const char CLIXON_VERSION[];
+
 /* Size of json read buffer when reading from file*/
 #define BUFLEN 1024
 
+/* YANG parse-tree cache format, see CLICON_YANG_CACHE_DIR */
+#define YANG_CACHE_MAGIC   "CLYC"
+#define YANG_CACHE_VERSION 1          /* Also detects other byte order */
+#define YANG_CACHE_NONE    0xffffffff /* No string or no cv */
+
+/*
+ * Types
+ */
+/* YANG cache file header */
+struct yang_cache_hdr{
+    char     yc_magic[4];  /* YANG_CACHE_MAGIC */
+    uint32_t yc_version;   /* YANG_CACHE_VERSION */
+    uint64_t yc_srclen;    /* Length of YANG source text */
+    uint64_t yc_srchash;   /* FNV-1a hash of YANG source text */
+    uint64_t yc_build;     /* Parser build, see yang_cache_build */
+    uint32_t yc_strlen;    /* Length of string table in bytes */
+    uint32_t yc_nodes;     /* Number of node records */
+};
+
+/* YANG cache node record, strings are offsets into string table */
+struct yang_cache_node{
+    uint32_t yn_keyword;   /* enum rfc_6020 */
+    uint32_t yn_argument;  /* or YANG_CACHE_NONE */
+    uint32_t yn_cvtype;    /* enum cv_type of ys_cv or YANG_CACHE_NONE */
+    uint32_t yn_cv;        /* ys_cv as string or YANG_CACHE_NONE */
+    uint32_t yn_linenum;
+    uint32_t yn_nchildren; /* Number of child records following */
+};
+
+/* YANG cache write argument */
+struct yang_cache_arg{
+    cbuf          *ya_strtab;  /* String table */
+    cbuf          *ya_nodes;   /* Node records */
+    clicon_hash_t *ya_strhash; /* String -> offset in string table */
+    uint32_t       ya_nr;      /* Number of node records */
+};
+
+/* YANG cache read argument, pointers into mapped file */
+struct yang_cache_read{
+    char     *yr_strtab;
+    uint32_t  yr_strlen;
+    char     *yr_nodes;
+    uint32_t  yr_nr;       /* Number of node records */
+    uint32_t  yr_i;        /* Next node record */
+};
+
 /* Forward */
 static int yang_expand_grouping(clixon_handle h, yang_stmt *yn);
 
@@ -769,6 +820,7 @@ yang_expand_uses_node(clixon_handle h,
         yang_flag_set(yg, YANG_FLAG_GROUPING);
         k++;
     }
+    yang_index_reset(yn);
     /* Remove the grouping copy */
     ygrouping2->ys_len = 0; /* Cant do with get access function */
     ys_free(ygrouping2);
@@ -1144,6 +1196,487 @@ done:
     goto done;
 }
 
+/*------------------------------------------------------------------------
+ * YANG parse-tree cache, see CLICON_YANG_CACHE_DIR
+ * One cache file per YANG file, in host byte order:
+ *   header   struct yang_cache_hdr
+ *   strings  yc_strlen bytes of unique null-terminated strings
+ *   nodes    yc_nodes records of struct yang_cache_node in pre-order
+ * The cache is valid if length and hash of the YANG source text and the parser build are equal.
+ * Only processes with write access to the cache directory write cache files.
+ *------------------------------------------------------------------------*/
+
+/*! Compute 64-bit FNV-1a hash of YANG source text
+ */
+static uint64_t
+yang_cache_hash(const char *buf,
+                size_t      len)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    size_t   i;
+
+    for (i=0; i<len; i++){
+        h ^= (uint8_t)buf[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/*! Identify the parser build that produced a cache file
+ *
+ * The parse tree depends only on the YANG source text and on the parser, no options are
+ * used when parsing. Keywords and cv types are stored as enum values, which may differ
+ * between versions.
+ */
+static uint64_t
+yang_cache_build(void)
+{
+    return yang_cache_hash(CLIXON_VERSION, strlen(CLIXON_VERSION)) ^ Y_SPEC;
+}
+
+/*! Get cache filename of a YANG file
+ *
+ * @param[in]  dir      Cache directory
+ * @param[in]  filename YANG filename
+ * @param[out] cb       Cache filename: <dir>/<basename>-<path hash>.cache
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+yang_cache_filename(const char *dir,
+                    const char *filename,
+                    cbuf       *cb)
+{
+    int   retval = -1;
+    char *dup = NULL;
+
+    if ((dup = strdup(filename)) == NULL){
+        clixon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    cprintf(cb, "%s/%s-%016" PRIx64 ".cache", dir, basename(dup),
+            yang_cache_hash(filename, strlen(filename)));
+    retval = 0;
+ done:
+    if (dup)
+        free(dup);
+    return retval;
+}
+
+/*! Get offset of string in cache string table, add it if not present
+ *
+ * @param[in]  ya    Cache write argument
+ * @param[in]  str   String, or NULL
+ * @param[out] offp  Offset in string table, or YANG_CACHE_NONE if str is NULL
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+yang2cache_str(struct yang_cache_arg *ya,
+               char                  *str,
+               uint32_t              *offp)
+{
+    int       retval = -1;
+    uint32_t *valp;
+    uint32_t  off;
+
+    if (str == NULL){
+        *offp = YANG_CACHE_NONE;
+        goto ok;
+    }
+    if ((valp = clicon_hash_value(ya->ya_strhash, str, NULL)) != NULL){
+        *offp = *valp;
+        goto ok;
+    }
+    off = cbuf_len(ya->ya_strtab);
+    if (cbuf_append_buf(ya->ya_strtab, str, strlen(str)+1) < 0){
+        clixon_err(OE_YANG, errno, "cbuf_append_buf");
+        goto done;
+    }
+    if (clicon_hash_add(ya->ya_strhash, str, &off, sizeof(off)) == NULL)
+        goto done;
+    *offp = off;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Add yang statement and its children as cache node records
+ *
+ * @param[in]  ys    Yang statement
+ * @param[in]  ya    Cache write argument
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+yang2cache_recurse(yang_stmt             *ys,
+                   struct yang_cache_arg *ya)
+{
+    int                    retval = -1;
+    struct yang_cache_node yn = {0,};
+    cg_var                *cv;
+    char                  *str = NULL;
+    yang_stmt             *yc;
+    int                    inext;
+
+    yn.yn_keyword = yang_keyword_get(ys);
+    yn.yn_linenum = yang_linenum_get(ys);
+    yn.yn_nchildren = yang_len_get(ys);
+    yn.yn_cvtype = YANG_CACHE_NONE;
+    if (yang2cache_str(ya, yang_argument_get(ys), &yn.yn_argument) < 0)
+        goto done;
+    if ((cv = yang_cv_get(ys)) != NULL){
+        if ((str = cv2str_dup(cv)) == NULL){
+            clixon_err(OE_YANG, errno, "cv2str_dup");
+            goto done;
+        }
+        yn.yn_cvtype = cv_type_get(cv);
+    }
+    if (yang2cache_str(ya, str, &yn.yn_cv) < 0)
+        goto done;
+    if (cbuf_append_buf(ya->ya_nodes, &yn, sizeof(yn)) < 0){
+        clixon_err(OE_YANG, errno, "cbuf_append_buf");
+        goto done;
+    }
+    ya->ya_nr++;
+    inext = 0;
+    while ((yc = yn_iter(ys, &inext)) != NULL)
+        if (yang2cache_recurse(yc, ya) < 0)
+            goto done;
+    retval = 0;
+ done:
+    if (str)
+        free(str);
+    return retval;
+}
+
+/*! Write parse-tree of a YANG file to cache
+ *
+ * Written to a temporary file which is then renamed, so that concurrent
+ * processes never read a partial cache file.
+ * @param[in]  dir      Cache directory
+ * @param[in]  filename YANG filename
+ * @param[in]  buf      YANG source text
+ * @param[in]  len      Length of YANG source text
+ * @param[in]  ymod     Parsed (sub)module
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see yang_cache_read
+ */
+static int
+yang_cache_write(const char *dir,
+                 const char *filename,
+                 const char *buf,
+                 size_t      len,
+                 yang_stmt  *ymod)
+{
+    int                   retval = -1;
+    struct yang_cache_hdr yh = {0,};
+    struct yang_cache_arg ya = {0,};
+    cbuf                 *cbf = NULL;
+    cbuf                 *cbt = NULL;
+    int                   fd = -1;
+    FILE                 *f = NULL;
+
+    if ((ya.ya_strtab = cbuf_new()) == NULL ||
+        (ya.ya_nodes = cbuf_new()) == NULL ||
+        (cbf = cbuf_new()) == NULL ||
+        (cbt = cbuf_new()) == NULL){
+        clixon_err(OE_YANG, errno, "cbuf_new");
+        goto done;
+    }
+    if ((ya.ya_strhash = clicon_hash_init()) == NULL)
+        goto done;
+    if (yang2cache_recurse(ymod, &ya) < 0)
+        goto done;
+    memcpy(yh.yc_magic, YANG_CACHE_MAGIC, sizeof(yh.yc_magic));
+    yh.yc_version = YANG_CACHE_VERSION;
+    yh.yc_srclen = len;
+    yh.yc_srchash = yang_cache_hash(buf, len);
+    yh.yc_build = yang_cache_build();
+    yh.yc_strlen = cbuf_len(ya.ya_strtab);
+    yh.yc_nodes = ya.ya_nr;
+    if (yang_cache_filename(dir, filename, cbf) < 0)
+        goto done;
+    cprintf(cbt, "%s.XXXXXX", cbuf_get(cbf));
+    if ((fd = mkstemp(cbuf_get(cbt))) < 0){
+        clixon_err(OE_UNIX, errno, "mkstemp(%s)", cbuf_get(cbt));
+        goto done;
+    }
+    /* mkstemp creates 0600, the cache is shared between backend and clients */
+    if (fchmod(fd, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH) < 0){
+        clixon_err(OE_UNIX, errno, "fchmod");
+        close(fd);
+        unlink(cbuf_get(cbt));
+        goto done;
+    }
+    if ((f = fdopen(fd, "w")) == NULL){
+        clixon_err(OE_UNIX, errno, "fdopen");
+        close(fd);
+        unlink(cbuf_get(cbt));
+        goto done;
+    }
+    if (fwrite(&yh, sizeof(yh), 1, f) != 1 ||
+        (yh.yc_strlen && fwrite(cbuf_get(ya.ya_strtab), yh.yc_strlen, 1, f) != 1) ||
+        (yh.yc_nodes && fwrite(cbuf_get(ya.ya_nodes), cbuf_len(ya.ya_nodes), 1, f) != 1) ||
+        fclose(f) != 0){
+        clixon_err(OE_UNIX, errno, "fwrite");
+        f = NULL;
+        unlink(cbuf_get(cbt));
+        goto done;
+    }
+    f = NULL;
+    if (rename(cbuf_get(cbt), cbuf_get(cbf)) < 0){
+        clixon_err(OE_UNIX, errno, "rename(%s)", cbuf_get(cbf));
+        unlink(cbuf_get(cbt));
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (f)
+        fclose(f);
+    if (ya.ya_strhash)
+        clicon_hash_free(ya.ya_strhash);
+    if (ya.ya_strtab)
+        cbuf_free(ya.ya_strtab);
+    if (ya.ya_nodes)
+        cbuf_free(ya.ya_nodes);
+    if (cbf)
+        cbuf_free(cbf);
+    if (cbt)
+        cbuf_free(cbt);
+    return retval;
+}
+
+/*! Get string from cache string table given offset
+ *
+ * @param[in]  yr    Cache read argument
+ * @param[in]  off   Offset in string table, or YANG_CACHE_NONE
+ * @param[out] strp  String pointing into mapped file, or NULL
+ * @retval     0     OK
+ * @retval    -1     Error, offset out of range
+ */
+static int
+cache2yang_str(struct yang_cache_read *yr,
+               uint32_t                off,
+               char                  **strp)
+{
+    if (off == YANG_CACHE_NONE)
+        *strp = NULL;
+    else if (off < yr->yr_strlen)
+        *strp = yr->yr_strtab + off;
+    else {
+        clixon_err(OE_YANG, EFAULT, "YANG cache string offset %u out of range", off);
+        return -1;
+    }
+    return 0;
+}
+
+/*! Create yang statement and its children from next cache node record
+ *
+ * @param[in]  yp    Yang parent
+ * @param[in]  yr    Cache read argument, next record index is incremented
+ * @param[out] ysp   Created yang statement
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+cache2yang_recurse(yang_stmt              *yp,
+                   struct yang_cache_read *yr,
+                   yang_stmt             **ysp)
+{
+    int                    retval = -1;
+    struct yang_cache_node yn;
+    yang_stmt             *ys;
+    yang_stmt             *yc;
+    char                  *arg;
+    char                  *cvstr;
+    cg_var                *cv;
+    char                  *reason = NULL;
+    uint32_t               i;
+
+    if (yr->yr_i >= yr->yr_nr){
+        clixon_err(OE_YANG, EFAULT, "YANG cache node %u out of range", yr->yr_i);
+        goto done;
+    }
+    /* Records may be unaligned in the mapped file */
+    memcpy(&yn, yr->yr_nodes + yr->yr_i*sizeof(yn), sizeof(yn));
+    yr->yr_i++;
+    if (cache2yang_str(yr, yn.yn_argument, &arg) < 0 ||
+        cache2yang_str(yr, yn.yn_cv, &cvstr) < 0)
+        goto done;
+    if (yn.yn_nchildren > yr->yr_nr - yr->yr_i ||
+        (cvstr == NULL) != (yn.yn_cvtype == YANG_CACHE_NONE)){
+        clixon_err(OE_YANG, EFAULT, "YANG cache node %u malformed", yr->yr_i-1);
+        goto done;
+    }
+    if ((ys = ys_new(yn.yn_keyword)) == NULL)
+        goto done;
+    if (yn_insert(yp, ys) < 0){
+        ys_free(ys);
+        goto done;
+    }
+    if (arg && yang_argument_dup(ys, arg) < 0)
+        goto done;
+    yang_linenum_set(ys, yn.yn_linenum);
+    if (cvstr){
+        if ((cv = cv_new(yn.yn_cvtype)) == NULL){
+            clixon_err(OE_YANG, errno, "cv_new");
+            goto done;
+        }
+        yang_cv_set(ys, cv);
+        if (cv_parse1(cvstr, cv, &reason) != 1){
+            clixon_err(OE_YANG, EFAULT, "YANG cache cv: %s", reason?reason:cvstr);
+            goto done;
+        }
+    }
+    for (i=0; i<yn.yn_nchildren; i++)
+        if (cache2yang_recurse(ys, yr, &yc) < 0)
+            goto done;
+    *ysp = ys;
+    retval = 0;
+ done:
+    if (reason)
+        free(reason);
+    return retval;
+}
+
+/*! Read parse-tree of a YANG file from cache if it matches the YANG source text
+ *
+ * @param[in]  dir      Cache directory
+ * @param[in]  filename YANG filename
+ * @param[in]  buf      YANG source text
+ * @param[in]  len      Length of YANG source text
+ * @param[in]  yspec    Yang specification, (sub)module is added to it
+ * @param[out] ymodp    (Sub)module
+ * @retval     1        OK, read from cache
+ * @retval     0        No cache file, or cache is stale
+ * @retval    -1        Error
+ * @see yang_cache_write
+ */
+static int
+yang_cache_read(const char *dir,
+                const char *filename,
+                const char *buf,
+                size_t      len,
+                yang_stmt  *yspec,
+                yang_stmt **ymodp)
+{
+    int                    retval = -1;
+    cbuf                  *cbf = NULL;
+    int                    fd = -1;
+    struct stat            st = {0,};
+    struct yang_cache_hdr  yh;
+    struct yang_cache_read yr = {0,};
+    char                  *map = MAP_FAILED;
+    yang_stmt             *ymod = NULL;
+    int                    nr0;
+
+    if ((cbf = cbuf_new()) == NULL){
+        clixon_err(OE_YANG, errno, "cbuf_new");
+        goto done;
+    }
+    if (yang_cache_filename(dir, filename, cbf) < 0)
+        goto done;
+    if ((fd = open(cbuf_get(cbf), O_RDONLY)) < 0)
+        goto fail;
+    if (fstat(fd, &st) < 0){
+        clixon_err(OE_UNIX, errno, "fstat");
+        goto done;
+    }
+    if ((size_t)st.st_size < sizeof(yh))
+        goto fail;
+    /* Cache files are replaced by rename, never modified in place, see yang_cache_write */
+    if ((map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED){
+        clixon_err(OE_UNIX, errno, "mmap");
+        goto done;
+    }
+    memcpy(&yh, map, sizeof(yh));
+    if (memcmp(yh.yc_magic, YANG_CACHE_MAGIC, sizeof(yh.yc_magic)) != 0 ||
+        yh.yc_version != YANG_CACHE_VERSION ||
+        yh.yc_srclen != len ||
+        yh.yc_srchash != yang_cache_hash(buf, len) ||
+        yh.yc_build != yang_cache_build() ||
+        yh.yc_nodes == 0 ||
+        sizeof(yh) + (uint64_t)yh.yc_strlen +
+        (uint64_t)yh.yc_nodes*sizeof(struct yang_cache_node) != (uint64_t)st.st_size ||
+        (yh.yc_strlen && map[sizeof(yh) + yh.yc_strlen - 1] != '\0'))
+        goto fail;
+    yr.yr_strtab = map + sizeof(yh);
+    yr.yr_strlen = yh.yc_strlen;
+    yr.yr_nodes = yr.yr_strtab + yh.yc_strlen;
+    yr.yr_nr = yh.yc_nodes;
+    nr0 = yang_len_get(yspec);
+    if (cache2yang_recurse(yspec, &yr, &ymod) < 0){
+        /* Remove partially created (sub)module */
+        if (yang_len_get(yspec) > nr0 &&
+            (ymod = ys_prune(yspec, nr0)) != NULL)
+            ys_free(ymod);
+        goto done;
+    }
+    if (yang_filename_set(ymod, filename) < 0)
+        goto done;
+#ifdef OPTIMIZE_YSPEC_NAMESPACE
+    yspec_nscache_clear(yspec);
+#endif
+    *ymodp = ymod;
+    retval = 1;
+ done:
+    if (map != MAP_FAILED)
+        munmap(map, st.st_size);
+    if (fd != -1)
+        close(fd);
+    if (cbf)
+        cbuf_free(cbf);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Log parse tree of a YANG (sub)module, one statement per line
+ *
+ * Logs keyword, argument, line number and cv, eg the argument of an extension, of each
+ * statement before grouping and augment expansion. Used to compare a tree loaded from
+ * the YANG cache with a parsed tree.
+ * @param[in]  ys      Yang statement
+ * @param[in]  indent  Indentation, for recursion
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see CLICON_YANG_CACHE_DIR
+ */
+static int
+yang_parse_tree_debug(yang_stmt *ys,
+                      int        indent)
+{
+    int        retval = -1;
+    cg_var    *cv;
+    char      *str = NULL;
+    char      *arg;
+    yang_stmt *yc;
+    int        inext;
+
+    if ((cv = yang_cv_get(ys)) != NULL &&
+        (str = cv2str_dup(cv)) == NULL){
+        clixon_err(OE_YANG, errno, "cv2str_dup");
+        goto done;
+    }
+    arg = yang_argument_get(ys);
+    clixon_debug(CLIXON_DBG_YANG | CLIXON_DBG_DETAIL, "yang-tree: %*s%s %s line:%u cv:%s:%s",
+                 indent, "", yang_key2str(yang_keyword_get(ys)), arg?arg:"",
+                 yang_linenum_get(ys), cv?cv_type2str(cv_type_get(cv)):"", str?str:"");
+    inext = 0;
+    while ((yc = yn_iter(ys, &inext)) != NULL)
+        if (yang_parse_tree_debug(yc, indent + PRETTYPRINT_INDENT) < 0)
+            goto done;
+    retval = 0;
+ done:
+    if (str)
+        free(str);
+    return retval;
+}
+
 /*! Open a file, read into a string and invoke yang parsing
  *
  * Similar to clicon_yang_str(), just read a file first
@@ -1164,6 +1697,9 @@ yang_parse_filename(clixon_handle h,
     yang_stmt    *ymod = NULL;
     FILE         *fp = NULL;
     struct stat   st;
+    char         *buf = NULL;
+    char         *dir = NULL;
+    int           ret;
 
     clixon_debug(CLIXON_DBG_YANG, "%s", filename);
     if (stat(filename, &st) < 0){
@@ -1174,12 +1710,40 @@ yang_parse_filename(clixon_handle h,
         clixon_err(OE_YANG, errno, "fopen(%s)", filename);
         goto done;
     }
-    if ((ymod = yang_parse_file(fp, filename, yspec)) < 0)
+    if ((buf = malloc(st.st_size + 1)) == NULL){
+        clixon_err(OE_YANG, errno, "malloc");
+        goto done;
+    }
+    if (st.st_size && fread(buf, st.st_size, 1, fp) != 1){
+        clixon_err(OE_YANG, errno, "fread(%s)", filename);
+        goto done;
+    }
+    buf[st.st_size] = '\0';
+    if (h)
+        dir = clicon_option_str(h, "CLICON_YANG_CACHE_DIR");
+    ret = 0;
+    if (dir && (ret = yang_cache_read(dir, filename, buf, st.st_size, yspec, &ymod)) < 0)
+        goto done;
+    if (ret == 0){
+        if ((ymod = yang_parse_str(buf, filename, yspec)) == NULL)
+            goto done;
+        /* Only processes allowed to write the cache directory, typically the backend,
+         * write it. Failure to write cache is not fatal */
+        if (dir && access(dir, W_OK) == 0 &&
+            yang_cache_write(dir, filename, buf, st.st_size, ymod) < 0){
+            clixon_debug(CLIXON_DBG_YANG, "YANG cache not written: %s", clixon_err_reason());
+            clixon_err_reset();
+        }
+    }
+    if (ymod && clixon_debug_isset(CLIXON_DBG_YANG | CLIXON_DBG_DETAIL) &&
+        yang_parse_tree_debug(ymod, 0) < 0)
         goto done;
     /* YANG patch hook */
     if (ymod && h && clixon_plugin_yang_patch_all(h, ymod) < 0)
         goto done;
   done:
+    if (buf)
+        free(buf);
     if (fp)
         fclose(fp);
     return ymod; /* top-level (sub)module */
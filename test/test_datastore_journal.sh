@@ -0,0 +1,181 @@
+#!/usr/bin/env bash
+# Datastore journal test, see CLICON_XMLDB_JOURNAL
+# Edits are appended to <db>_db.journal instead of rewriting <db>_db, and the journal
+# is compacted into <db>_db after a number of records.
+# The journal is replayed when the datastore is read, also with an incomplete last record
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# include err() and new() functions and creates $dir
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+journal=$dir/startup_db.journal
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_JOURNAL>3</CLICON_XMLDB_JOURNAL>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module clixon-example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf value{
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+# Check number of records in journal
+# Args:
+# 1: expected number of records, 0 means no journal
+function check_journal()
+{
+    nr=$1
+
+    if [ $nr -eq 0 ]; then
+        new "Check no journal"
+        if sudo test -f $journal; then
+            err "no $journal" "$(sudo cat $journal)"
+        fi
+    else
+        new "Check journal has $nr records"
+        ret=$(sudo grep -c "^merge [0-9]*$" $journal)
+        if [ "$ret" != "$nr" ]; then
+            err "$nr" "$ret"
+        fi
+    fi
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo rm -f $dir/startup_db $journal
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Add a to startup"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><startup/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+check_journal 1
+
+new "Check a not in startup_db"
+if sudo grep -q "<name>a</name>" $dir/startup_db; then
+    err "no a" "$(sudo cat $dir/startup_db)"
+fi
+
+# Operation prefix is declared in rpc, outside of config
+new "Create b in startup"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS xmlns:nc=\"${BASENS}\"><edit-config><target><startup/></target><config><table xmlns=\"urn:example:clixon\"><parameter nc:operation=\"create\"><name>b</name><value>2</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+check_journal 2
+
+new "Delete a in startup, compacts journal"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS xmlns:nc=\"${BASENS}\"><edit-config><target><startup/></target><config><table xmlns=\"urn:example:clixon\"><parameter nc:operation=\"delete\"><name>a</name></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+check_journal 0
+
+new "Check b in startup_db"
+if ! sudo grep -q "<name>b</name>" $dir/startup_db; then
+    err "b" "$(sudo cat $dir/startup_db)"
+fi
+
+new "Add c to startup"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><startup/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>c</name><value>3</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+check_journal 1
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+fi
+
+new "Append incomplete record to journal"
+sudo sh -c "printf 'merge 100\n<config><table' >> $journal"
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend 2"
+wait_backend
+
+new "Check b and c in running"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>b</name><value>2</value></parameter><parameter><name>c</name><value>3</value></parameter></table></data></rpc-reply>"
+
+check_journal 1
+
+new "Check incomplete record removed"
+if sudo grep -q "merge 100" $journal; then
+    err "no incomplete record" "$(sudo cat $journal)"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+fi
+
+new "Append record not bound to yang and a valid record to journal"
+rec='<config><table xmlns="urn:example:clixon"><parameter><name>x</name><extra>1</extra></parameter></table></config>'
+sudo sh -c "printf 'merge %d\n%s\n' ${#rec} '$rec' >> $journal"
+rec='<config><table xmlns="urn:example:clixon"><parameter><name>d</name><value>4</value></parameter></table></config>'
+sudo sh -c "printf 'merge %d\n%s\n' ${#rec} '$rec' >> $journal"
+
+if [ $BE -ne 0 ]; then
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend 3"
+wait_backend
+
+new "Check record not bound skipped, b, c and d in running"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>b</name><value>2</value></parameter><parameter><name>c</name><value>3</value></parameter><parameter><name>d</name><value>4</value></parameter></table></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
@@ -286,6 +286,42 @@ testrun permit permit deny   permit true  true  false false
 testrun permit permit permit deny   true  true  true  false
 testrun permit permit permit permit true  true  true  true
 
+# Rule order between path and module rules: the first matching rule decides, also if
+# a module rule without path is placed before rules with paths, and a path may select
+# a single list entry
+new "add parameter b"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:nacm\"><parameters><parameter><name>b</name><value>73</value></parameter></parameters></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "add first rule: deny parameter b"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><nacm xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-acm\"><rule-list><name>limited-acl</name><rule xmlns:yang=\"urn:ietf:params:xml:ns:yang:1\" yang:insert=\"first\"><name>parameter-b</name><module-name>*</module-name><access-operations>read</access-operations><path xmlns:ex=\"urn:example:nacm\">/ex:table/ex:parameters/ex:parameter[ex:name='b']</path><action>deny</action></rule></rule-list></nacm></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit rules"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get parameters, b denied"
+expectpart "$(curl -u wilma:bar $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/nacm-example:table/parameters)" 0 "HTTP/$HVER 200" '{"nacm-example:parameters":{"parameter":\[{"name":"a","value":"72"}\]}}'
+
+new "add first rule: deny module"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><nacm xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-acm\"><rule-list><name>limited-acl</name><rule xmlns:yang=\"urn:ietf:params:xml:ns:yang:1\" yang:insert=\"first\"><name>module-first</name><module-name>nacm-example</module-name><access-operations>read</access-operations><action>deny</action></rule></rule-list></nacm></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "commit rules"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get table, module rule first denies"
+expectpart "$(curl -u wilma:bar $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/nacm-example:table?depth=1)" 0 "HTTP/$HVER 404" '{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"invalid-value","error-severity":"error","error-message":"Instance does not exist"}}}'
+
+new "get other, module rule first denies"
+expectpart "$(curl -u wilma:bar $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/nacm-example:other/value)" 0 "HTTP/$HVER 404" '{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"invalid-value","error-severity":"error","error-message":"Instance does not exist"}}}'
+
+new "get other module, permitted"
+expectpart "$(curl -u wilma:bar $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/nacm-example2:other2/value)" 0 "HTTP/$HVER 200" '{"nacm-example2:value":"88"}'
+
+new "set module rule first permit"
+expectpart "$(curl -u andy:bar $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/ietf-netconf-acm:nacm/rule-list=limited-acl/rule=module-first/action -d '{"ietf-netconf-acm:action":"permit"}' )" 0 "HTTP/$HVER 204"
+
+new "get parameters, module rule first permits b"
+expectpart "$(curl -u wilma:bar $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/nacm-example:table/parameters)" 0 "HTTP/$HVER 200" '{"nacm-example:parameters":{"parameter":\[{"name":"a","value":"72"},{"name":"b","value":"73"}\]}}'
+
 if [ $RC -ne 0 ]; then
     new "Kill restconf daemon"
     stop_restconf 
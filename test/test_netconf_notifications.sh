@@ -133,11 +133,106 @@ expectwait "$clixon_netconf -D $DBG -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTN
 new "netconf EXAMPLE subscription with wrong date"
 expectwait "$clixon_netconf -D $DBG -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream><startTime>kallekaka</startTime></create-subscription></rpc>" 0 "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>startTime</bad-element></error-info><error-severity>error</error-severity><error-message>regexp match fail:"
 
+# Subscriptions with the same filter share one compiled filter, see stream_filter_get
+# Args:
+# 1: Filter
+# 2: Seconds to keep subscription
+# 3: Output file
+function subscribe_filter()
+{
+    f=$1
+    t=$2
+    o=$3
+
+    rpc="<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream><filter type=\"xpath\" select=\"$f\"/></create-subscription></rpc>"
+    sleep $t | cat <(echo "$DEFAULTHELLO$(chunked_framing "$rpc")") - | $clixon_netconf -qef $cfg > $o 2> /dev/null
+}
+
+new "netconf EXAMPLE subscriptions with shared and distinct filters"
+subscribe_filter "event[event-class='fault']" $NCWAIT $dir/sub1.out &
+subscribe_filter "event[event-class='fault']" $NCWAIT $dir/sub2.out &
+subscribe_filter "event[event-class='fault']" 1 $dir/sub3.out &
+subscribe_filter "event[event-class='none']" $NCWAIT $dir/sub4.out &
+wait
+
+new "first subscription with shared filter"
+expectpart "$(cat $dir/sub1.out)" 0 "<rpc-reply $DEFAULTNS><ok/></rpc-reply>" "<notification xmlns=\"urn:ietf:params:xml:ns:netconf:notification:1.0\"><eventTime>20"
+
+new "second subscription with shared filter, after third is closed"
+expectpart "$(cat $dir/sub2.out)" 0 "<rpc-reply $DEFAULTNS><ok/></rpc-reply>" "<notification xmlns=\"urn:ietf:params:xml:ns:netconf:notification:1.0\"><eventTime>20"
+
+new "subscription with non-matching filter"
+expectpart "$(cat $dir/sub4.out)" 0 "<rpc-reply $DEFAULTNS><ok/></rpc-reply>" --not-- "<notification"
+
+new "netconf EXAMPLE subscription with invalid filter"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream><filter type=\"xpath\" select=\"event[\"/></create-subscription></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag>"
+
 #new "netconf EXAMPLE subscription with replay"
 #NOW=$(date +"%Y-%m-%dT%H:%M:%S")
 #sleep 10
 #expectwait "$clixon_netconf -D $DBG -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream><startTime>$NOW</startTime></create-subscription></rpc>" 10 "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><notification xmlns=\"urn:ietf:params:xml:ns:netconf:notification:1.0\"><eventTime>20"
 
+new "2. Replay buffer trimming"
+
+# Count replayed notifications of EXAMPLE stream from start until now
+# Args:
+# 1: config file
+function replay_count()
+{
+    c=$1
+
+    stop=$(date -u +"%Y-%m-%dT%H:%M:%SZ")
+    rpc="<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream><startTime>1970-01-01T00:00:00Z</startTime><stopTime>$stop</stopTime></create-subscription></rpc>"
+    sleep 2 | cat <(echo "$DEFAULTHELLO$(chunked_framing "$rpc")") - | $clixon_netconf -qef $c 2> /dev/null | grep -o "<notification xmlns" | wc -l
+}
+
+# Replay buffer limited by bytes: each example notification is about 280 bytes, 2 fit in 600
+cfgb=$dir/confb.xml
+sed -e "s#<CLICON_CONFIGFILE>$cfg<#<CLICON_CONFIGFILE>$cfgb<#" -e "s#<CLICON_STREAM_RETENTION>60</CLICON_STREAM_RETENTION>#<CLICON_STREAM_RETENTION>60</CLICON_STREAM_RETENTION><CLICON_STREAM_REPLAY_MAX_BYTES>600</CLICON_STREAM_REPLAY_MAX_BYTES>#" $cfg > $cfgb
+
+# Replay buffer limited by age
+cfga=$dir/confa.xml
+sed -e "s#<CLICON_CONFIGFILE>$cfg<#<CLICON_CONFIGFILE>$cfga<#" -e "s#<CLICON_STREAM_RETENTION>60<#<CLICON_STREAM_RETENTION>1<#" $cfg > $cfga
+
+# Replay counts depend on the backend started here
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+
+    new "start backend -s init -f $cfgb -- -n 1"
+    start_backend -s init -f $cfgb -- -n 1
+
+    new "wait backend"
+    wait_backend
+
+    sleep 6
+
+    new "replay limited by bytes: expect 2 of 5-6 events"
+    ret=$(replay_count $cfgb)
+    if [ "$ret" -ne 2 ]; then
+        err "2" "$ret"
+    fi
+
+    new "Kill backend"
+    stop_backend -f $cfgb
+
+    new "start backend -s init -f $cfga -- -n 1"
+    start_backend -s init -f $cfga -- -n 1
+
+    new "wait backend"
+    wait_backend
+
+    # Retention is checked every 5s, STREAM_TIMER_TIMEOUT_S
+    sleep 12
+
+    new "replay limited by age: expect 1-7 of 11-12 events"
+    ret=$(replay_count $cfga)
+    if [ "$ret" -lt 1 -o "$ret" -gt 7 ]; then
+        err "1-7" "$ret"
+    fi
+    cfg=$cfga
+fi
+
 if [ $BE -ne 0 ]; then
     new "Kill backend"
     # Check if premature kill
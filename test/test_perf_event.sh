@@ -0,0 +1,158 @@
+#!/usr/bin/env bash
+# Performance of the backend event loop with many idle client connections
+# Open a large number of idle connections to the backend socket and measure the time of a
+# number of concurrent active netconf sessions, compared to without idle connections.
+# With epoll, idle connections should not add to the cost of each event loop iteration.
+# See EVENT_EPOLL in clixon_custom.h
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of idle connections
+: ${perfidle:=5000}
+
+# Number of concurrent active netconf sessions
+: ${perfactive:=100}
+
+# time function (this is a mess to get right on freebsd/linux)
+: ${TIMEFN:=time -p} # portability: 2>&1 | awk '/real/ {print $2}'
+if ! $TIMEFN true; then err "A working time function" "'$TIMEFN' does not work"; fi
+
+# Idle connections are opened by python
+if [ -z "$(type python3 2> /dev/null)" ]; then
+    echo "...python3 not installed"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+# Both backend and the idle connection process need more file descriptors than default
+nofile=$((perfidle + 256))
+if ! ulimit -n $nofile 2> /dev/null; then
+    nofile=$(ulimit -Hn)
+    ulimit -n $nofile
+    perfidle=$((nofile - 256))
+fi
+
+APPNAME=example
+
+cfg=$dir/perf-event-conf.xml
+fyang=$dir/scaling.yang
+fidle=$dir/idle.py
+fready=$dir/idle.ready
+frpc=$dir/rpc.xml
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+# Open idle connections to the backend socket, write ready file and wait until killed
+cat <<EOF > $fidle
+import signal, socket, sys
+socks = []
+for i in range(int(sys.argv[2])):
+    s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    s.connect(sys.argv[1])
+    socks.append(s)
+open(sys.argv[3], "w").write(str(len(socks)))
+signal.pause()
+EOF
+
+echo -n "$DEFAULTHELLO" > $frpc
+echo "$(chunked_framing "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>")" >> $frpc
+
+# Run concurrent active netconf sessions and print time
+# Args:
+# 1: Description
+function active_sessions()
+{
+    descr=$1
+
+    t=$( { $TIMEFN bash -c "for i in \$(seq $perfactive); do $clixon_netconf -qef $cfg < $frpc > /dev/null & done; wait"; } 2>&1 | awk '/real/ {print $2}')
+    echo "$perfactive active sessions $descr: $t s"
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "netconf get-config"
+expecteof_file "$clixon_netconf -qef $cfg" 0 "$frpc" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "active sessions without idle connections"
+active_sessions "without idle connections"
+
+new "open $perfidle idle connections"
+rm -f $fready
+python3 $fidle /usr/local/var/run/$APPNAME.sock $perfidle $fready &
+idlepid=$!
+for i in $(seq 1 $((10*DEMLOOP))); do
+    if [ -f $fready ]; then
+        break
+    fi
+    sleep $DEMSLEEP
+done
+if [ ! -f $fready ]; then
+    kill $idlepid 2> /dev/null
+    err "$perfidle idle connections" "timeout"
+fi
+
+new "netconf get-config with idle connections"
+expecteof_file "$clixon_netconf -qef $cfg" 0 "$frpc" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "active sessions with idle connections"
+active_sessions "with $(cat $fready) idle connections"
+
+new "close idle connections"
+kill $idlepid
+wait $idlepid 2> /dev/null
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,140 @@
+#!/usr/bin/env bash
+# Performance of NETCONF framing: write a large edit-config using EOM and chunked framing
+# and print throughput in MB/s
+# Includes XML parsing and backend processing, ie end-to-end throughput
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in edit-config
+: ${perfnr:=100000}
+
+# time function (this is a mess to get right on freebsd/linux)
+: ${TIMEFN:=time -p} # portability: 2>&1 | awk '/real/ {print $2}'
+if ! $TIMEFN true; then err "A working time function" "'$TIMEFN' does not work"; fi
+
+APPNAME=example
+
+cfg=$dir/perf-framing-conf.xml
+fyang=$dir/scaling.yang
+fconfigonly=$dir/config.xml
+feom=$dir/eom.xml
+fchunked=$dir/chunked.xml
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+</clixon-config>
+EOF
+
+# Print throughput of writing a file to clixon_netconf
+# Args:
+# 1: file with hello and framed edit-config
+function framing_throughput()
+{
+    f=$1
+
+    size=$(wc -c < $f)
+    t=$( { $TIMEFN $clixon_netconf -qef $cfg < $f > /dev/null; } 2>&1 | awk '/real/ {print $2}')
+    echo "$size $t" | awk '{printf "%.1f MB in %s s: %.1f MB/s\n", $1/1000000, $2, ($2>0)?$1/1000000/$2:0}'
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "generate config with $perfnr list entries"
+echo -n "<x xmlns=\"urn:example:clixon\">" > $fconfigonly
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<y><a>$i</a><b>value]$i</b></y>" >> $fconfigonly
+done
+echo -n "</x>" >> $fconfigonly # No CR
+
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>"
+rpc+="$(cat $fconfigonly)"
+rpc+="</config></edit-config></rpc>"
+
+echo -n "$HELLONO11" > $feom
+echo -n "$rpc]]>]]>" >> $feom
+
+echo -n "$DEFAULTHELLO" > $fchunked
+echo "$(chunked_framing "$rpc")" >> $fchunked
+
+new "netconf write large config with EOM framing"
+expecteof_file "$clixon_netconf -qef $cfg" 0 "$feom" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf EOM framing throughput"
+framing_throughput $feom
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf write large config with chunked framing"
+expecteof_file "$clixon_netconf -qef $cfg" 0 "$fchunked" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf chunked framing throughput"
+framing_throughput $fchunked
+
+# The reply is larger than BACKEND_REPLY_CHUNK and is sent from the backend in chunks
+new "netconf get-config large reply"
+ret=$(echo -n "$HELLONO11<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" | $clixon_netconf -qef $cfg)
+expectpart "$ret" 0 "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>0</a>" "<y><a>$((perfnr-1))</a>" "</y></x></data></rpc-reply>"
+
+new "netconf get-config large reply has all $perfnr entries"
+nr=$(echo "$ret" | grep -o "<y>" | wc -l)
+if [ $nr -ne $perfnr ]; then
+    err "$perfnr" "$nr"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,196 @@
+#!/usr/bin/env bash
+# Performance test of hash tables, see clixon_hash.c
+# Compile and run a program inserting and looking up similar keys, "key0", "key1",...
+# using clicon_hash_add/clicon_hash_lookup, ie FNV-1a and a table that grows.
+# The same is made with the byte-sum hash and fixed 1031 buckets used before, implemented
+# in the program. Keys of similar strings collided in the byte-sum hash.
+# Print insert and lookup times and the longest bucket chain of each.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of keys of each run
+: ${perfsizes:="10000 100000"}
+
+cfile=$dir/hash-perf.c
+app=$dir/hash-perf
+
+cat<<EOF > $cfile
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <clixon/clixon_queue.h>
+#include <clixon/clixon_hash.h>
+
+#define OLD_HASH_SIZE 1031 /* Buckets of byte-sum hash used before FNV-1a */
+
+struct old_entry {
+    struct old_entry *oe_next;
+    char             *oe_key;
+};
+
+static uint32_t
+old_bucket(const char *str)
+{
+    uint32_t n = 0;
+
+    while (*str)
+        n += (uint32_t)*str++;
+    return n % OLD_HASH_SIZE;
+}
+
+static struct old_entry *
+old_lookup(struct old_entry **tab,
+           const char        *key)
+{
+    struct old_entry *oe;
+
+    for (oe = tab[old_bucket(key)]; oe; oe = oe->oe_next)
+        if (strcmp(oe->oe_key, key) == 0)
+            return oe;
+    return NULL;
+}
+
+static int
+old_add(struct old_entry **tab,
+        const char        *key)
+{
+    struct old_entry *oe;
+    uint32_t          bkt;
+
+    if (old_lookup(tab, key) != NULL)
+        return 0;
+    if ((oe = malloc(sizeof(*oe))) == NULL)
+        return -1;
+    if ((oe->oe_key = strdup(key)) == NULL)
+        return -1;
+    bkt = old_bucket(key);
+    oe->oe_next = tab[bkt];
+    tab[bkt] = oe;
+    return 0;
+}
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int                nr;
+    int                i;
+    char               key[32];
+    struct old_entry **old;
+    clicon_hash_t     *hash;
+    int               *chain;
+    uint32_t           size;
+    int                max;
+    double             t0;
+    double             t1;
+    double             t2;
+
+    if (argc != 2 || (nr = atoi(argv[1])) <= 0){
+        fprintf(stderr, "usage: %s <nr>\n", argv[0]);
+        return -1;
+    }
+    /* Byte-sum hash, fixed number of buckets */
+    if ((old = calloc(OLD_HASH_SIZE, sizeof(*old))) == NULL)
+        return -1;
+    t0 = now();
+    for (i=0; i<nr; i++){
+        snprintf(key, sizeof(key), "key%d", i);
+        if (old_add(old, key) < 0)
+            return -1;
+    }
+    t1 = now();
+    for (i=0; i<nr; i++){
+        snprintf(key, sizeof(key), "key%d", i);
+        if (old_lookup(old, key) == NULL)
+            return -1;
+    }
+    t2 = now();
+    max = 0;
+    for (i=0; i<OLD_HASH_SIZE; i++){
+        struct old_entry *oe;
+        int               n = 0;
+        for (oe = old[i]; oe; oe = oe->oe_next)
+            n++;
+        if (n > max)
+            max = n;
+    }
+    printf("bytesum %d insert: %.3f s lookup: %.3f s maxchain: %d\n", nr, t1-t0, t2-t1, max);
+    /* FNV-1a in clicon_hash */
+    if ((hash = clicon_hash_init()) == NULL)
+        return -1;
+    t0 = now();
+    for (i=0; i<nr; i++){
+        snprintf(key, sizeof(key), "key%d", i);
+        if (clicon_hash_add(hash, key, NULL, 0) == NULL)
+            return -1;
+    }
+    t1 = now();
+    for (i=0; i<nr; i++){
+        snprintf(key, sizeof(key), "key%d", i);
+        if (clicon_hash_lookup(hash, key) == NULL)
+            return -1;
+    }
+    t2 = now();
+    clicon_hash_free(hash);
+    /* Same table size as clicon_hash, which doubles when entries exceed buckets */
+    size = 64;
+    while (size < (uint32_t)nr)
+        size *= 2;
+    if ((chain = calloc(size, sizeof(*chain))) == NULL)
+        return -1;
+    max = 0;
+    for (i=0; i<nr; i++){
+        snprintf(key, sizeof(key), "key%d", i);
+        if (++chain[clicon_hash_fnv1a(key) & (size-1)] > max)
+            max++;
+    }
+    printf("fnv1a %d insert: %.3f s lookup: %.3f s maxchain: %d\n", nr, t1-t0, t2-t1, max);
+    return 0;
+}
+EOF
+
+new "compile $cfile -> $app"
+if [ "$LINKAGE" = static ]; then
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app /usr/local/lib/libclixon${LIBSTATIC_SUFFIX} ${LIBS}"
+else
+    COMPILE="$CC ${CFLAGS} -I/usr/local/include $cfile -o $app -L /usr/local/lib -lclixon"
+fi
+echo "COMPILE:$COMPILE"
+expectpart "$($COMPILE)" 0 ""
+
+for nr in $perfsizes; do
+    new "hash insert and lookup of $nr keys"
+    ret=$($app $nr)
+    r=$?
+    if [ $r -ne 0 ]; then
+        err "0" "$r"
+    fi
+    echo "$ret"
+    # Longest chain of FNV-1a is small, of byte-sum it grows with the number of keys
+    max=$(echo "$ret" | awk '/^fnv1a/ {print $NF}')
+    if [ "$max" -gt 16 ]; then
+        err "fnv1a maxchain at most 16" "$max"
+    fi
+    max=$(echo "$ret" | awk '/^bytesum/ {print $NF}')
+    if [ "$max" -lt $((nr/100)) ]; then
+        err "bytesum maxchain at least $((nr/100))" "$max"
+    fi
+done
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,141 @@
+#!/usr/bin/env bash
+# Scaling/ performance tests of leafref validation
+# Number of leafref targets and number of references are scaled independently
+# Both absolute and relative leafref paths are tested
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of leafref target entries
+: ${perftargets:=10000}
+
+# Number of leafref referencing entries
+: ${perfrefs:=10000}
+
+: ${TIMEFN:=time -p} # portability: 2>&1 | awk '/real/ {print $2}'
+if ! $TIMEFN true; then err "A working time function" "'$TIMEFN' does not work"; fi
+
+APPNAME=example
+
+cfg=$dir/perf-leafref-conf.xml
+fyang=$dir/leafref.yang
+fconfigonly=$dir/config.xml
+fconfig=$dir/large.xml
+
+cat <<EOF > $fyang
+module leafref{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list target {
+      key "name";
+      leaf name {
+        type string;
+      }
+    }
+    list absref {
+      key "id";
+      leaf id {
+        type int32;
+      }
+      leaf ref {
+        type leafref {
+          path "/ex:x/ex:target/ex:name";
+        }
+      }
+    }
+    list relref {
+      key "id";
+      leaf id {
+        type int32;
+      }
+      leaf ref {
+        type leafref {
+          path "../../target/name";
+        }
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "generate config with $perftargets targets and $perfrefs references"
+echo -n "<x xmlns=\"urn:example:clixon\">" > $fconfigonly
+for (( i=0; i<$perftargets; i++ )); do
+    echo -n "<target><name>t$i</name></target>" >> $fconfigonly
+done
+for (( i=0; i<$perfrefs; i++ )); do
+    echo -n "<absref><id>$i</id><ref>t$(( i % $perftargets ))</ref></absref>" >> $fconfigonly
+    echo -n "<relref><id>$i</id><ref>t$(( i % $perftargets ))</ref></relref>" >> $fconfigonly
+done
+echo -n "</x>" >> $fconfigonly # No CR
+
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>"
+rpc+="$(cat $fconfigonly)"
+rpc+="</config></edit-config></rpc>"
+
+echo -n "$DEFAULTHELLO" > $fconfig
+echo "$(chunked_framing "$rpc")" >> $fconfig
+
+new "netconf write large config"
+expecteof_file "$TIMEFN $clixon_netconf -qef $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>$" 2>&1 | awk '/real/ {print $2}'
+
+new "netconf validate large config"
+expecteof_netconf "$TIMEFN $clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>" 2>&1 | awk '/real/ {print $2}'
+
+new "netconf commit large config"
+expecteof_netconf "$TIMEFN $clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>" 2>&1 | awk '/real/ {print $2}'
+
+new "netconf add dangling reference"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><absref><id>$perfrefs</id><ref>none</ref></absref></x></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate dangling reference fails"
+expecteof_netconf "$TIMEFN $clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>data-missing</error-tag><error-app-tag>instance-required</error-app-tag>" 2>&1 | awk '/real/ {print $2}'
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -1,13 +1,21 @@
 #!/usr/bin/env bash
-# Backend Memory tests of config data, footprint using the clixon-conf state statistics
-# Create a large datastore, load it and measure
-# Baseline: (thinkpad laptop) running db:
-# 100K objects: 500K   mem: 74M
-# 1M   objects: 5M     mem: 747M
+# Backend memory test of config data, measured as resident memory of the backend process
+# Start the backend with an empty startup datastore, then with a large one, and print the
+# difference in resident memory (VmRSS) per XML object.
+# Compare XML object layouts by running with a clixon built with and without slab
+# allocation, see ./configure --disable-xml-slab
+# Linux only, since /proc/<pid>/status is read
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
 
+# Skip it if no /proc, eg not Linux
+if [ ! -f /proc/self/status ]; then
+    echo "...no /proc/<pid>/status"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
 # Enable this for massif memory profiling
 #clixon_backend="valgrind --tool=massif clixon_backend"
 
@@ -63,6 +71,7 @@ EOF
 # Test function
 # Arguments:
 # 1: nr   size of large list
+# Sets rss to resident memory of backend in kB and objects to number of XML objects
 function testrun(){
     nr=$1
 
@@ -93,7 +102,6 @@ function testrun(){
     new "netconf get stats"
     rpc=$(chunked_framing "<rpc $DEFAULTNS><stats $LIBNS><modules>true</modules></stats></rpc>")
     res=$(echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qef $cfg)
-#    echo "res:$res"
     err0=$(echo "$res" | $clixon_util_xpath -p "/rpc-reply/rpc-error")
     err=${err0#"nodeset:"}
     if [ -n "$err" ]; then
@@ -101,28 +109,13 @@ function testrun(){
     fi
     objects=$(echo "$res" | $clixon_util_xpath -p "/rpc-reply/global/xmlnr" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}')
 
-    echo "Total"
-    echo "   objects: $objects"
-
-#
-    if [ -f /proc/$pid/statm ]; then     # This only works on Linux 
-#       cat /proc/$pid/statm
-        echo -n "   /proc/$pid/statm: "
-        cat /proc/$pid/statm|awk '{print $1*4/1000 "M"}'
+    new "backend resident memory"
+    rss=$(awk '/^VmRSS:/ {print $2}' /proc/$pid/status)
+    if [ -z "$rss" ]; then
+        err "VmRSS of backend pid $pid" "$rss"
     fi
-    dbs="running candidate startup";
-    for db in $dbs; do
-        echo "$db"
-        resdb0=$(echo "$res" | $clixon_util_xpath -p "/rpc-reply/datastores/datastore[name=\"$db\"]")
-        resdb=${resdb0#"nodeset:0:"}
-        if [ "$resdb0" = "$resdb" ]; then
-            err1 "nodeset:0:" "$resdb0"
-        fi
-        echo -n "   objects: "
-        echo $resdb | $clixon_util_xpath -p "datastore/nr" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}'
-        echo -n "   mem: "
-        echo $resdb | $clixon_util_xpath -p "datastore/size" | awk -F ">" '{print $2}' | awk -F "<" '{print $1}' | awk '{print $1/1000000 "M"}'
-    done
+    echo "   entries: $1 objects: $objects rss: ${rss}kB"
+
     if [ $BE -ne 0 ]; then
         new "Kill backend"
         # Check if premature kill
@@ -131,59 +124,31 @@ function testrun(){
             err "backend already dead"
         fi
         # kill backend
-
-        new "Zap backend"
         stop_backend -f $cfg
     fi
 }
 
+new "Memory test for backend with 0 entries"
+testrun 0
+rss0=$rss
+objects0=$objects
+
 new "Memory test for backend with $perfnr entries"
 testrun $perfnr
 
+echo "Resident memory of $perfnr entries: $((rss - rss0))kB"
+new "Resident memory grows with $perfnr entries"
+if [ $rss -le $rss0 ]; then
+    err "more than ${rss0}kB" "${rss}kB"
+fi
+if [ -n "$objects" -a -n "$objects0" ] && [ $objects -gt $objects0 ]; then
+    echo "   bytes/object: $(( (rss - rss0) * 1024 / (objects - objects0) ))"
+fi
+
 rm -rf $dir
 
 # unset conditional parameters 
 unset perfnr
 
-if false; then
-# Example memory pretty-printed:
-x:
-  base struct:  104
-  name:         2
-  childvec:     131072
-  (ns-cache:    115) # only in startup?
-  sum:          131178
-xmlns:
-  base struct:  56
-  name:         6
-  value-cb:     38
-  sum:          100
-y:
-  base struct:  104
-  name:         2
-  childvec:     16
-  (ns-cache:     115)  # only in startup?
-  sum:          122
-a:
-  base struct:  104
-  name:         2
-  childvec:     8
-(ns-cache:     115)  # only in startup?
-  value-cv:     72  # Value cached for sorting
-  sum:          186
-body:
-  base struct:  56
-  name:         5
-  value-cb:     4
-  sum:          65
-b:
-  sum:          114
-  base struct:  104
-  name:         2
-  childvec:     8
-  (ns-cache:     115)  # only in startup?
-
-fi
-
 new "endtest"
 endtest
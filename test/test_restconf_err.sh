@@ -322,6 +322,13 @@ EOF
 new "restconf GET failed state"
 expectpart "$(curl $CURLOPTS -X GET -H 'Accept: application/yang-data+xml' $RCPROTO://localhost/restconf/data?content=nonconfig)" 0 "HTTP/$HVER 412" '<errors xmlns="urn:ietf:params:xml:ns:yang:ietf-restconf"><error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-info><bad-element>mystate</bad-element></error-info><error-severity>error</error-severity><error-message>Failed to find YANG spec of XML node: mystate with parent: config in namespace: urn:example:foobar. Internal error, state callback returned invalid XML from plugin: example_backend</error-message></error></errors>'
 
+# JSON is encoded by the backend, an error reply is returned as XML and translated
+new "restconf GET failed state JSON"
+expectpart "$(curl $CURLOPTS -X GET -H 'Accept: application/yang-data+json' $RCPROTO://localhost/restconf/data?content=nonconfig)" 0 "HTTP/$HVER 412" '{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"operation-failed","error-info":{"bad-element":"mystate"},"error-severity":"error","error-message":"Failed to find YANG spec of XML node: mystate with parent: config in namespace: urn:example:foobar. Internal error, state callback returned invalid XML from plugin: example_backend"}}}'
+
+new "restconf GET config JSON after failed state"
+expectpart "$(curl $CURLOPTS -X GET -H 'Accept: application/yang-data+json' $RCPROTO://localhost/restconf/data/example:a=0?content=config)" 0 "HTTP/$HVER 200" '{"example:a":\[{"k":"0","description":"No leaf b, No container c, No leaf d"}\]}'
+
 # Add error XML a[4242] , it should fail on autocommit but may not be discarded, therefore still
 # there in candidate when want to add something else
 new "Add user-invalid entry (should fail)"
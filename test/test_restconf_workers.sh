@@ -0,0 +1,152 @@
+#!/usr/bin/env bash
+# Restconf worker processes, see CLICON_RESTCONF_WORKERS
+# Start native restconf with two workers, check that requests are served, that
+# statistics are logged on SIGUSR1, and that a killed worker is restarted
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Workers are only implemented by native restconf
+if [ "${WITH_RESTCONF}" != "native" ]; then
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/restconf.yang
+flog=$dir/restconf.log
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+if [ $? -ne 0 ]; then
+    err1 "Error when generating certs"
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_RESTCONF_WORKERS>2</CLICON_RESTCONF_WORKERS>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+         leaf name{
+            type string;
+         }
+         leaf value{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+# Check that parent restconf process has two workers, sets ppid and workers
+function check_workers()
+{
+    ppid=$(pgrep -o -x clixon_restconf)
+    workers=$(pgrep -P $ppid -x clixon_restconf)
+    nr=$(echo "$workers" | wc -w)
+    if [ $nr -ne 2 ]; then
+        err "2 workers" "$nr"
+    fi
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    sudo pkill -f clixon_backend # to be sure
+
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+# Workers are checked by process, restconf must be started here
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg -l f$flog
+
+    new "wait restconf"
+    wait_restconf
+
+    new "restconf has 2 workers"
+    check_workers
+
+    new "restconf POST"
+    expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"example:parameter":[{"name":"A","value":"42"}]}' $RCPROTO://localhost/restconf/data/example:table)" 0 "HTTP/$HVER 201"
+
+    new "concurrent restconf GETs"
+    for i in $(seq 1 20); do
+        curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table/parameter=A > $dir/get$i.out &
+    done
+    wait
+    for i in $(seq 1 20); do
+        expectpart "$(cat $dir/get$i.out)" 0 "HTTP/$HVER 200" '{"example:parameter":\[{"name":"A","value":"42"}\]}'
+    done
+
+    new "SIGUSR1 logs worker statistics"
+    sudo kill -USR1 $ppid
+    sleep $DEMSLEEP
+    expectpart "$(sudo cat $flog)" 0 "worker 0 pid [0-9]*: connections: [0-9]* requests: [0-9]*" "worker 1 pid [0-9]*: connections: [0-9]* requests: [0-9]*"
+
+    new "kill worker"
+    wpid=$(echo $workers | awk '{print $1}')
+    sudo kill -9 $wpid
+    sleep 2
+
+    new "killed worker restarted with backoff"
+    expectpart "$(sudo cat $flog)" 0 "pid $wpid exited with status [0-9]*, restarting in 1 s"
+    check_workers
+    if echo "$workers" | grep -q "^$wpid$"; then
+        err "new worker" "$wpid"
+    fi
+
+    new "restconf GET after restart"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/example:table/parameter=A)" 0 "HTTP/$HVER 200" '{"example:parameter":\[{"name":"A","value":"42"}\]}'
+
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
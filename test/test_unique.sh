@@ -6,6 +6,7 @@
 # to fail it and then del to pass it.
 # Then makes a fail / pass test on the single field case
 # Last, a complex unsorted list with several sub-elements.
+# Also incremental unique validation of commits with an invalid running.
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -201,6 +202,28 @@ expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS>
      </server>
 </c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-app-tag>data-not-unique</error-app-tag><error-severity>error</error-severity><error-info><non-unique xmlns=\"urn:ietf:params:xml:ns:yang:1\">/rpc/edit-config/config/c/server[name=\"smtp\"]/ip</non-unique><non-unique xmlns=\"urn:ietf:params:xml:ns:yang:1\">/rpc/edit-config/config/c/server[name=\"smtp\"]/port</non-unique></error-info></rpc-error></rpc-reply>"
 
+# Commit with changed and unchanged unique lists
+new "Add valid example and commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><default-operation>replace</default-operation><config><c xmlns=\"urn:example:clixon\"><server><name>smtp</name><ip>192.0.2.1</ip><port>25</port></server><server><name>http</name><ip>192.0.2.1</ip><port>80</port></server><single><name>smtp</name><ip>192.0.2.1</ip></single></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "change other list"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><single><name>http</name><ip>192.0.2.2</ip></single></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit unchanged unique list"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "make it invalid by changing port of http entry"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><server><name>http</name><port>25</port></server></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit changed unique list (should fail)"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-app-tag>data-not-unique</error-app-tag><error-severity>error</error-severity><error-info><non-unique xmlns=\"urn:ietf:params:xml:ns:yang:1\">/c/server[name=\"smtp\"]/ip</non-unique><non-unique xmlns=\"urn:ietf:params:xml:ns:yang:1\">/c/server[name=\"smtp\"]/port</non-unique></error-info></rpc-error></rpc-reply>"
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
 if [ $BE -ne 0 ]; then
     new "Kill backend"
     # Check if premature kill
@@ -212,6 +235,84 @@ if [ $BE -ne 0 ]; then
     stop_backend -f $cfg
 fi
 
+# Incremental unique validation, see CLICON_VALIDATE_UNIQUE_INCREMENTAL
+# Running is loaded without validation using startup mode none, with a server list that
+# is not unique. Only commits changing the server list detect it in incremental mode.
+cfgi=$dir/conf_incr.xml
+cat <<EOF > $cfgi
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfgi</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_VALIDATE_UNIQUE_INCREMENTAL>true</CLICON_VALIDATE_UNIQUE_INCREMENTAL>
+</clixon-config>
+EOF
+
+rdb="<c xmlns=\"urn:example:clixon\"><server><name>smtp</name><ip>192.0.2.1</ip><port>25</port></server><server><name>http</name><ip>192.0.2.1</ip><port>25</port></server><single><name>smtp</name><ip>192.0.2.1</ip></single></c>"
+
+# Arguments:
+# 1: incremental true or false
+# 2: expected result of commit changing other list: ok or fail
+function testincr(){
+    incr=$1
+    expect=$2
+
+    sudo rm -f $dir/*_db
+    echo "<${DATASTORE_TOP}>$rdb</${DATASTORE_TOP}>" > $dir/running_db
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfgi
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s none -f $cfgi -o CLICON_VALIDATE_UNIQUE_INCREMENTAL=$incr"
+        start_backend -s none -f $cfgi -o CLICON_VALIDATE_UNIQUE_INCREMENTAL=$incr
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "incremental $incr: change other list"
+    expecteof_netconf "$clixon_netconf -qf $cfgi" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><single><name>http</name><ip>192.0.2.2</ip></single></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    if [ $expect = ok ]; then
+        new "incremental $incr: commit unchanged invalid server list"
+        expecteof_netconf "$clixon_netconf -qf $cfgi" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+    else
+        new "incremental $incr: commit unchanged invalid server list (should fail)"
+        expecteof_netconf "$clixon_netconf -qf $cfgi" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-app-tag>data-not-unique</error-app-tag><error-severity>error</error-severity><error-info><non-unique xmlns=\"urn:ietf:params:xml:ns:yang:1\">/c/server[name=\"smtp\"]/ip</non-unique><non-unique xmlns=\"urn:ietf:params:xml:ns:yang:1\">/c/server[name=\"smtp\"]/port</non-unique></error-info></rpc-error></rpc-reply>"
+
+        new "incremental $incr: discard-changes"
+        expecteof_netconf "$clixon_netconf -qf $cfgi" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+    fi
+
+    new "incremental $incr: add server entry"
+    expecteof_netconf "$clixon_netconf -qf $cfgi" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><server><name>ftp</name><ip>192.0.2.3</ip><port>21</port></server></c></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "incremental $incr: commit changed invalid server list (should fail)"
+    expecteof_netconf "$clixon_netconf -qf $cfgi" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-app-tag>data-not-unique</error-app-tag><error-severity>error</error-severity><error-info><non-unique xmlns=\"urn:ietf:params:xml:ns:yang:1\">/c/server[name=\"smtp\"]/ip</non-unique><non-unique xmlns=\"urn:ietf:params:xml:ns:yang:1\">/c/server[name=\"smtp\"]/port</non-unique></error-info></rpc-error></rpc-reply>"
+
+    new "incremental $incr: discard-changes"
+    expecteof_netconf "$clixon_netconf -qf $cfgi" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfgi
+    fi
+}
+
+testincr true ok
+testincr false fail
+
 rm -rf $dir
 
 new "endtest"
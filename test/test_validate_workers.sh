@@ -0,0 +1,115 @@
+#!/usr/bin/env bash
+# Parallel validation of top-level subtrees, see CLICON_VALIDATE_WORKERS
+# Check that validation and commit succeed, and that the error returned when several
+# subtrees fail is the same as with sequential validation, ie the first in tree order
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/test.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_VALIDATE_WORKERS>3</CLICON_VALIDATE_WORKERS>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  grouping g{
+    leaf-list a{
+      type string;
+      min-elements 1;
+    }
+    leaf b{
+      type string;
+    }
+  }
+  container c1{
+    presence true;
+    uses g;
+  }
+  container c2{
+    presence true;
+    uses g;
+  }
+  container c3{
+    presence true;
+    uses g;
+  }
+  container c4{
+    presence true;
+    uses g;
+  }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Add valid config in four subtrees"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c1 xmlns=\"urn:example:clixon\"><a>1</a></c1><c2 xmlns=\"urn:example:clixon\"><a>2</a></c2><c3 xmlns=\"urn:example:clixon\"><a>3</a></c3><c4 xmlns=\"urn:example:clixon\"><a>4</a></c4></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Validate ok"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Commit ok"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Make c4 invalid"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><default-operation>replace</default-operation><config><c1 xmlns=\"urn:example:clixon\"><a>1</a></c1><c2 xmlns=\"urn:example:clixon\"><a>2</a></c2><c3 xmlns=\"urn:example:clixon\"><a>3</a></c3><c4 xmlns=\"urn:example:clixon\"><b>4</b></c4></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Validate fails on c4"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>protocol</error-type><error-tag>operation-failed</error-tag><error-app-tag>too-few-elements</error-app-tag><error-severity>error</error-severity><error-path>/c4/a</error-path></rpc-error></rpc-reply>"
+
+new "Make c2 and c4 invalid"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><default-operation>replace</default-operation><config><c1 xmlns=\"urn:example:clixon\"><a>1</a></c1><c2 xmlns=\"urn:example:clixon\"><b>2</b></c2><c3 xmlns=\"urn:example:clixon\"><a>3</a></c3><c4 xmlns=\"urn:example:clixon\"><b>4</b></c4></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Commit fails on c2"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>protocol</error-type><error-tag>operation-failed</error-tag><error-app-tag>too-few-elements</error-app-tag><error-severity>error</error-severity><error-path>/c2/a</error-path></rpc-error></rpc-reply>"
+
+new "Discard changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Check running"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><c1 xmlns=\"urn:example:clixon\"><a>1</a></c1><c2 xmlns=\"urn:example:clixon\"><a>2</a></c2><c3 xmlns=\"urn:example:clixon\"><a>3</a></c3><c4 xmlns=\"urn:example:clixon\"><a>4</a></c4></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -35,7 +35,9 @@ expecteof "$clixon_util_xml -o" 255 "<a%/>" ""
 LF='
 '
 new "xml parse content with CR LF -> LF, CR->LF (see https://www.w3.org/TR/REC-xml/#sec-line-ends)"
-ret=$(echo "<x>ab${LF}c${LF}d</x>" | $clixon_util_xml -o)
+ret=$(echo "<x>a
+b${LF}c
+${LF}d</x>" | $clixon_util_xml -o)
 if [ "$ret" != "<x>a${LF}b${LF}c${LF}d</x>" ]; then
      err '<x>a$LFb$LFc</x>' "$ret"
 fi
@@ -225,6 +227,18 @@ EOF
 new "utf-8 string"
 expecteof "$clixon_util_xml -o" 0 "$XML" "^ruled over the shores of the Hreiðsea$"
 
+# Parse errors from file: the partial tree must be freed and an error returned
+fxml=$dir/malformed.xml
+echo "<a><b>x</c></a>" > $fxml
+
+new "xml parse malformed file, mismatched tags"
+expectpart "$($clixon_util_xml -o -f $fxml 2>&1)" 255 "Sanity check failed"
+
+echo -n "<a><b>x</b><c><d>" > $fxml
+
+new "xml parse malformed file, truncated"
+expectpart "$($clixon_util_xml -o -f $fxml 2>&1)" 255 --not-- "Aborted" "free()"
+
 rm -rf $dir
 
 new "endtest"
@@ -0,0 +1,211 @@
+#!/usr/bin/env bash
+# YANG parse-tree cache: CLICON_YANG_CACHE_DIR
+# Verify that a spec loaded from cache is equal to a fresh parse, both as shown and
+# as parse tree including line numbers and extension arguments, that cache files
+# are created, that a changed YANG file invalidates its cache entry, and that netconf
+# sessions and a restarted backend work with a spec loaded from cache
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+cfgnc=$dir/conf_nocache.xml
+fyang=$dir/example.yang
+cachedir=$dir/cache
+
+test -d $cachedir || mkdir $cachedir
+rm -f $cachedir/*
+
+# Common options for both configs
+cat <<EOF > $dir/opts.xml
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_CLISPEC_DIR>$dir</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_SOCK>/usr/local/var/run/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/run/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+$(cat $dir/opts.xml)
+  <CLICON_YANG_CACHE_DIR>$cachedir</CLICON_YANG_CACHE_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $cfgnc
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfgnc</CLICON_CONFIGFILE>
+$(cat $dir/opts.xml)
+</clixon-config>
+EOF
+
+# Exercise grouping/uses, augment, extensions, revisions and typed arguments
+cat <<EOF > $fyang
+module example {
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  import clixon-autocli{
+      prefix autocli;
+  }
+  revision 2025-05-01 {
+     description "Cache test";
+  }
+  grouping pg {
+     leaf value {
+        description "a value";
+        type string;
+     }
+  }
+  container table {
+     list parameter {
+        key name;
+        min-elements 1;
+        max-elements 64;
+        leaf name {
+           type string;
+        }
+        uses pg;
+        leaf count {
+           autocli:alias "cnt";
+           type uint32 {
+              range "1..100";
+           }
+           default 42;
+        }
+     }
+  }
+  augment "/ex:table" {
+     leaf extra {
+        autocli:hide;
+        type int8;
+     }
+  }
+}
+EOF
+
+cat <<EOF > $dir/example.cli
+CLICON_MODE="example";
+CLICON_PROMPT="%U@%H %W> ";
+
+set @datamodel, cli_set();
+show("Show a particular state of the system"){
+    yang("Show yang specs"), show_yang(); {
+        example("Show example yang spec"), show_yang("example");
+    }
+}
+EOF
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "Backend created cache files"
+if [ -z "$(ls $cachedir)" ]; then
+    if [ $BE -ne 0 ]; then
+        err "cache files in $cachedir" "none"
+    fi
+fi
+
+new "show yang without cache"
+ref=$($clixon_cli -1f $cfgnc show yang)
+expectpart "$ref" 0 "module example" "max-elements 64" "uses pg" "autocli:hide"
+
+new "generated cli without cache"
+refg=$($clixon_cli -f $cfgnc -G -1 2>&1)
+expectpart "$refg" 0 "value"
+
+new "show yang, first run with cache"
+ret=$($clixon_cli -1f $cfg show yang)
+if [ "$ret" != "$ref" ]; then
+    err "$ref" "$ret"
+fi
+
+new "Cache file for example created"
+if ! ls $cachedir/example.yang-*.cache > /dev/null 2>&1; then
+    err "$cachedir/example.yang-*.cache" "$(ls $cachedir)"
+fi
+
+new "show yang, loaded from cache"
+ret=$($clixon_cli -1f $cfg show yang)
+if [ "$ret" != "$ref" ]; then
+    err "$ref" "$ret"
+fi
+
+new "generated cli, loaded from cache"
+ret=$($clixon_cli -f $cfg -G -1 2>&1)
+if [ "$ret" != "$refg" ]; then
+    err "$refg" "$ret"
+fi
+
+# Parse tree of each (sub)module before grouping and augment expansion, including
+# line numbers, cv:s and extension arguments, see yang_parse_tree_debug
+new "yang parse tree without cache"
+reft=$($clixon_cli -1f $cfgnc -l o -D yang -D detail show yang example 2>&1 | grep -o "yang-tree: .*")
+expectpart "$reft" 0 "yang-tree: module example line:[0-9]* cv::" "yang-tree: *revision 2025-05-01 line:[0-9]* cv:uint32:20250501" "yang-tree: *unknown autocli:alias line:[0-9]* cv:string:cnt" "yang-tree: *unknown autocli:hide line:[0-9]* cv::"
+
+new "yang parse tree loaded from cache equal to parsed tree"
+ret=$($clixon_cli -1f $cfg -l o -D yang -D detail show yang example 2>&1 | grep -o "yang-tree: .*")
+if [ "$ret" != "$reft" ]; then
+    err "$reft" "$ret"
+fi
+
+new "Modify yang"
+sed -i -e 's/max-elements 64/max-elements 65/' $fyang
+
+new "show yang, cache entry invalidated"
+expectpart "$($clixon_cli -1f $cfg show yang example)" 0 "max-elements 65" --not-- "max-elements 64"
+
+new "show yang equal to fresh parse after invalidation"
+ref=$($clixon_cli -1f $cfgnc show yang)
+ret=$($clixon_cli -1f $cfg show yang)
+if [ "$ret" != "$ref" ]; then
+    err "$ref" "$ret"
+fi
+
+new "netconf session with spec loaded from cache"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>x</value></parameter></table></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf get-config from cache-loaded session"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='a']/ex:value\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>x</value></parameter></table></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "restart backend, spec loaded from cache"
+    stop_backend -f $cfg
+    start_backend -s init -f $cfg
+
+    new "wait backend"
+    wait_backend
+
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -5,6 +5,7 @@
 # Also:
 # - keyword with/without string
 # - use grouping
+# - container with many children, see YANG_FIND_INDEX
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = "$0" ]; then exit 0; else return 0; fi
@@ -366,6 +367,98 @@ if [ "$BE" -ne 0 ]; then
     stop_backend -f "$cfg"
 fi
 
+# Statements with more than YANG_FIND_INDEX children are looked up using an index,
+# which is reset when children are inserted by uses and augment or removed by deviations
+new "8. deviations and augment of container with many children"
+
+leaves=""
+for (( i=1; i<=40; i++ )); do
+    leaves+="leaf l$i { type string; } "
+done
+
+cat <<EOF > $fyangbase
+module example-base{
+    yang-version 1.1;
+    prefix base;
+    namespace "urn:example:base";
+    grouping g {
+        leaf g1 {
+            type string;
+        }
+    }
+    container system {
+        $leaves
+        uses g;
+    }
+}
+EOF
+
+cat <<EOF > $fyangdev
+module example-deviations{
+   yang-version 1.1;
+   prefix md;
+   namespace "urn:example:deviations";
+   import example-base {
+         prefix base;
+   }
+   augment /base:system {
+      leaf aug {
+         type string;
+      }
+   }
+   deviation /base:system/base:l20 {
+      deviate not-supported;
+   }
+   deviation /base:system/base:l21 {
+      deviate replace {
+         type int8;
+      }
+   }
+}
+EOF
+
+if [ "$BE" -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf "$cfg"
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f "$cfg"
+fi
+
+new "wait backend"
+wait_backend
+
+new "set first, last, grouping, augmented and replaced leaves"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><system xmlns=\"urn:example:base\"><l1>a</l1><l40>b</l40><g1>c</g1><aug xmlns=\"urn:example:deviations\">d</aug><l21>-7</l21></system></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate ok"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "get leaves"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><system xmlns=\"urn:example:base\"><l1>a</l1><l21>-7</l21><l40>b</l40><g1>c</g1><aug xmlns=\"urn:example:deviations\">d</aug></system></data></rpc-reply>"
+
+new "set not-supported leaf, expect error"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><system xmlns=\"urn:example:base\"><l20>x</l20></system></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>unknown-element</error-tag><error-info><bad-element>l20</bad-element></error-info><error-severity>error</error-severity><error-message>Failed to find YANG spec of XML node: l20 with parent: system in namespace: urn:example:base</error-message></rpc-error></rpc-reply>"
+
+new "set replaced leaf large value"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><system xmlns=\"urn:example:base\"><l21>300</l21></system></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate expect fail"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>l21</bad-element></error-info><error-severity>error</error-severity><error-message>Number 300 out of range: -128 - 127</error-message></rpc-error></rpc-reply>"
+
+if [ "$BE" -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f "$cfg"
+fi
+
 rm -rf "$dir"
 
 new "endtest"